@@ -38,6 +38,11 @@ reconnect_delay = 3  # seconds
 connection_lock = threading.Lock()
 serial_queue = queue.Queue()
 next_detection_id = 1  # Unique ID counter
+# Serial stream position (see SERIAL STREAM in src/main.cpp). Kept across
+# reconnects so a USB drop is resumed from the device's replay ring.
+flock_stream = {'boot': None, 'last': 0, 'pending': {}, 'resume_sent': 0.0}
+STREAM_PENDING_MAX = 256     # Out-of-order records held while a gap is open
+STREAM_RESUME_RETRY = 2.0    # Seconds between RESUME requests for the same gap
 settings = {'gps_port': '', 'flock_port': '', 'filter': 'all'}
 
 # Data storage paths
@@ -245,11 +250,61 @@ def gps_reader():
                 break
         time.sleep(0.1)
 
+def flock_request_resume(ser):
+    """Ask the device to replay every record after the last one delivered"""
+    boot = flock_stream['boot'] or '0'
+    ser.write(f"RESUME {boot} {flock_stream['last']}\n".encode())
+    flock_stream['resume_sent'] = time.time()
+
+def flock_stream_accept(data, ser):
+    """Order and dedupe serial records by (boot, seq).
+
+    Returns the records that are now deliverable, in sequence order. Each
+    seq is delivered at most once; a gap holds later records back and asks
+    the device to replay it. Unnumbered lines (older firmware) pass through.
+    """
+    st = flock_stream
+    if 'resume' in data:
+        info = data['resume']
+        if info.get('boot') != st['boot']:
+            st.update(boot=info.get('boot'), last=0, pending={})
+        if info.get('lost'):
+            print(f"Flock device: {info['lost']} records aged out of the replay buffer")
+        # Anything before 'from' is gone for good - stop waiting for it
+        st['last'] = max(st['last'], info.get('from', 1) - 1)
+    elif 'seq' not in data:
+        return [data]
+    else:
+        if data.get('boot') != st['boot']:
+            # First contact or the unit rebooted: numbering restarts
+            st.update(boot=data.get('boot'), last=0, pending={})
+        seq = data['seq']
+        if seq > st['last']:
+            st['pending'][seq] = data
+
+    for seq in [k for k in st['pending'] if k <= st['last']]:
+        del st['pending'][seq]
+    if len(st['pending']) > STREAM_PENDING_MAX:
+        # Replay never came - accept the gap rather than stall the feed
+        st['last'] = min(st['pending']) - 1
+    out = []
+    while st['last'] + 1 in st['pending']:
+        st['last'] += 1
+        out.append(st['pending'].pop(st['last']))
+    if st['pending'] and time.time() - st['resume_sent'] >= STREAM_RESUME_RETRY:
+        flock_request_resume(ser)
+    return out
+
 def flock_reader():
     """Background thread for reading Flock device data"""
     global flock_serial_connection, flock_device_connected, serial_data_buffer
     
     with app.app_context():
+        # Pick up whatever the device produced while we were away
+        try:
+            flock_request_resume(flock_serial_connection)
+        except Exception as e:
+            print(f"Flock device resume request failed: {e}")
         while flock_device_connected:
             if flock_serial_connection and flock_serial_connection.is_open:
                 try:
@@ -268,27 +323,38 @@ def flock_reader():
                             
                             # Try to parse as detection data
                             try:
-                                data = json.loads(line)
-                                if 'detection_method' in data:
-                                    # Map ESP32 GPS from phone to Flask GPS format
-                                    esp_gps = data.get('gps')
-                                    if esp_gps:
-                                        data['gps'] = {
-                                            'latitude': esp_gps.get('latitude'),
-                                            'longitude': esp_gps.get('longitude'),
-                                            'fix_quality': 1,
-                                            'match_quality': 'esp32_phone_gps',
-                                            'time_diff': 0,
-                                        }
-                                        if esp_gps.get('accuracy') is not None:
-                                            data['gps']['accuracy'] = esp_gps['accuracy']
-                                    # This is a detection, add it
-                                    add_detection_from_serial(data)
-                                else:
-                                    print(f"JSON data without detection_method: {data}")
+                                records = flock_stream_accept(json.loads(line), flock_serial_connection)
+                                for data in records:
+                                    if data.get('lost'):
+                                        print(f"Flock device: record {data.get('seq')} was not retained")
+                                    elif 'event' in data:
+                                        # Presence: a device entered or left range
+                                        safe_socket_emit('flock_presence', data)
+                                        print(f"Flock device: {data.get('mac_address')} {data['event']}")
+                                    elif 'detection_method' in data:
+                                        # Map ESP32 GPS from phone to Flask GPS format
+                                        esp_gps = data.get('gps')
+                                        if esp_gps:
+                                            data['gps'] = {
+                                                'latitude': esp_gps.get('latitude'),
+                                                'longitude': esp_gps.get('longitude'),
+                                                'fix_quality': 1,
+                                                'match_quality': 'esp32_phone_gps',
+                                                'time_diff': 0,
+                                            }
+                                            if esp_gps.get('accuracy') is not None:
+                                                data['gps']['accuracy'] = esp_gps['accuracy']
+                                        # This is a detection, add it
+                                        add_detection_from_serial(data)
+                                    else:
+                                        print(f"JSON data without detection_method: {data}")
                             except json.JSONDecodeError:
                                 # Not JSON, just log it
                                 print(f"Flock device (non-JSON): {line}")
+                    elif (flock_stream['pending'] and
+                          time.time() - flock_stream['resume_sent'] >= STREAM_RESUME_RETRY):
+                        # Line went quiet with a gap still open - ask again
+                        flock_request_resume(flock_serial_connection)
                                 
                 except Exception as e:
                     print(f"Flock device read error: {e}")
@@ -0,0 +1,309 @@
+"""
+Reference codec for the Flock-You compact binary export (FYDB).
+
+The ESP32 serves this format at /api/export/bin; the layout is documented in
+src/fy_binexport.h. decode() returns the same record dicts as the device's
+JSON export (/api/export/json), so either can be fed to the Flask importer.
+
+Usage:
+    python fybin.py decode flockyou_detections.fyb        # -> JSON on stdout
+    python fybin.py bench flockyou_detections.json         # round-trip + size/speed
+    python fybin.py bench --synthetic 2000                 # same, generated table
+
+bench also builds tools/fybin_encode.cpp (the firmware's FYBinEncoder from
+src/fy_binexport.h) with the host C++ compiler ($CXX, default g++), encodes
+the same records with it and decodes that output. The export speed figures
+come from the same tool: FYBinEncoder against the firmware's JSON writer
+(FYWriter, src/fy_serialize.h) over the same rows, both compiled C++.
+The Python timings cover the consumer side only (json.loads vs decode()).
+Without a compiler the C++ check and the export timings are reported as
+skipped.
+"""
+import json
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+MAGIC = b'FYDB'
+VERSION = 1
+FLAG_RAVEN = 0x01
+FLAG_GPS = 0x02
+
+
+class FYBError(ValueError):
+    pass
+
+
+def _read_varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        if pos >= len(buf):
+            raise FYBError('truncated varint')
+        b = buf[pos]
+        pos += 1
+        result |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return result, pos
+        shift += 7
+        if shift > 35:
+            raise FYBError('varint too long')
+
+
+def _put_varint(out, v):
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+
+
+def decode(data):
+    """Decode an FYDB blob -> (header dict, list of detection dicts)"""
+    buf = memoryview(data)
+    if bytes(buf[:4]) != MAGIC:
+        raise FYBError('bad magic')
+    version = buf[4]
+    if version != VERSION:
+        raise FYBError(f'unsupported version {version}')
+    pos = 6
+    uptime, pos = _read_varint(buf, pos)
+    nstr, pos = _read_varint(buf, pos)
+    strings = []
+    for _ in range(nstr):
+        n, pos = _read_varint(buf, pos)
+        strings.append(bytes(buf[pos:pos + n]).decode('utf-8', errors='replace'))
+        pos += n
+    nrec, pos = _read_varint(buf, pos)
+
+    records = []
+    for _ in range(nrec):
+        if pos + 8 > len(buf):
+            raise FYBError('truncated record')
+        mac = ':'.join(f'{b:02x}' for b in buf[pos:pos + 6])
+        flags = buf[pos + 6]
+        rssi = struct.unpack_from('<b', buf, pos + 7)[0]
+        pos += 8
+        method, pos = _read_varint(buf, pos)
+        name, pos = _read_varint(buf, pos)
+        fw, pos = _read_varint(buf, pos)
+        first, pos = _read_varint(buf, pos)
+        span, pos = _read_varint(buf, pos)
+        count, pos = _read_varint(buf, pos)
+        rec = {
+            'mac': mac,
+            'name': strings[name - 1] if name else '',
+            'rssi': rssi,
+            'method': strings[method] if method < len(strings) else '',
+            'first': first,
+            'last': first + span,
+            'count': count,
+            'raven': bool(flags & FLAG_RAVEN),
+            'fw': strings[fw - 1] if fw else '',
+        }
+        if flags & FLAG_GPS:
+            lat, lon, acc = struct.unpack_from('<iiH', buf, pos)
+            pos += 10
+            rec['gps'] = {'lat': lat / 1e7, 'lon': lon / 1e7, 'acc': acc / 10.0}
+        records.append(rec)
+    return {'version': version, 'uptime': uptime}, records
+
+
+def encode(records, uptime=0):
+    """Reference encoder (mirrors FYBinEncoder as FYBinGen drives it) for round-trip checks"""
+    strings = []
+    index = {}
+
+    def intern(s):
+        if not s:
+            return -1
+        if s not in index:
+            index[s] = len(strings)
+            strings.append(s)
+        return index[s]
+
+    # Methods first, as the firmware interns them
+    for r in records:
+        if intern(r.get('method', '')) < 0:
+            raise FYBError('record without a method')
+    for r in records:
+        intern(r.get('name', ''))
+        intern(r.get('fw', ''))
+
+    out = bytearray(MAGIC)
+    out += bytes([VERSION, 0])
+    _put_varint(out, uptime)
+    _put_varint(out, len(strings))
+    for s in strings:
+        raw = s.encode('utf-8')
+        _put_varint(out, len(raw))
+        out += raw
+    _put_varint(out, len(records))
+    for r in records:
+        out += bytes(int(x, 16) for x in r['mac'].split(':'))
+        gps = r.get('gps')
+        out.append((FLAG_RAVEN if r.get('raven') else 0) | (FLAG_GPS if gps else 0))
+        out += struct.pack('<b', max(-128, min(127, int(r.get('rssi', 0)))))
+        _put_varint(out, max(0, intern(r.get('method', ''))))
+        _put_varint(out, intern(r.get('name', '')) + 1)
+        _put_varint(out, intern(r.get('fw', '')) + 1)
+        _put_varint(out, int(r.get('first', 0)))
+        _put_varint(out, int(r.get('last', 0)) - int(r.get('first', 0)))
+        _put_varint(out, max(0, int(r.get('count', 0))))
+        if gps:
+            acc = min(65535, max(0, int(round(gps.get('acc', 0) * 10))))
+            out += struct.pack('<iiH', round(gps['lat'] * 1e7), round(gps['lon'] * 1e7), acc)
+    return bytes(out)
+
+
+def to_device_json(records):
+    """Format records exactly like the firmware's writeDetectionsJSON"""
+    parts = []
+    for r in records:
+        s = ('{"mac":"%s","name":"%s","rssi":%d,"method":"%s","first":%d,"last":%d,'
+             '"count":%d,"raven":%s,"fw":"%s"' % (
+                 r['mac'], r['name'], r['rssi'], r['method'], r['first'], r['last'],
+                 r['count'], 'true' if r['raven'] else 'false', r['fw']))
+        if r.get('gps'):
+            g = r['gps']
+            s += ',"gps":{"lat":%.8f,"lon":%.8f,"acc":%.1f}' % (g['lat'], g['lon'], g['acc'])
+        parts.append(s + '}')
+    return '[' + ','.join(parts) + ']'
+
+
+def synthetic_records(n, seed=1):
+    rng = random.Random(seed)
+    names = ['FS Ext Battery', 'Penguin-1234', 'Flock-7F68FF', 'Pigvision', '']
+    methods = ['mac_prefix', 'device_name', 'ble_mfr_id', 'raven_uuid']
+    out = []
+    for i in range(n):
+        raven = rng.random() < 0.1
+        first = rng.randrange(0, 3_600_000)
+        rec = {
+            'mac': ':'.join(f'{rng.randrange(256):02x}' for _ in range(6)),
+            'name': rng.choice(names), 'rssi': rng.randrange(-100, -30),
+            'method': 'raven_uuid' if raven else rng.choice(methods[:3]),
+            'first': first, 'last': first + rng.randrange(0, 600_000),
+            'count': rng.randrange(1, 500), 'raven': raven,
+            'fw': rng.choice(['1.1.x', '1.2.x', '1.3.x']) if raven else '',
+        }
+        if rng.random() < 0.8:
+            rec['gps'] = {'lat': round(rng.uniform(25, 48), 7), 'lon': round(rng.uniform(-124, -67), 7),
+                          'acc': round(rng.uniform(3, 60), 1)}
+        out.append(rec)
+    return out
+
+
+def _same(a, b):
+    for k in ('mac', 'name', 'rssi', 'method', 'first', 'last', 'count', 'raven', 'fw'):
+        if a.get(k) != b.get(k):
+            return False
+    ga, gb = a.get('gps'), b.get('gps')
+    if bool(ga) != bool(gb):
+        return False
+    if ga:
+        return (abs(ga['lat'] - gb['lat']) < 1e-7 and abs(ga['lon'] - gb['lon']) < 1e-7
+                and abs(ga['acc'] - gb['acc']) < 0.051)
+    return True
+
+
+def _best_of(fn, runs=5):
+    best = float('inf')
+    for _ in range(runs):
+        t0 = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - t0)
+    return best * 1000.0
+
+
+def _fixture(records, uptime):
+    """tools/fybin_encode.cpp input: tab-separated, strings hex-encoded"""
+    lines = [f'U {uptime}']
+    for r in records:
+        gps = r.get('gps') or {}
+        lines.append('\t'.join([
+            r['mac'], r.get('name', '').encode().hex(), str(int(r.get('rssi', 0))),
+            r.get('method', '').encode().hex(), str(int(r.get('first', 0))),
+            str(int(r.get('last', 0))), str(int(r.get('count', 0))),
+            '1' if r.get('raven') else '0', r.get('fw', '').encode().hex(),
+            '1' if gps else '0', repr(gps.get('lat', 0.0)), repr(gps.get('lon', 0.0)),
+            repr(gps.get('acc', 0.0))]))
+    return ('\n'.join(lines) + '\n').encode()
+
+
+def cpp_encode(records, uptime=0):
+    """Run tools/fybin_encode.cpp over records: (.fyb bytes, export timing
+    dict from -b). None if no host compiler."""
+    cxx = os.environ.get('CXX', 'g++')
+    if not shutil.which(cxx):
+        return None
+    fixture = _fixture(records, uptime)
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, 'fybin_encode')
+        subprocess.run([cxx, '-std=gnu++11', '-O2', '-Wall', '-Wextra',
+                        '-I', os.path.join(REPO, 'src'),
+                        os.path.join(REPO, 'tools', 'fybin_encode.cpp'), '-o', exe], check=True)
+        run = subprocess.run([exe], input=fixture, stdout=subprocess.PIPE, check=True)
+        timing = subprocess.run([exe, '-b'], input=fixture, stdout=subprocess.PIPE, check=True)
+        return run.stdout, json.loads(timing.stdout)
+
+
+def bench(records):
+    """Round-trip check plus size/speed comparison against the JSON export"""
+    js = to_device_json(records).encode('utf-8')
+    fyb = encode(records)
+    _, back = decode(fyb)
+    ok = len(back) == len(records) and all(_same(a, b) for a, b in zip(records, back))
+    cpp, timing = cpp_encode(records) or (None, None)
+    if cpp is not None:
+        _, cback = decode(cpp)
+        cpp_ok = len(cback) == len(records) and all(_same(a, b) for a, b in zip(records, cback))
+    result = {
+        'records': len(records),
+        'roundtrip_ok': ok,
+        # None = skipped (no host compiler)
+        'cpp_roundtrip_ok': None if cpp is None else cpp_ok,
+        'cpp_matches_reference': None if cpp is None else cpp == fyb,
+        'json_bytes': len(js),
+        'fydb_bytes': len(fyb),
+        'size_ratio': round(len(fyb) / len(js), 3) if js else None,
+        # Firmware export cost, FYWriter JSON vs FYBinEncoder (C++, host)
+        'device_json_bytes': None if timing is None else timing['json_bytes'],
+        'device_json_encode_us': None if timing is None else timing['json_encode_us'],
+        'device_fydb_encode_us': None if timing is None else timing['fydb_encode_us'],
+        # Consumer side (Python): C json module vs the pure-Python decoder
+        'json_parse_ms': round(_best_of(lambda: json.loads(js)), 3),
+        'fydb_decode_ms': round(_best_of(lambda: decode(fyb)), 3),
+    }
+    return result
+
+
+def main(argv):
+    if len(argv) >= 2 and argv[0] == 'decode':
+        with open(argv[1], 'rb') as f:
+            header, records = decode(f.read())
+        json.dump(records, sys.stdout, indent=2)
+        print()
+        return 0
+    if len(argv) >= 2 and argv[0] == 'bench':
+        if argv[1] == '--synthetic':
+            records = synthetic_records(int(argv[2]) if len(argv) > 2 else 200)
+        else:
+            with open(argv[1]) as f:
+                records = json.load(f)
+        result = bench(records)
+        print(json.dumps(result, indent=2))
+        ok = result['roundtrip_ok'] and result['cpp_roundtrip_ok'] is not False
+        return 0 if ok and result['cpp_matches_reference'] is not False else 1
+    print(__doc__)
+    return 2
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
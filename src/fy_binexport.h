@@ -0,0 +1,227 @@
+// ============================================================================
+// FLOCK-YOU: Compact binary detection export (FYDB)
+// ============================================================================
+// Versioned, compact alternative to the JSON/CSV/KML exports. Produced by a
+// streaming encoder that writes each record straight into the response sink
+// (anything with write(const uint8_t*, size_t) - AsyncResponseStream, File,
+// Serial). Reference decoder: api/fybin.py
+//
+// Layout (all multi-byte integers little-endian, "varint" = unsigned LEB128):
+//
+//   Header
+//     char[4]  magic "FYDB"
+//     u8       version (FYB_VERSION)
+//     u8       flags (reserved, 0)
+//     varint   device uptime at export (ms) - reference for first/last
+//     varint   string count N
+//     N x      varint length + UTF-8 bytes (no terminator)
+//     varint   record count M
+//
+//   Record (M times)
+//     u8[6]    MAC, packed
+//     u8       flags: bit0 = Raven, bit1 = GPS present
+//     i8       RSSI (dBm)
+//     varint   method   (string index)
+//     varint   name     (string index + 1, 0 = none)
+//     varint   raven fw (string index + 1, 0 = none)
+//     varint   firstSeen (ms uptime)
+//     varint   lastSeen - firstSeen (ms)
+//     varint   count
+//     if GPS:
+//       i32    latitude  * 1e7
+//       i32    longitude * 1e7
+//       u16    accuracy in decimetres (saturates at 65535)
+//
+// Strings are deduplicated, so repeated names ("FS Ext Battery") and the
+// handful of method / firmware strings cost one table entry each.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define FYB_MAGIC        "FYDB"
+#define FYB_VERSION      1
+#define FYB_FLAG_RAVEN   0x01
+#define FYB_FLAG_GPS     0x02
+#define FYB_MAX_RECORD   64    // 6+1+1 + 6x varint(<=5) + 4+4+2 < 64
+
+// ============================================================================
+// PRIMITIVES
+// ============================================================================
+
+static inline size_t fybPutVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline size_t fybPutI32(uint8_t* p, int32_t v) {
+    uint32_t u = (uint32_t)v;
+    p[0] = (uint8_t)u; p[1] = (uint8_t)(u >> 8);
+    p[2] = (uint8_t)(u >> 16); p[3] = (uint8_t)(u >> 24);
+    return 4;
+}
+
+static inline size_t fybPutU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+    return 2;
+}
+
+static inline int fybHexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 0;
+}
+
+// "aa:bb:cc:dd:ee:ff" -> 6 bytes (malformed digits read as 0)
+static inline void fybPackMAC(const char* s, uint8_t out[6]) {
+    for (int i = 0; i < 6; i++) {
+        out[i] = (uint8_t)((fybHexNibble(s[0]) << 4) | fybHexNibble(s[1]));
+        if (!s[2]) { for (int j = i + 1; j < 6; j++) out[j] = 0; return; }
+        s += 3;
+    }
+}
+
+static inline int32_t fybFixed7(double deg) {
+    double v = deg * 1e7;
+    return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+// ============================================================================
+// STREAMING ENCODER
+// ============================================================================
+// Two passes over the caller's table (which must stay locked for both):
+//   1. intern() every string -> deduplicated table with stable indices.
+//      Intern every row's method first: names and FW versions beyond
+//      MaxStrings are exported as empty, but a method has no "none" in
+//      the format.
+//   2. writeRecord() per row, each encoded into a small stack buffer and
+//      handed to the sink in one write(). A row whose method is not in the
+//      table is refused (false, nothing written) rather than exported as
+//      some other method; the caller ends the file there.
+
+template <size_t MaxStrings>
+class FYBinEncoder {
+public:
+    void reset() {
+        _count = 0;
+        memset(_slots, 0xFF, sizeof(_slots));
+    }
+
+    // Returns string index, or -1 if s is empty / the table is full
+    int intern(const char* s) {
+        if (!s || !s[0]) return -1;
+        uint32_t h = 2166136261u;  // FNV-1a
+        for (const char* p = s; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+        for (size_t i = 0; i < SLOTS; i++) {
+            uint16_t& slot = _slots[(h + i) & (SLOTS - 1)];
+            if (slot == EMPTY) {
+                if (_count >= MaxStrings) return -1;
+                _strs[_count] = s;
+                slot = (uint16_t)_count;
+                return (int)_count++;
+            }
+            if (strcmp(_strs[slot], s) == 0) return slot;
+        }
+        return -1;
+    }
+
+    // Index lookup for an already-interned string (pass 2)
+    int indexOf(const char* s) const {
+        if (!s || !s[0]) return -1;
+        uint32_t h = 2166136261u;
+        for (const char* p = s; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+        for (size_t i = 0; i < SLOTS; i++) {
+            uint16_t slot = _slots[(h + i) & (SLOTS - 1)];
+            if (slot == EMPTY) return -1;
+            if (strcmp(_strs[slot], s) == 0) return slot;
+        }
+        return -1;
+    }
+
+    template <typename Sink>
+    void writeHeader(Sink& out, uint32_t uptimeMs, uint32_t recordCount) {
+        writePreamble(out, uptimeMs);
+        for (size_t i = 0; i < _count; i++) writeString(out, i);
+        writeRecordCount(out, recordCount);
+    }
+
+    // writeHeader() in pieces, for sinks that take the header a string at a
+    // time (chunked web responses): preamble, writeString(0..count()-1),
+    // record count.
+    template <typename Sink>
+    void writePreamble(Sink& out, uint32_t uptimeMs) {
+        uint8_t buf[16];
+        memcpy(buf, FYB_MAGIC, 4);
+        buf[4] = FYB_VERSION;
+        buf[5] = 0;
+        size_t n = 6;
+        n += fybPutVarint(buf + n, uptimeMs);
+        n += fybPutVarint(buf + n, (uint32_t)_count);
+        out.write(buf, n);
+    }
+
+    template <typename Sink>
+    void writeString(Sink& out, size_t i) {
+        uint8_t buf[5];
+        size_t len = strlen(_strs[i]);
+        size_t n = fybPutVarint(buf, (uint32_t)len);
+        out.write(buf, n);
+        out.write((const uint8_t*)_strs[i], len);
+    }
+
+    template <typename Sink>
+    void writeRecordCount(Sink& out, uint32_t recordCount) {
+        uint8_t buf[5];
+        size_t n = fybPutVarint(buf, recordCount);
+        out.write(buf, n);
+    }
+
+    size_t count() const { return _count; }
+
+    // Det must expose the FYDetection fields (mac, name, rssi, method, ...).
+    // false (nothing written) if d.method was never interned.
+    template <typename Sink, typename Det>
+    bool writeRecord(Sink& out, const Det& d) {
+        int m = indexOf(d.method);
+        if (m < 0) return false;
+        uint8_t buf[FYB_MAX_RECORD];
+        size_t n = 0;
+        fybPackMAC(d.mac, buf);
+        n = 6;
+        buf[n++] = (d.isRaven ? FYB_FLAG_RAVEN : 0) | (d.hasGPS ? FYB_FLAG_GPS : 0);
+        int rssi = d.rssi < -128 ? -128 : (d.rssi > 127 ? 127 : d.rssi);
+        buf[n++] = (uint8_t)(int8_t)rssi;
+        n += fybPutVarint(buf + n, (uint32_t)m);
+        n += fybPutVarint(buf + n, (uint32_t)(indexOf(d.name) + 1));
+        n += fybPutVarint(buf + n, (uint32_t)(indexOf(d.ravenFW) + 1));
+        n += fybPutVarint(buf + n, (uint32_t)d.firstSeen);
+        n += fybPutVarint(buf + n, (uint32_t)(d.lastSeen - d.firstSeen));
+        n += fybPutVarint(buf + n, (uint32_t)(d.count < 0 ? 0 : d.count));
+        if (d.hasGPS) {
+            n += fybPutI32(buf + n, fybFixed7(d.gpsLat));
+            n += fybPutI32(buf + n, fybFixed7(d.gpsLon));
+            float dm = d.gpsAcc * 10.0f + 0.5f;
+            n += fybPutU16(buf + n, dm <= 0 ? 0 : (dm >= 65535.0f ? 65535 : (uint16_t)dm));
+        }
+        out.write(buf, n);
+        return true;
+    }
+
+private:
+    static constexpr size_t slotsFor(size_t s) { return s >= MaxStrings * 2 ? s : slotsFor(s << 1); }
+    static constexpr size_t SLOTS = slotsFor(16);
+    static constexpr uint16_t EMPTY = 0xFFFF;
+
+    const char* _strs[MaxStrings];
+    uint16_t _slots[SLOTS];
+    size_t _count = 0;
+};
@@ -0,0 +1,183 @@
+// ============================================================================
+// FLOCK-YOU: Offline known-camera index (FYCI)
+// ============================================================================
+// Read-only index of the geolocated sightings in datasets/, compiled on the
+// host by tools/mkcamindex.py and flashed to the "camidx" data partition.
+// The firmware memory-maps the partition and answers bounding-box queries
+// straight out of flash - no copy into RAM.
+//
+// Layout (little-endian, 4-byte aligned sections):
+//   FYCamHeader                     32 bytes
+//   FYCamTile[tileCount]            sorted by key (Z-order tile id)
+//   FYCamPoint[pointCount]          grouped by tile, in tile order
+//   labels                          NUL-terminated strings
+//
+// Tiles are quad-tree cells at a fixed level L: tile (tx, ty) is the top L
+// bits of the quantised lon/lat (same quantisation as fy_knowndb.h), keyed by
+// interleaving them. A query visits only the tiles overlapping its box,
+// each found by binary search in the tile directory.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "fy_knowndb.h"
+
+#define FY_CAM_MAGIC        "FYCI"
+#define FY_CAM_VERSION      1
+#define FY_CAM_NO_LABEL     0xFFFFFFFFu
+#define FY_CAM_MAX_TILES    1024    // Bigger boxes scan the directory instead
+
+// Dataset each point came from (tools/mkcamindex.py SOURCES)
+enum FYCamSource {
+    FY_CAM_SRC_CITY = 0,        // maximum_dots.csv - municipal/ALPR cameras
+    FY_CAM_SRC_FLOCK_CAM,       // Pigvision.csv - Flock cameras
+    FY_CAM_SRC_FS_BATTERY,      // FS+Ext+Battery_*.csv - BLE battery packs
+    FY_CAM_SRC_FLOCK_WIFI,      // Flock-*.csv - Flock-XXXXXX Wi-Fi
+    FY_CAM_SRC_COUNT
+};
+
+static const char* fy_cam_source_names[FY_CAM_SRC_COUNT] = {
+    "city_cam", "flock_cam", "fs_battery", "flock_wifi"
+};
+
+struct FYCamHeader {
+    char     magic[4];
+    uint16_t version;
+    uint8_t  level;
+    uint8_t  sources;
+    uint32_t tileCount;
+    uint32_t pointCount;
+    uint32_t tilesOffset;
+    uint32_t pointsOffset;
+    uint32_t labelsOffset;
+    uint32_t totalSize;
+};
+
+struct FYCamTile {
+    uint32_t key;
+    uint32_t first;
+    uint32_t count;
+};
+
+struct FYCamPoint {
+    int32_t  latE7;
+    int32_t  lonE7;
+    uint32_t label;         // Offset into labels, FY_CAM_NO_LABEL if none
+    uint8_t  source;
+    uint8_t  reserved[3];
+};
+
+class FYCamIndex {
+public:
+    // Validate and adopt a mapped image; false leaves the index empty
+    bool attach(const uint8_t* base, size_t size) {
+        _hdr = nullptr;
+        if (!base || size < sizeof(FYCamHeader)) return false;
+        const FYCamHeader* h = (const FYCamHeader*)base;
+        if (memcmp(h->magic, FY_CAM_MAGIC, 4) != 0 || h->version != FY_CAM_VERSION) return false;
+        if (h->level == 0 || h->level > 16 || h->totalSize > size) return false;
+        if (h->tilesOffset + (uint64_t)h->tileCount * sizeof(FYCamTile) > h->totalSize) return false;
+        if (h->pointsOffset + (uint64_t)h->pointCount * sizeof(FYCamPoint) > h->totalSize) return false;
+        if (h->labelsOffset > h->totalSize) return false;
+        _hdr = h;
+        _tiles = (const FYCamTile*)(base + h->tilesOffset);
+        _points = (const FYCamPoint*)(base + h->pointsOffset);
+        _labels = (const char*)(base + h->labelsOffset);
+        _labelsSize = h->totalSize - h->labelsOffset;
+        return true;
+    }
+
+    bool ready() const { return _hdr != nullptr; }
+    uint32_t pointCount() const { return _hdr ? _hdr->pointCount : 0; }
+    uint32_t tileCount() const { return _hdr ? _hdr->tileCount : 0; }
+    uint8_t level() const { return _hdr ? _hdr->level : 0; }
+    uint32_t imageSize() const { return _hdr ? _hdr->totalSize : 0; }
+
+    const char* label(const FYCamPoint& p) const {
+        if (p.label == FY_CAM_NO_LABEL || p.label >= _labelsSize) return "";
+        return _labels + p.label;
+    }
+
+    // Calls fn(point) for every point inside [south, north] x [west, east].
+    // fn returns false to stop early. Returns the number of points visited.
+    template <typename Fn>
+    size_t query(double south, double west, double north, double east, Fn fn) const {
+        if (!_hdr || south > north || west > east) return 0;
+        int shift = 32 - _hdr->level;
+        uint32_t ty0 = fyKnownQuantLat(south) >> shift, ty1 = fyKnownQuantLat(north) >> shift;
+        uint32_t tx0 = fyKnownQuantLon(west) >> shift, tx1 = fyKnownQuantLon(east) >> shift;
+        int32_t s = toE7(south), n = toE7(north), w = toE7(west), e = toE7(east);
+
+        size_t hits = 0;
+        uint64_t area = (uint64_t)(ty1 - ty0 + 1) * (tx1 - tx0 + 1);
+        if (area > FY_CAM_MAX_TILES) {
+            // Huge box: cheaper to walk the (sorted, compact) directory once
+            for (uint32_t t = 0; t < _hdr->tileCount; t++) {
+                uint32_t tx, ty;
+                untile(_tiles[t].key, tx, ty);
+                if (tx < tx0 || tx > tx1 || ty < ty0 || ty > ty1) continue;
+                if (!scanTile(_tiles[t], s, w, n, e, fn, hits)) return hits;
+            }
+            return hits;
+        }
+        for (uint32_t ty = ty0; ty <= ty1; ty++) {
+            for (uint32_t tx = tx0; tx <= tx1; tx++) {
+                const FYCamTile* t = findTile(tileKey(tx, ty));
+                if (t && !scanTile(*t, s, w, n, e, fn, hits)) return hits;
+            }
+        }
+        return hits;
+    }
+
+    static uint32_t tileKey(uint32_t tx, uint32_t ty) {
+        return (uint32_t)((fyKnownSpread(tx) << 1) | fyKnownSpread(ty));
+    }
+
+private:
+    static int32_t toE7(double deg) {
+        double v = deg * 1e7;
+        if (v > 2147483647.0) return 2147483647;
+        if (v < -2147483647.0) return -2147483647;
+        return (int32_t)v;
+    }
+
+    static void untile(uint32_t key, uint32_t& tx, uint32_t& ty) {
+        tx = ty = 0;
+        for (int b = 0; b < 16; b++) {
+            ty |= ((key >> (2 * b)) & 1) << b;
+            tx |= ((key >> (2 * b + 1)) & 1) << b;
+        }
+    }
+
+    const FYCamTile* findTile(uint32_t key) const {
+        uint32_t lo = 0, hi = _hdr->tileCount;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (_tiles[mid].key < key) lo = mid + 1;
+            else hi = mid;
+        }
+        return (lo < _hdr->tileCount && _tiles[lo].key == key) ? &_tiles[lo] : nullptr;
+    }
+
+    template <typename Fn>
+    bool scanTile(const FYCamTile& t, int32_t s, int32_t w, int32_t n, int32_t e,
+                  Fn& fn, size_t& hits) const {
+        if (t.first + (uint64_t)t.count > _hdr->pointCount) return true;
+        for (uint32_t i = t.first; i < t.first + t.count; i++) {
+            const FYCamPoint& p = _points[i];
+            if (p.latE7 < s || p.latE7 > n || p.lonE7 < w || p.lonE7 > e) continue;
+            hits++;
+            if (!fn(p)) return false;
+        }
+        return true;
+    }
+
+    const FYCamHeader* _hdr = nullptr;
+    const FYCamTile* _tiles = nullptr;
+    const FYCamPoint* _points = nullptr;
+    const char* _labels = nullptr;
+    uint32_t _labelsSize = 0;
+};
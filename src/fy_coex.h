@@ -0,0 +1,75 @@
+// ============================================================================
+// FLOCK-YOU: Wi-Fi / BLE coexistence policy
+// ============================================================================
+// The S3 has one 2.4 GHz radio; the coexistence arbiter grants it to either
+// the softAP or the NimBLE scanner slot by slot. Left at "balance", a phone
+// pulling a large export takes enough airtime that scan windows are starved
+// and adverts are missed.
+//
+// This picks the arbiter preference once per radio tick from what the unit
+// is doing:
+//   BLE     a target was sighted within the last holdMs - keep listening,
+//           the next adverts carry RSSI updates and often a second device
+//   WIFI    responses are streaming at >= txBps and no burst is in progress
+//   BALANCE otherwise
+// A detection burst preempts immediately; every other change waits until
+// the current mode has held for dwellMs, so a transfer hovering around the
+// threshold does not flap the arbiter. pinned forces one mode (tuning).
+//
+// Pure logic; the caller samples counters and applies the result
+// (esp_coex_preference_set in main.cpp). Single caller, no locking.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+
+enum FYCoexMode : uint8_t {
+    FY_COEX_BALANCE,
+    FY_COEX_BLE,
+    FY_COEX_WIFI,
+    FY_COEX_MODES,
+    FY_COEX_AUTO = FY_COEX_MODES   // pinned: no pin
+};
+
+static const char* const fy_coex_mode_names[] = {"balance", "ble", "wifi", "auto"};
+
+struct FYCoexPolicy {
+    uint32_t holdMs;     // BLE preference after the last target sighting
+    uint32_t txBps;      // Response throughput that counts as a large transfer
+    uint32_t dwellMs;    // Minimum time in a mode before leaving it
+    uint8_t  pinned;     // FYCoexMode, or FY_COEX_AUTO
+
+    FYCoexPolicy(uint32_t hold, uint32_t tx, uint32_t dwell)
+        : holdMs(hold), txBps(tx), dwellMs(dwell), pinned(FY_COEX_AUTO),
+          _mode(FY_COEX_BALANCE), _sinceMs(0), _lastSightMs(0), _sighted(false) {}
+
+    // sightings: target matches since the last call; txBps: response bytes/s
+    // over the last second. Returns the mode to apply.
+    FYCoexMode update(uint32_t nowMs, uint32_t sightings, uint32_t tx) {
+        if (sightings) {
+            _lastSightMs = nowMs;
+            _sighted = true;
+        }
+        FYCoexMode want = FY_COEX_BALANCE;
+        if (pinned < FY_COEX_MODES) want = (FYCoexMode)pinned;
+        else if (_sighted && nowMs - _lastSightMs < holdMs) want = FY_COEX_BLE;
+        else if (tx >= txBps) want = FY_COEX_WIFI;
+
+        if (want != _mode &&
+            (want == FY_COEX_BLE || pinned < FY_COEX_MODES || nowMs - _sinceMs >= dwellMs)) {
+            _mode = want;
+            _sinceMs = nowMs;
+        }
+        return _mode;
+    }
+
+    FYCoexMode mode() const { return _mode; }
+    uint32_t since() const { return _sinceMs; }
+
+private:
+    FYCoexMode _mode;
+    uint32_t _sinceMs;
+    uint32_t _lastSightMs;
+    bool _sighted;
+};
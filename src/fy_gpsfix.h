@@ -0,0 +1,191 @@
+// ============================================================================
+// FLOCK-YOU: Phone GPS fix queue + batch parser
+// ============================================================================
+// The dashboard buffers Geolocation fixes and POSTs them in batches to
+// /api/gps/batch, one fix per line:
+//
+//   <age_ms>,<lat>,<lon>[,<acc_m>]\n
+//
+// age_ms is how long before the request the fix was taken, so no clock sync
+// is needed; the firmware stamps it as millis() - age_ms. Lines are oldest
+// first. Coordinates are parsed straight to 1e-7 degree integers (no
+// strtod / String::toDouble on the web task).
+//
+// FYFixQueue is a fixed ring written by one task (the web handler) and read
+// by any number of tasks (BLE host, radio, web). Each slot is a seqlock, so a
+// reader either gets a complete lat/lon/acc/time tuple or retries - never a
+// torn pair. No locks on either side. latest() tags live detections;
+// nearest() looks a fix up by time, so fixes the phone buffered while the
+// AP was down can be matched to detections made during the drop.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+#define FY_GPS_E7 10000000L
+
+struct FYGPSFix {
+    int32_t  latE7;
+    int32_t  lonE7;
+    float    acc;       // Metres
+    uint32_t tMs;       // millis() when the fix was taken
+};
+
+template <size_t N>
+class FYFixQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    FYFixQueue() : _head(0), _published(0) {
+        for (size_t i = 0; i < N; i++) _slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer (single task)
+    void publish(const FYGPSFix& f) {
+        uint32_t n = _published.load(std::memory_order_relaxed);
+        Slot& s = _slots[n & (N - 1)];
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);          // odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        uint32_t w[4];
+        memcpy(w, &f, sizeof(w));
+        for (int i = 0; i < 4; i++) s.w[i].store(w[i], std::memory_order_relaxed);
+        s.seq.store(seq + 2, std::memory_order_release);          // even: stable
+        _head.store(n & (N - 1), std::memory_order_release);
+        _published.store(n + 1, std::memory_order_release);
+    }
+
+    // Newest fix; false if nothing was ever published
+    bool latest(FYGPSFix& out) const {
+        for (;;) {
+            if (_published.load(std::memory_order_acquire) == 0) return false;
+            if (read(_head.load(std::memory_order_acquire), out)) return true;
+        }
+    }
+
+    // Retained fix closest in time to tMs, within windowMs either side
+    bool nearest(uint32_t tMs, uint32_t windowMs, FYGPSFix& out) const {
+        uint32_t n = _published.load(std::memory_order_acquire);
+        uint32_t best = windowMs + 1;
+        for (size_t i = 0; i < N && i < n; i++) {
+            FYGPSFix f;
+            if (!read(i, f)) continue;      // Being rewritten - it is the newest, not a gap fix
+            uint32_t d = (int32_t)(f.tMs - tMs) < 0 ? tMs - f.tMs : f.tMs - tMs;
+            if (d < best) {
+                best = d;
+                out = f;
+            }
+        }
+        return best <= windowMs;
+    }
+
+    uint32_t published() const { return _published.load(std::memory_order_relaxed); }
+    static size_t capacity() { return N; }
+
+private:
+    static_assert(sizeof(FYGPSFix) == 16, "FYGPSFix must pack into 4 words");
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> w[4];
+    };
+
+    bool read(size_t idx, FYGPSFix& out) const {
+        const Slot& s = _slots[idx];
+        uint32_t s1 = s.seq.load(std::memory_order_acquire);
+        if (s1 & 1) return false;
+        uint32_t w[4];
+        for (int i = 0; i < 4; i++) w[i] = s.w[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != s1) return false;
+        memcpy(&out, w, sizeof(out));
+        return true;
+    }
+
+    Slot _slots[N];
+    std::atomic<size_t> _head;
+    std::atomic<uint32_t> _published;
+};
+
+// Decimal degrees -> 1e-7 degree integer. Extra fraction digits are dropped.
+static inline bool fyGpsParseE7(const char*& p, const char* end, int32_t& out) {
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+    int64_t ip = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9' && digits < 4) { ip = ip * 10 + (*p++ - '0'); digits++; }
+    if (!digits) return false;
+    int64_t frac = 0;
+    int fd = 0;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (fd < 7) { frac = frac * 10 + (*p - '0'); fd++; }
+            p++;
+        }
+    }
+    while (fd < 7) { frac *= 10; fd++; }
+    int64_t v = ip * FY_GPS_E7 + frac;
+    out = (int32_t)(neg ? -v : v);
+    return v <= 180 * FY_GPS_E7;
+}
+
+static inline bool fyGpsParseU32(const char*& p, const char* end, uint32_t& out) {
+    const char* s = p;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9' && v <= 0xFFFFFFFFull) v = v * 10 + (*p++ - '0');
+    if (p == s || v > 0xFFFFFFFFull) return false;
+    out = (uint32_t)v;
+    return true;
+}
+
+// Metres, one decimal is plenty
+static inline bool fyGpsParseAcc(const char*& p, const char* end, float& out) {
+    uint32_t ip = 0;
+    if (!fyGpsParseU32(p, end, ip)) return false;
+    float f = (float)ip;
+    if (p < end && *p == '.') {
+        p++;
+        float scale = 0.1f;
+        while (p < end && *p >= '0' && *p <= '9') { f += (*p++ - '0') * scale; scale *= 0.1f; }
+    }
+    out = f;
+    return true;
+}
+
+// Calls fn(ageMs, fix) for each valid line (fix.tMs left 0). Returns the
+// number of malformed / out-of-range lines skipped.
+template <typename Fn>
+static size_t fyGpsParseBatch(const char* p, size_t n, Fn fn) {
+    const char* end = p + n;
+    size_t bad = 0;
+    while (p < end) {
+        const char* eol = p;
+        while (eol < end && *eol != '\n' && *eol != ';') eol++;
+        const char* q = p;
+        while (q < eol && (*q == ' ' || *q == '\r')) q++;
+        if (q < eol) {
+            uint32_t age;
+            FYGPSFix f = {0, 0, 0, 0};
+            bool ok = fyGpsParseU32(q, eol, age) && q < eol && *q++ == ',' &&
+                      fyGpsParseE7(q, eol, f.latE7) && q < eol && *q++ == ',' &&
+                      fyGpsParseE7(q, eol, f.lonE7);
+            if (ok && q < eol && *q == ',') {
+                q++;
+                ok = fyGpsParseAcc(q, eol, f.acc);
+            }
+            while (ok && q < eol && (*q == ' ' || *q == '\r')) q++;
+            ok = ok && q == eol &&
+                 f.latE7 >= -90 * FY_GPS_E7 && f.latE7 <= 90 * FY_GPS_E7 &&
+                 f.lonE7 >= -180 * FY_GPS_E7 && f.lonE7 <= 180 * FY_GPS_E7;
+            if (ok) fn(age, f);
+            else bad++;
+        }
+        p = eol < end ? eol + 1 : end;
+    }
+    return bad;
+}
@@ -0,0 +1,367 @@
+// ============================================================================
+// FLOCK-YOU: Persistent known-device spatial index
+// ============================================================================
+// Remembers every GPS-tagged detection across sessions so a new sighting can
+// be classified as "known" (seen on a previous drive) or "new", and so the
+// dashboard can ask what is near the phone (/api/nearby).
+//
+// Storage: fixed 32-byte records in stable slots, plus
+//   - order[]: slot ids sorted by a Z-order (geohash-style) key, giving
+//     O(log n) range lookups per covering cell
+//   - a MAC hash table (slot ids, open addressing) for O(1) known/new checks
+//
+// Sightings refine the location estimate (accuracy-weighted average) but the
+// sort key is only recomputed once the estimate drifts more than
+// FY_KNOWN_REKEY_M from where it was keyed; queries widen their search box by
+// that slack, so routine updates never reshuffle order[].
+//
+// The device has no wall clock, so first/last seen are boot session numbers.
+// Persistence (SPIFFS) and locking are the caller's job - see main.cpp.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define FY_KNOWN_MAGIC      "FYKD"
+#define FY_KNOWN_VERSION    1
+#define FY_KNOWN_REKEY_M    50.0     // Re-sort only after moving this far
+#define FY_KNOWN_EMPTY      0xFFFF
+#define FY_KNOWN_RAVEN      0x0001
+
+struct FYKnownRec {
+    uint64_t key;          // Z-order key of the anchor position
+    uint8_t  mac[6];
+    uint16_t flags;
+    int32_t  latE7;        // Current location estimate (deg * 1e7)
+    int32_t  lonE7;
+    uint16_t firstSession;
+    uint16_t lastSession;
+    uint16_t sessions;     // Number of sessions this device was seen in
+    uint16_t weight;       // Accumulated fix weight (caps estimate inertia)
+};                         // 32 bytes
+
+struct FYKnownHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t session;      // Last session that wrote the file
+    uint32_t count;
+};
+
+// ============================================================================
+// GEO HELPERS
+// ============================================================================
+
+static inline uint64_t fyKnownSpread(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2))  & 0x3333333333333333ULL;
+    x = (x | (x << 1))  & 0x5555555555555555ULL;
+    return x;
+}
+
+static inline uint32_t fyKnownQuantLat(double lat) {
+    double u = (lat + 90.0) / 180.0;
+    if (u <= 0) return 0;
+    if (u >= 1) return 0xFFFFFFFFu;
+    return (uint32_t)(u * 4294967296.0);
+}
+
+static inline uint32_t fyKnownQuantLon(double lon) {
+    double u = (lon + 180.0) / 360.0;
+    if (u <= 0) return 0;
+    if (u >= 1) return 0xFFFFFFFFu;
+    return (uint32_t)(u * 4294967296.0);
+}
+
+// Longitude bits take the odd positions, latitude the even (like geohash)
+static inline uint64_t fyKnownKey(double lat, double lon) {
+    return (fyKnownSpread(fyKnownQuantLon(lon)) << 1) | fyKnownSpread(fyKnownQuantLat(lat));
+}
+
+// Equirectangular distance - plenty for the <= 50 km radii we query
+static inline double fyKnownDistM(double lat1, double lon1, double lat2, double lon2) {
+    const double R = 6371000.0, D2R = 0.017453292519943295;
+    double x = (lon2 - lon1) * D2R * cos((lat1 + lat2) * 0.5 * D2R);
+    double y = (lat2 - lat1) * D2R;
+    return R * sqrt(x * x + y * y);
+}
+
+// ============================================================================
+// INDEX
+// ============================================================================
+
+class FYKnownDB {
+public:
+    // Bytes of backing memory needed for cap records
+    static size_t memFor(size_t cap) {
+        return cap * sizeof(FYKnownRec) + cap * sizeof(uint16_t) + hashSlotsFor(cap) * sizeof(uint16_t);
+    }
+
+    void init(void* mem, size_t cap) {
+        _recs = (FYKnownRec*)mem;
+        _order = (uint16_t*)(_recs + cap);
+        _hash = _order + cap;
+        _cap = cap > FY_KNOWN_EMPTY ? FY_KNOWN_EMPTY : cap;
+        _hashSlots = hashSlotsFor(cap);
+        clear();
+    }
+
+    void clear() {
+        _count = 0;
+        if (_hash) memset(_hash, 0xFF, _hashSlots * sizeof(uint16_t));
+    }
+
+    size_t count() const { return _count; }
+    size_t capacity() const { return _cap; }
+    const FYKnownRec& at(size_t sortedPos) const { return _recs[_order[sortedPos]]; }
+
+    const FYKnownRec* find(const uint8_t mac[6]) const {
+        int slot = lookup(mac);
+        return slot < 0 ? nullptr : &_recs[slot];
+    }
+
+    // Bulk load from a file written by save order (already sorted by key)
+    bool loadSorted(const FYKnownRec& r) {
+        if (_count >= _cap || lookup(r.mac) >= 0) return false;
+        _recs[_count] = r;
+        _order[_count] = (uint16_t)_count;
+        hashInsert(r.mac, (uint16_t)_count);
+        _count++;
+        return true;
+    }
+
+    // Record one GPS-tagged sighting. Returns the record's session count as
+    // it was BEFORE this session (0 = device never seen on an earlier drive).
+    uint16_t observe(const uint8_t mac[6], double lat, double lon, float acc,
+                     bool raven, uint16_t session, bool* changed = nullptr) {
+        int slot = lookup(mac);
+        if (changed) *changed = true;
+        if (slot < 0) {
+            slot = allocSlot(session);
+            if (slot < 0) { if (changed) *changed = false; return 0; }
+            FYKnownRec& r = _recs[slot];
+            memset(&r, 0, sizeof(r));
+            memcpy(r.mac, mac, 6);
+            r.latE7 = toE7(lat);
+            r.lonE7 = toE7(lon);
+            r.key = fyKnownKey(lat, lon);
+            r.flags = raven ? FY_KNOWN_RAVEN : 0;
+            r.firstSession = r.lastSession = session;
+            r.sessions = 1;
+            r.weight = fixWeight(acc);
+            hashInsert(mac, (uint16_t)slot);
+            orderInsert((uint16_t)slot);
+            return 0;
+        }
+
+        FYKnownRec& r = _recs[slot];
+        uint16_t prior = (r.lastSession == session) ? r.sessions - 1 : r.sessions;
+        if (r.lastSession != session) {
+            r.lastSession = session;
+            if (r.sessions < 0xFFFF) r.sessions++;
+        }
+        if (raven) r.flags |= FY_KNOWN_RAVEN;
+
+        // Accuracy-weighted running mean, capped so a moved unit converges
+        uint32_t w = fixWeight(acc);
+        uint32_t tot = (uint32_t)r.weight + w;
+        double curLat = r.latE7 / 1e7, curLon = r.lonE7 / 1e7;
+        double nLat = curLat + (lat - curLat) * w / tot;
+        double nLon = curLon + (lon - curLon) * w / tot;
+        r.latE7 = toE7(nLat);
+        r.lonE7 = toE7(nLon);
+        r.weight = (uint16_t)(tot > 2000 ? 2000 : tot);
+
+        if (keyDriftM(r) > FY_KNOWN_REKEY_M) {
+            orderRemove((uint16_t)slot);
+            r.key = fyKnownKey(nLat, nLon);
+            orderInsert((uint16_t)slot);
+        }
+        return prior;
+    }
+
+    // Calls fn(rec, distanceM) for each record within radiusM of (lat, lon).
+    // Returns the number of matches (fn may stop early by returning false).
+    template <typename Fn>
+    size_t nearby(double lat, double lon, double radiusM, Fn fn) const {
+        double r = radiusM + FY_KNOWN_REKEY_M;
+        double dLat = r / 111320.0;
+        double cosLat = cos(lat * 0.017453292519943295);
+        double dLon = cosLat > 1e-6 ? r / (111320.0 * cosLat) : 360.0;
+
+        // Finest level whose cells are still at least as big as the search
+        // box, so the box touches at most 2x2 cells. The box is clamped at
+        // the poles and the antimeridian rather than wrapped.
+        int level = 0;
+        while (level < 31) {
+            double cLat = ldexp(180.0, -(level + 1));
+            double cLon = ldexp(360.0, -(level + 1));
+            if (cLat < 2 * dLat || cLon < 2 * dLon) break;
+            level++;
+        }
+        int shift = 32 - level;
+        uint64_t latLo = (uint64_t)fyKnownQuantLat(lat - dLat) >> shift;
+        uint64_t latHi = (uint64_t)fyKnownQuantLat(lat + dLat) >> shift;
+        uint64_t lonLo = (uint64_t)fyKnownQuantLon(lon - dLon) >> shift;
+        uint64_t lonHi = (uint64_t)fyKnownQuantLon(lon + dLon) >> shift;
+
+        size_t hits = 0;
+        for (uint64_t cy = latLo; cy <= latHi; cy++) {
+            for (uint64_t cx = lonLo; cx <= lonHi; cx++) {
+                uint64_t prefix = (fyKnownSpread((uint32_t)cx) << 1) | fyKnownSpread((uint32_t)cy);
+                uint64_t lo = level ? prefix << (64 - 2 * level) : 0;
+                uint64_t span = level ? (1ULL << (64 - 2 * level)) : 0;
+                for (size_t i = lowerBound(lo); i < _count; i++) {
+                    const FYKnownRec& rec = _recs[_order[i]];
+                    if (level && rec.key - lo >= span) break;
+                    double d = fyKnownDistM(lat, lon, rec.latE7 / 1e7, rec.lonE7 / 1e7);
+                    if (d <= radiusM) {
+                        hits++;
+                        if (!fn(rec, d)) return hits;
+                    }
+                }
+                if (!level) return hits;  // Whole-world query: one pass
+            }
+        }
+        return hits;
+    }
+
+private:
+    static size_t hashSlotsFor(size_t cap) {
+        size_t s = 16;
+        while (s < cap * 2) s <<= 1;
+        return s;
+    }
+
+    static int32_t toE7(double deg) {
+        double v = deg * 1e7;
+        return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+    }
+
+    // Better fixes pull the estimate harder: 10 m -> 10, 100 m -> 1
+    static uint16_t fixWeight(float acc) {
+        if (!(acc > 0)) return 1;
+        float w = 100.0f / acc;
+        return w < 1 ? 1 : (w > 50 ? 50 : (uint16_t)w);
+    }
+
+    static uint32_t macHash(const uint8_t mac[6]) {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+        return h;
+    }
+
+    double keyDriftM(const FYKnownRec& r) const {
+        // Decode the anchor back from the key (top bits are plenty)
+        uint64_t k = r.key;
+        uint32_t qLat = 0, qLon = 0;
+        for (int b = 31; b >= 0; b--) {
+            qLon |= (uint32_t)((k >> (2 * b + 1)) & 1) << b;
+            qLat |= (uint32_t)((k >> (2 * b)) & 1) << b;
+        }
+        double aLat = qLat / 4294967296.0 * 180.0 - 90.0;
+        double aLon = qLon / 4294967296.0 * 360.0 - 180.0;
+        return fyKnownDistM(aLat, aLon, r.latE7 / 1e7, r.lonE7 / 1e7);
+    }
+
+    int lookup(const uint8_t mac[6]) const {
+        if (!_hash) return -1;
+        uint32_t h = macHash(mac);
+        for (size_t i = 0; i < _hashSlots; i++) {
+            uint16_t s = _hash[(h + i) & (_hashSlots - 1)];
+            if (s == FY_KNOWN_EMPTY) return -1;
+            if (memcmp(_recs[s].mac, mac, 6) == 0) return s;
+        }
+        return -1;
+    }
+
+    void hashInsert(const uint8_t mac[6], uint16_t slot) {
+        uint32_t h = macHash(mac);
+        for (size_t i = 0; i < _hashSlots; i++) {
+            uint16_t& s = _hash[(h + i) & (_hashSlots - 1)];
+            if (s == FY_KNOWN_EMPTY) { s = slot; return; }
+        }
+    }
+
+    void hashRebuild(size_t skip) {
+        memset(_hash, 0xFF, _hashSlots * sizeof(uint16_t));
+        for (size_t i = 0; i < _count; i++) {
+            if (i != skip) hashInsert(_recs[i].mac, (uint16_t)i);
+        }
+    }
+
+    // New slot. When full, evicts the stalest device seen on a single
+    // earlier drive (a one-off is the least likely to be "known" again);
+    // only if there is none, the stalest device overall, fewest sessions first
+    int allocSlot(uint16_t session) {
+        if (_count < _cap) {
+            _order[_count] = FY_KNOWN_EMPTY;  // Placeholder until orderInsert
+            return (int)_count++;
+        }
+        size_t victim = 0, single = _count;
+        for (size_t i = 0; i < _count; i++) {
+            const FYKnownRec& a = _recs[i];
+            if (a.sessions == 1 && a.lastSession != session &&
+                (single == _count || a.lastSession < _recs[single].lastSession)) single = i;
+            const FYKnownRec& b = _recs[victim];
+            if (a.lastSession < b.lastSession ||
+                (a.lastSession == b.lastSession && a.sessions < b.sessions)) victim = i;
+        }
+        if (single < _count) victim = single;
+        orderRemove((uint16_t)victim);
+        hashRebuild(victim);  // Open addressing: no in-place delete
+        return (int)victim;
+    }
+
+    size_t lowerBound(uint64_t key) const {
+        size_t lo = 0, hi = _count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            uint16_t s = _order[mid];
+            if (s == FY_KNOWN_EMPTY || _recs[s].key >= key) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    // order[] holds _count entries; the last is a placeholder when inserting
+    void orderInsert(uint16_t slot) {
+        size_t n = _count - 1;  // Sorted entries currently in order[]
+        size_t pos = lowerBoundN(_recs[slot].key, n);
+        memmove(&_order[pos + 1], &_order[pos], (n - pos) * sizeof(uint16_t));
+        _order[pos] = slot;
+    }
+
+    void orderRemove(uint16_t slot) {
+        for (size_t i = lowerBound(_recs[slot].key); i < _count; i++) {
+            if (_order[i] == slot) {
+                memmove(&_order[i], &_order[i + 1], (_count - 1 - i) * sizeof(uint16_t));
+                _order[_count - 1] = FY_KNOWN_EMPTY;
+                return;
+            }
+        }
+    }
+
+    size_t lowerBoundN(uint64_t key, size_t n) const {
+        size_t lo = 0, hi = n;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (_recs[_order[mid]].key >= key) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    FYKnownRec* _recs = nullptr;
+    uint16_t* _order = nullptr;
+    uint16_t* _hash = nullptr;
+    size_t _cap = 0;
+    size_t _hashSlots = 0;
+    size_t _count = 0;
+};
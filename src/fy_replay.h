@@ -0,0 +1,77 @@
+// ============================================================================
+// FLOCK-YOU: Replay ring for the serial detection stream
+// ============================================================================
+// Every serial detection record carries a sequence number (1, 2, 3, ... per
+// boot). The rendered line is kept here so a host that lost the link can
+// ask for everything after the last sequence it saw and get the exact same
+// bytes again (see "RESUME" in main.cpp and flock_reader in api/flockyou.py).
+//
+// Fixed slots, slot = seq % slots, so the newest `slots` records are always
+// retained and lookup is O(1). A line longer than a slot is kept as a marker
+// only (len 0) - the host then sees it as lost rather than as a torn record.
+// Locking is the caller's job.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class FYReplayRing {
+public:
+    struct Slot {
+        uint32_t seq;      // 0 = never written
+        uint32_t uptime;   // millis() of the record, kept for lost markers
+        uint16_t len;
+        char     line[1];  // lineMax bytes
+    };
+
+    // Bytes of backing memory needed for slots lines of up to lineMax bytes
+    static size_t memFor(size_t slots, size_t lineMax) { return slots * stride(lineMax); }
+
+    void init(void* mem, size_t slots, size_t lineMax) {
+        _mem = (uint8_t*)mem;
+        _slots = mem ? slots : 0;
+        _lineMax = lineMax;
+        _newest = 0;
+        for (size_t i = 0; i < _slots; i++) slot(i)->seq = 0;
+    }
+
+    void put(uint32_t seq, uint32_t uptime, const char* line, size_t len) {
+        if (!_slots) return;
+        Slot* s = slot(seq % _slots);
+        s->seq = seq;
+        s->uptime = uptime;
+        s->len = len <= _lineMax ? (uint16_t)len : 0;
+        if (s->len) memcpy(s->line, line, len);
+        _newest = seq;
+    }
+
+    // Oldest retained sequence (0 if nothing retained)
+    uint32_t oldest() const {
+        if (!_newest) return 0;
+        return _newest >= _slots ? _newest - _slots + 1 : 1;
+    }
+    uint32_t newest() const { return _newest; }
+    size_t capacity() const { return _slots; }
+
+    // Retained record, NULL once aged out. len 0 = too long to keep.
+    const Slot* get(uint32_t seq) const {
+        if (!seq || seq > _newest || seq < oldest()) return NULL;
+        const Slot* s = slot(seq % _slots);
+        return s->seq == seq ? s : NULL;
+    }
+
+private:
+    static size_t stride(size_t lineMax) {
+        size_t n = offsetof(Slot, line) + lineMax;
+        return (n + 3) & ~(size_t)3;
+    }
+    Slot* slot(size_t i) const { return (Slot*)(_mem + i * stride(_lineMax)); }
+
+    uint8_t* _mem = NULL;
+    size_t _slots = 0;
+    size_t _lineMax = 0;
+    uint32_t _newest = 0;
+};
@@ -0,0 +1,85 @@
+// ============================================================================
+// FLOCK-YOU: Fixed pool of response chunks
+// ============================================================================
+// Every data endpoint streams through one chunk from this pool instead of an
+// AsyncResponseStream that grows to hold the whole body. The chunk is
+// refilled a few rows at a time as the TCP window opens, so a response costs
+// one chunk no matter how many detections there are, and total response
+// memory is capped at count x size.
+//
+// The backing memory is handed in by the caller (PSRAM on the XIAO). Slots
+// are claimed with a CAS on a bitmap, so acquire()/release() are safe from
+// any task and never block. acquire() returns -1 when every chunk is in use;
+// the caller answers 503 instead of allocating.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <size_t N>
+class FYChunkPool {
+    static_assert(N >= 1 && N <= 32, "bitmap holds at most 32 chunks");
+
+public:
+    FYChunkPool() : _mem(NULL), _size(0), _count(0), _used(0), _inUse(0), _peak(0), _refused(0) {}
+
+    // count <= N chunks of size bytes each, carved from mem
+    void init(uint8_t* mem, size_t count, size_t size) {
+        _mem = mem;
+        _size = mem ? size : 0;
+        _count = mem ? (count < N ? count : N) : 0;
+    }
+
+    int acquire() {
+        uint32_t used = _used.load(std::memory_order_relaxed);
+        for (;;) {
+            int idx = -1;
+            for (size_t i = 0; i < _count; i++) {
+                if (!(used & (1u << i))) { idx = (int)i; break; }
+            }
+            if (idx < 0) {
+                _refused.fetch_add(1, std::memory_order_relaxed);
+                return -1;
+            }
+            if (_used.compare_exchange_weak(used, used | (1u << idx),
+                                            std::memory_order_acquire, std::memory_order_relaxed)) {
+                uint32_t n = _inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                uint32_t p = _peak.load(std::memory_order_relaxed);
+                while (n > p && !_peak.compare_exchange_weak(p, n, std::memory_order_relaxed)) {}
+                return idx;
+            }
+        }
+    }
+
+    void release(int idx) {
+        if (idx < 0 || (size_t)idx >= _count) return;
+        _inUse.fetch_sub(1, std::memory_order_relaxed);
+        _used.fetch_and(~(1u << idx), std::memory_order_release);
+    }
+
+    // Benchmark runs: peak restarts from what is in use right now
+    void resetStats() {
+        _peak.store(_inUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _refused.store(0, std::memory_order_relaxed);
+    }
+
+    uint8_t* chunk(int idx) const { return _mem + (size_t)idx * _size; }
+
+    size_t   count() const     { return _count; }
+    size_t   chunkSize() const { return _size; }
+    uint32_t inUse() const     { return _inUse.load(std::memory_order_relaxed); }
+    uint32_t peak() const      { return _peak.load(std::memory_order_relaxed); }
+    uint32_t refused() const   { return _refused.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t* _mem;
+    size_t _size;
+    size_t _count;
+    std::atomic<uint32_t> _used;     // Bit i set = chunk i handed out
+    std::atomic<uint32_t> _inUse;
+    std::atomic<uint32_t> _peak;
+    std::atomic<uint32_t> _refused;
+};
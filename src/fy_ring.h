@@ -0,0 +1,52 @@
+// ============================================================================
+// FLOCK-YOU: Lock-free single-producer / single-consumer ring
+// ============================================================================
+// Hands small fixed-size records from a callback that must not block (Wi-Fi
+// promiscuous RX, NimBLE, esp_timer) to the task that processes them.
+// Exactly one task may push and exactly one may pop. N must be a power of
+// two; one slot is never used so full and empty can be told apart.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, size_t N>
+class FYSpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    FYSpscRing() : _head(0), _tail(0) {}
+
+    // Producer side. False (record dropped) when the ring is full.
+    bool push(const T& v) {
+        size_t h = _head.load(std::memory_order_relaxed);
+        size_t next = (h + 1) & (N - 1);
+        if (next == _tail.load(std::memory_order_acquire)) return false;
+        _buf[h] = v;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. False when empty.
+    bool pop(T& out) {
+        size_t t = _tail.load(std::memory_order_relaxed);
+        if (t == _head.load(std::memory_order_acquire)) return false;
+        out = _buf[t];
+        _tail.store((t + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+    static size_t capacity() { return N - 1; }
+
+private:
+    T _buf[N];
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+};
@@ -0,0 +1,208 @@
+// ============================================================================
+// FLOCK-YOU: Buffered streaming serializer
+// ============================================================================
+// One writer for every text output (web responses, SPIFFS files, serial).
+// Sink is anything with write(const uint8_t*, size_t): AsyncResponseStream,
+// File, or a stdout/Serial adapter. Output is staged in a fixed buffer and
+// handed to the sink in large blocks instead of one vsnprintf + append per
+// field.
+//
+//   FYWriter<AsyncResponseStream> w(*resp);
+//   w.raw("{\"mac\":\"").json(d.mac).raw("\",\"rssi\":").i32(d.rssi);
+//
+// Number formatting matches printf (%d, %lu, %.Nf) byte-for-byte; fixed()
+// only falls back to snprintf for values sitting on a rounding tie, NaN/inf
+// or magnitudes beyond the fast path.
+//
+// String escaping is done on output, in one pass, for the target format:
+//   json() - quote, backslash and all control characters (\n, \u001f, ...)
+//   csv()  - for use inside a quoted field: " -> ""
+//   xml()  - & < > " ' as entities (also safe inside CDATA/HTML)
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define FY_WRITER_BUF 512
+
+// Sink for the serial JSON stream - same channel as the firmware's printf()
+struct FYStdoutSink {
+    size_t write(const uint8_t* p, size_t n) { return fwrite(p, 1, n, stdout); }
+};
+
+// Sink over a caller-owned fixed buffer (response chunks, serial records).
+// Never writes past cap; overflow is set if anything had to be dropped.
+struct FYBufSink {
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+    size_t write(const uint8_t* p, size_t n) {
+        if (n > cap - len) { n = cap - len; overflow = true; }
+        memcpy(buf + len, p, n);
+        len += n;
+        return n;
+    }
+};
+
+template <typename Sink, size_t N = FY_WRITER_BUF>
+class FYWriter {
+public:
+    explicit FYWriter(Sink& out) : _out(out), _len(0) {}
+    ~FYWriter() { flush(); }
+
+    void flush() {
+        if (_len) {
+            _out.write((const uint8_t*)_buf, _len);
+            _len = 0;
+        }
+    }
+
+    // ---- raw output --------------------------------------------------------
+
+    FYWriter& ch(char c) {
+        if (_len == N) flush();
+        _buf[_len++] = c;
+        return *this;
+    }
+
+    FYWriter& raw(const char* s, size_t n) {
+        if (n >= N) {
+            // Large literal: bypass the staging buffer
+            flush();
+            _out.write((const uint8_t*)s, n);
+            return *this;
+        }
+        if (_len + n > N) flush();
+        memcpy(_buf + _len, s, n);
+        _len += n;
+        return *this;
+    }
+
+    FYWriter& raw(const char* s) { return s ? raw(s, strlen(s)) : *this; }
+
+    FYWriter& boolean(bool b) { return b ? raw("true", 4) : raw("false", 5); }
+
+    // ---- numbers -----------------------------------------------------------
+
+    FYWriter& u32(unsigned long v) {
+        char tmp[20];  // unsigned long is 64-bit in the host tools
+        int n = 0;
+        do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+        reserve(n);
+        while (n) _buf[_len++] = tmp[--n];
+        return *this;
+    }
+
+    FYWriter& i32(long v) {
+        if (v < 0) {
+            ch('-');
+            return u32(0UL - (unsigned long)v);
+        }
+        return u32((unsigned long)v);
+    }
+
+    // Same digits as printf("%.<decimals>f", v) for decimals 0..9
+    FYWriter& fixed(double v, int decimals) {
+        static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+        if (decimals < 0 || decimals > 9 || isnan(v) || isinf(v) || fabs(v) >= 1e9) {
+            return fixedSlow(v, decimals);
+        }
+        bool neg = signbit(v);
+        double a = fabs(v);
+        double ip = floor(a);
+        double scaled = (a - ip) * POW10[decimals];  // a - ip is exact
+        double fl = floor(scaled);
+        double rem = scaled - fl;
+        // The multiply above can be off by ~1 ulp; near a tie let libc decide
+        if (fabs(rem - 0.5) < 1e-6) return fixedSlow(v, decimals);
+        unsigned long ipart = (unsigned long)ip;
+        unsigned long frac = (unsigned long)fl + (rem > 0.5 ? 1 : 0);
+        if (frac >= (unsigned long)POW10[decimals]) {
+            frac -= (unsigned long)POW10[decimals];
+            ipart++;
+        }
+        if (neg) ch('-');
+        u32(ipart);
+        if (decimals) {
+            char tmp[10];
+            for (int i = decimals - 1; i >= 0; i--) {
+                tmp[i] = (char)('0' + frac % 10);
+                frac /= 10;
+            }
+            ch('.');
+            raw(tmp, decimals);
+        }
+        return *this;
+    }
+
+    // ---- escaped strings ---------------------------------------------------
+
+    FYWriter& json(const char* s) {
+        if (!s) return *this;
+        static const char HEX[] = "0123456789abcdef";
+        for (; *s; s++) {
+            unsigned char c = (unsigned char)*s;
+            if (c >= 0x20 && c != '"' && c != '\\') { ch((char)c); continue; }
+            switch (c) {
+                case '"':  raw("\\\"", 2); break;
+                case '\\': raw("\\\\", 2); break;
+                case '\n': raw("\\n", 2);  break;
+                case '\r': raw("\\r", 2);  break;
+                case '\t': raw("\\t", 2);  break;
+                case '\b': raw("\\b", 2);  break;
+                case '\f': raw("\\f", 2);  break;
+                default: {
+                    char u[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                    raw(u, 6);
+                }
+            }
+        }
+        return *this;
+    }
+
+    FYWriter& csv(const char* s) {
+        if (!s) return *this;
+        for (; *s; s++) {
+            if (*s == '"') ch('"');
+            ch(*s);
+        }
+        return *this;
+    }
+
+    FYWriter& xml(const char* s) {
+        if (!s) return *this;
+        for (; *s; s++) {
+            switch (*s) {
+                case '&':  raw("&amp;", 5);  break;
+                case '<':  raw("&lt;", 4);   break;
+                case '>':  raw("&gt;", 4);   break;
+                case '"':  raw("&quot;", 6); break;
+                case '\'': raw("&#39;", 5);  break;
+                default:   ch(*s);
+            }
+        }
+        return *this;
+    }
+
+private:
+    void reserve(size_t n) {
+        if (_len + n > N) flush();
+    }
+
+    FYWriter& fixedSlow(double v, int decimals) {
+        char tmp[48];
+        int n = snprintf(tmp, sizeof(tmp), "%.*f", decimals, v);
+        if (n > 0) raw(tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+        return *this;
+    }
+
+    Sink& _out;
+    char _buf[N];
+    size_t _len;
+};
@@ -0,0 +1,959 @@
+// ============================================================================
+// FLOCK-YOU: Convoy sync - mergeable detection records + delta protocol
+// ============================================================================
+// Several units in different vehicles share one detection table. Each record
+// is a state-based CRDT, so replicas converge whatever the order, timing or
+// duplication of what they exchange:
+//
+//   firstSeen  min                lastSeen  max
+//   count      per-node counters, summed (each node only bumps its own)
+//   meta       last-writer-wins on (ts, node): rssi, method, Raven, name, fw
+//   gps        last-writer-wins on (fix time, node): lat/lon, accuracy
+//
+// fySyncMerge() is commutative, associative and idempotent. Node ids are
+// random per boot, so a rebooted unit is a new writer and never reuses a
+// sequence number its peers have already seen.
+//
+// Times are convoy-clock ms: local millis() plus an offset that only moves
+// forward, adopting any peer clock that is ahead. Units that have heard each
+// other agree to within one packet's latency.
+//
+// Delta sync. Every local change gets a dot (node, ++seq); a record keeps the
+// newest dot from each node that touched it. A version vector (VV) holds the
+// highest seq seen per node. Nodes broadcast a SUMMARY: their VV plus the
+// peers they hear directly. A peer with newer records answers with a DELTA of
+// every record holding a dot above that VV, split into MTU-sized packets, the
+// last one carrying the sender's VV. The asker folds that VV into its own only
+// after every packet of the batch has arrived and merged, so a lost packet
+// just means the next summary asks again. Merging is idempotent, so
+// duplicates cost bytes and nothing else.
+//
+// Deltas are broadcast and the last packet also carries the VV being
+// answered, so any node that received the whole batch advances too - per
+// node, wherever it already had everything the asker had. Peers asking next
+// then find little or nothing left to send.
+//
+// Relaying: changes by a node the asker hears itself are left to that node,
+// and the closing VV omits it, so on a shared segment each change crosses the
+// air about once instead of once per peer. Through a hub (followers on a lead
+// unit's AP that do not hear each other) the hub relays.
+//
+// Records are never dropped, so a VV entry always means "every change by
+// that node up to here is in this table". The one exception is a record that
+// arrives with no room for it (table full, or too many writers): the batch is
+// still acknowledged, so the sender does not resend it forever, but that
+// record's writers are marked lossy and closing VVs stop vouching for them -
+// nobody advances past a change through a node that never stored it. A peer
+// that keeps asking for the same thing is answered with exponential back-off.
+//
+// Wire format (little-endian, var = LEB128, zz = zigzag var of an int32):
+//   header   'F' 'S'  u8 version  u8 type  u32 from  u32 to (0 = all)  u32 clock
+//   SUMMARY  vv  u8 n, n x u32 node heard directly
+//   DELTA    u16 batch  u8 index  u8 flags (LAST, PARTIAL)  u8 n  n x record
+//            [LAST: vv (sender's, minus skipped nodes)  vv (the one answered)]
+//   vv       u8 n, n x (u32 node, var seq)
+//   record   u8[6] mac  u8 flags (RAVEN, GPS)  zz clock-last  var last-first
+//            i8 rssi  u8 method  zz last-metaTs  u32 metaNode
+//            u8 len + name  u8 len + fw
+//            [GPS: zz clock-gpsTs  u32 gpsNode  i32 lat*1e7  i32 lon*1e7  u16 acc dm]
+//            u8 n, n x (u32 node, var count, var dot)
+//
+// Transport is anything implementing FYSyncLink::send(); received packets are
+// handed to FYSyncNode::receive(). Nothing is sent from receive() or tick():
+// summaries and delta replies are queued, and next() builds one packet at a
+// time so the caller can transmit without holding its lock (flush() does it
+// all in one go). A reply's closing VV is taken when it is queued, so records
+// changing between packets never make it claim more than it sent. Framing
+// for byte streams: fySlipEncode / FYSlipDecoder. Not thread-safe - the
+// caller serializes (fyMutex).
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define FY_SYNC_VERSION     1
+#define FY_SYNC_ORIGINS     12      // Writers per record (node boots)
+#define FY_SYNC_VV          32      // Nodes per version vector
+#define FY_SYNC_PEERS       8       // Peers tracked for batches / status
+#define FY_SYNC_LINKS       4
+#define FY_SYNC_MTU_MAX     1400
+#define FY_SYNC_BATCH_MAX   64      // Packets per delta (completion mask width)
+#define FY_SYNC_NAME        48
+#define FY_SYNC_FW          16
+#define FY_SYNC_PEER_MS     30000   // A link with a peer heard this recently gets summaries
+#define FY_SYNC_REPLIES     4       // Delta replies queued at once
+#define FY_SYNC_BACKOFF_MAX 5       // Unanswered-progress back-off: up to 2^5 summary periods
+
+#define FY_SYNC_HDR         16
+#define FY_SYNC_VV_MAX      (1 + FY_SYNC_VV * 9)
+#define FY_SYNC_REC_MAX     (6 + 1 + 5 + 5 + 1 + 1 + 5 + 4 + FY_SYNC_NAME + FY_SYNC_FW + \
+                             5 + 4 + 4 + 4 + 2 + 1 + FY_SYNC_ORIGINS * 14)
+// Smallest MTU that always fits one record plus the closing VVs
+#define FY_SYNC_MTU_MIN     (FY_SYNC_HDR + 5 + FY_SYNC_REC_MAX + 2 * FY_SYNC_VV_MAX)
+
+enum FYSyncType { FY_SYNC_SUMMARY = 1, FY_SYNC_DELTA = 2 };
+
+#define FY_SYNC_F_LAST      0x01
+#define FY_SYNC_F_PARTIAL   0x02    // Batch cap hit - merge, but do not advance the VV
+#define FY_SYNC_R_RAVEN     0x01
+#define FY_SYNC_R_GPS       0x02
+
+// ============================================================================
+// RECORD
+// ============================================================================
+
+struct FYSyncOrigin {
+    uint32_t node;
+    uint32_t count;     // Sightings by this node
+    uint32_t dot;       // Newest seq of this node that touched the record
+};
+
+struct FYSyncRec {
+    uint8_t  mac[6];
+    uint8_t  origins;
+    uint8_t  flags;
+    uint32_t firstSeen;     // Convoy clock
+    uint32_t lastSeen;
+    uint32_t metaTs;
+    uint32_t metaNode;
+    int8_t   rssi;
+    uint8_t  method;        // Caller's method index
+    char     name[FY_SYNC_NAME];
+    char     fw[FY_SYNC_FW];
+    uint32_t gpsTs;
+    uint32_t gpsNode;
+    int32_t  latE7;
+    int32_t  lonE7;
+    uint16_t accDm;
+    FYSyncOrigin org[FY_SYNC_ORIGINS];
+
+    // Bottom element: merging anything into it yields that thing
+    void reset(const uint8_t m[6]) {
+        memset(this, 0, sizeof(*this));
+        memcpy(mac, m, 6);
+        firstSeen = 0xFFFFFFFF;
+    }
+
+    uint32_t count() const {
+        uint32_t n = 0;
+        for (uint8_t i = 0; i < origins; i++) n += org[i].count;
+        return n;
+    }
+
+    FYSyncOrigin* origin(uint32_t node) {
+        for (uint8_t i = 0; i < origins; i++) if (org[i].node == node) return &org[i];
+        return NULL;
+    }
+    const FYSyncOrigin* origin(uint32_t node) const {
+        for (uint8_t i = 0; i < origins; i++) if (org[i].node == node) return &org[i];
+        return NULL;
+    }
+};
+
+static inline bool fySyncNewer(uint32_t ts, uint32_t node, uint32_t ts2, uint32_t node2) {
+    return ts != ts2 ? ts > ts2 : node > node2;
+}
+
+static inline void fySyncCopyStr(char* dst, size_t cap, const char* src) {
+    strncpy(dst, src ? src : "", cap - 1);
+    dst[cap - 1] = '\0';
+}
+
+enum FYSyncMerge { FY_SYNC_SAME, FY_SYNC_CHANGED, FY_SYNC_OVERFLOW };
+
+// d <- d merge s. OVERFLOW (d untouched) if the union has more writers than
+// a record holds.
+static inline FYSyncMerge fySyncMerge(FYSyncRec& d, const FYSyncRec& s) {
+    uint8_t add = 0;
+    for (uint8_t i = 0; i < s.origins; i++) if (!d.origin(s.org[i].node)) add++;
+    if (d.origins + add > FY_SYNC_ORIGINS) return FY_SYNC_OVERFLOW;
+
+    bool changed = false;
+    if (s.firstSeen < d.firstSeen) { d.firstSeen = s.firstSeen; changed = true; }
+    if (s.lastSeen > d.lastSeen) { d.lastSeen = s.lastSeen; changed = true; }
+    if (fySyncNewer(s.metaTs, s.metaNode, d.metaTs, d.metaNode)) {
+        d.metaTs = s.metaTs;
+        d.metaNode = s.metaNode;
+        d.rssi = s.rssi;
+        d.method = s.method;
+        d.flags = (uint8_t)((d.flags & ~FY_SYNC_R_RAVEN) | (s.flags & FY_SYNC_R_RAVEN));
+        memcpy(d.name, s.name, sizeof(d.name));
+        memcpy(d.fw, s.fw, sizeof(d.fw));
+        changed = true;
+    }
+    if ((s.flags & FY_SYNC_R_GPS) &&
+        (!(d.flags & FY_SYNC_R_GPS) || fySyncNewer(s.gpsTs, s.gpsNode, d.gpsTs, d.gpsNode))) {
+        d.gpsTs = s.gpsTs;
+        d.gpsNode = s.gpsNode;
+        d.latE7 = s.latE7;
+        d.lonE7 = s.lonE7;
+        d.accDm = s.accDm;
+        d.flags |= FY_SYNC_R_GPS;
+        changed = true;
+    }
+    for (uint8_t i = 0; i < s.origins; i++) {
+        const FYSyncOrigin& so = s.org[i];
+        FYSyncOrigin* o = d.origin(so.node);
+        if (!o) {
+            o = &d.org[d.origins++];
+            o->node = so.node;
+            o->count = o->dot = 0;
+        }
+        if (so.count > o->count) { o->count = so.count; changed = true; }
+        if (so.dot > o->dot) { o->dot = so.dot; changed = true; }
+    }
+    return changed ? FY_SYNC_CHANGED : FY_SYNC_SAME;
+}
+
+// ============================================================================
+// VERSION VECTOR
+// ============================================================================
+
+struct FYSyncVV {
+    uint8_t  n;
+    uint32_t node[FY_SYNC_VV];
+    uint32_t seq[FY_SYNC_VV];
+
+    void clear() { n = 0; }
+
+    uint32_t get(uint32_t id) const {
+        for (uint8_t i = 0; i < n; i++) if (node[i] == id) return seq[i];
+        return 0;
+    }
+
+    // Raise id to at least s. When full the lowest entry is dropped, which
+    // only makes peers resend what it covered.
+    void raise(uint32_t id, uint32_t s) {
+        uint8_t low = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            if (node[i] == id) { if (s > seq[i]) seq[i] = s; return; }
+            if (seq[i] < seq[low]) low = i;
+        }
+        uint8_t i = n < FY_SYNC_VV ? n++ : low;
+        node[i] = id;
+        seq[i] = s;
+    }
+
+    void merge(const FYSyncVV& o) {
+        for (uint8_t i = 0; i < o.n; i++) raise(o.node[i], o.seq[i]);
+    }
+
+    bool has(uint32_t id) const {
+        for (uint8_t i = 0; i < n; i++) if (node[i] == id) return true;
+        return false;
+    }
+
+    // r holds a change this VV has not seen, by a node not in `skip`
+    bool behind(const FYSyncRec& r, const FYSyncVV* skip = NULL) const {
+        for (uint8_t i = 0; i < r.origins; i++) {
+            if (r.org[i].dot > get(r.org[i].node) && !(skip && skip->has(r.org[i].node))) return true;
+        }
+        return false;
+    }
+};
+
+// ============================================================================
+// CODEC
+// ============================================================================
+
+struct FYSyncWriter {
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    bool over;
+
+    FYSyncWriter(uint8_t* b, size_t c) : buf(b), cap(c), len(0), over(false) {}
+
+    void put(const void* p, size_t n) {
+        if (over || len + n > cap) { over = true; return; }
+        memcpy(buf + len, p, n);
+        len += n;
+    }
+    void u8(uint8_t v) { put(&v, 1); }
+    void u16(uint16_t v) { uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)}; put(b, 2); }
+    void u32(uint32_t v) {
+        uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+        put(b, 4);
+    }
+    void var(uint32_t v) {
+        while (v >= 0x80) { u8((uint8_t)(v | 0x80)); v >>= 7; }
+        u8((uint8_t)v);
+    }
+    void zz(int32_t v) { var(((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+    void str(const char* s, size_t cap) {
+        size_t n = strnlen(s, cap - 1);
+        u8((uint8_t)n);
+        put(s, n);
+    }
+    void rewind(size_t mark) { len = mark; over = false; }
+};
+
+struct FYSyncReader {
+    const uint8_t* buf;
+    size_t len;
+    size_t off;
+    bool bad;
+
+    FYSyncReader(const uint8_t* b, size_t n) : buf(b), len(n), off(0), bad(false) {}
+
+    bool get(void* p, size_t n) {
+        if (bad || off + n > len) { bad = true; memset(p, 0, n); return false; }
+        memcpy(p, buf + off, n);
+        off += n;
+        return true;
+    }
+    uint8_t u8() { uint8_t v; get(&v, 1); return v; }
+    uint16_t u16() { uint8_t b[2]; get(b, 2); return (uint16_t)(b[0] | (b[1] << 8)); }
+    uint32_t u32() {
+        uint8_t b[4];
+        get(b, 4);
+        return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+    uint32_t var() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = u8();
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        bad = true;
+        return 0;
+    }
+    int32_t zz() { uint32_t v = var(); return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+    void str(char* out, size_t cap) {
+        size_t n = u8();
+        if (n >= cap) { bad = true; n = 0; }
+        get(out, n);
+        out[n] = '\0';
+    }
+};
+
+static inline void fySyncPutVV(FYSyncWriter& w, const FYSyncVV& vv) {
+    w.u8(vv.n);
+    for (uint8_t i = 0; i < vv.n; i++) { w.u32(vv.node[i]); w.var(vv.seq[i]); }
+}
+
+static inline void fySyncGetVV(FYSyncReader& r, FYSyncVV& vv) {
+    vv.n = r.u8();
+    if (vv.n > FY_SYNC_VV) { r.bad = true; vv.n = 0; return; }
+    for (uint8_t i = 0; i < vv.n; i++) { vv.node[i] = r.u32(); vv.seq[i] = r.var(); }
+}
+
+static inline void fySyncPutRec(FYSyncWriter& w, const FYSyncRec& r, uint32_t clock) {
+    w.put(r.mac, 6);
+    w.u8(r.flags);
+    w.zz((int32_t)(clock - r.lastSeen));
+    w.var(r.lastSeen - r.firstSeen);
+    w.u8((uint8_t)r.rssi);
+    w.u8(r.method);
+    w.zz((int32_t)(r.lastSeen - r.metaTs));
+    w.u32(r.metaNode);
+    w.str(r.name, sizeof(r.name));
+    w.str(r.fw, sizeof(r.fw));
+    if (r.flags & FY_SYNC_R_GPS) {
+        w.zz((int32_t)(clock - r.gpsTs));
+        w.u32(r.gpsNode);
+        w.u32((uint32_t)r.latE7);
+        w.u32((uint32_t)r.lonE7);
+        w.u16(r.accDm);
+    }
+    w.u8(r.origins);
+    for (uint8_t i = 0; i < r.origins; i++) {
+        w.u32(r.org[i].node);
+        w.var(r.org[i].count);
+        w.var(r.org[i].dot);
+    }
+}
+
+static inline bool fySyncGetRec(FYSyncReader& rd, FYSyncRec& r, uint32_t clock) {
+    uint8_t mac[6];
+    rd.get(mac, 6);
+    r.reset(mac);
+    r.flags = rd.u8();
+    r.lastSeen = clock - (uint32_t)rd.zz();
+    r.firstSeen = r.lastSeen - rd.var();
+    r.rssi = (int8_t)rd.u8();
+    r.method = rd.u8();
+    r.metaTs = r.lastSeen - (uint32_t)rd.zz();
+    r.metaNode = rd.u32();
+    rd.str(r.name, sizeof(r.name));
+    rd.str(r.fw, sizeof(r.fw));
+    if (r.flags & FY_SYNC_R_GPS) {
+        r.gpsTs = clock - (uint32_t)rd.zz();
+        r.gpsNode = rd.u32();
+        r.latE7 = (int32_t)rd.u32();
+        r.lonE7 = (int32_t)rd.u32();
+        r.accDm = rd.u16();
+    }
+    r.origins = rd.u8();
+    if (r.origins > FY_SYNC_ORIGINS) { rd.bad = true; r.origins = 0; }
+    for (uint8_t i = 0; i < r.origins; i++) {
+        r.org[i].node = rd.u32();
+        r.org[i].count = rd.var();
+        r.org[i].dot = rd.var();
+    }
+    return !rd.bad;
+}
+
+// ============================================================================
+// SLIP FRAMING (byte-stream links)
+// ============================================================================
+
+#define FY_SLIP_END      0xC0
+#define FY_SLIP_ESC      0xDB
+#define FY_SLIP_ESC_END  0xDC
+#define FY_SLIP_ESC_ESC  0xDD
+
+// END + escaped payload + END; 0 if out is too small (worst case 2n + 2)
+static inline size_t fySlipEncode(const uint8_t* in, size_t n, uint8_t* out, size_t cap) {
+    size_t o = 0;
+    if (cap < 2) return 0;
+    out[o++] = FY_SLIP_END;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t c = in[i];
+        if (c == FY_SLIP_END || c == FY_SLIP_ESC) {
+            if (o + 2 > cap - 1) return 0;
+            out[o++] = FY_SLIP_ESC;
+            out[o++] = c == FY_SLIP_END ? FY_SLIP_ESC_END : FY_SLIP_ESC_ESC;
+        } else {
+            if (o + 1 > cap - 1) return 0;
+            out[o++] = c;
+        }
+    }
+    out[o++] = FY_SLIP_END;
+    return o;
+}
+
+// Feed received bytes one at a time; feed() returns the frame length when a
+// frame completes (frame() holds it until the next feed). Oversized or
+// malformed frames are dropped whole.
+class FYSlipDecoder {
+public:
+    FYSlipDecoder(uint8_t* buf, size_t cap) : _buf(buf), _cap(cap), _len(0), _esc(false), _drop(false) {}
+
+    size_t feed(uint8_t c) {
+        if (c == FY_SLIP_END) {
+            size_t n = _drop ? 0 : _len;
+            _len = 0;
+            _esc = _drop = false;
+            return n;
+        }
+        if (_drop) return 0;
+        if (_esc) {
+            _esc = false;
+            if (c == FY_SLIP_ESC_END) c = FY_SLIP_END;
+            else if (c == FY_SLIP_ESC_ESC) c = FY_SLIP_ESC;
+            else { _drop = true; return 0; }
+        } else if (c == FY_SLIP_ESC) {
+            _esc = true;
+            return 0;
+        }
+        if (_len >= _cap) { _drop = true; return 0; }
+        _buf[_len++] = c;
+        return 0;
+    }
+
+    const uint8_t* frame() const { return _buf; }
+
+private:
+    uint8_t* _buf;
+    size_t _cap;
+    size_t _len;
+    bool _esc;
+    bool _drop;
+};
+
+// ============================================================================
+// TRANSPORT + NODE
+// ============================================================================
+
+class FYSyncLink {
+public:
+    virtual ~FYSyncLink() {}
+    virtual const char* name() const = 0;
+    virtual size_t mtu() const = 0;
+    // One packet to every peer on the link
+    virtual bool send(const uint8_t* buf, size_t len) = 0;
+    // Send summaries before any peer has been heard (uplinks, cables)
+    virtual bool announce() const { return true; }
+};
+
+struct FYSyncSighting {
+    uint8_t mac[6];
+    int8_t rssi;
+    uint8_t method;
+    bool raven;
+    const char* name;       // Empty keeps the merged name
+    const char* fw;
+    bool gps;
+    uint32_t gpsLocalMs;    // millis() of the fix
+    int32_t latE7;
+    int32_t lonE7;
+    uint16_t accDm;
+};
+
+struct FYSyncStats {
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint32_t txPackets;
+    uint32_t rxPackets;
+    uint32_t sendFails;
+    uint32_t summaries;     // Sent
+    uint32_t deltas;        // Delta batches sent
+    uint32_t batches;       // Delta batches fully merged (any asker)
+    uint32_t merged;        // Records changed by a remote merge
+    uint32_t overflow;      // Merges refused: too many writers for one record
+    uint32_t full;          // Remote records with no room in the table
+    uint32_t bad;           // Malformed packets
+    uint32_t backoffs;      // Summaries left unanswered: peer made no progress
+    uint32_t replyDrops;    // Summaries left unanswered: reply queue full
+};
+
+struct FYSyncPeer {
+    uint32_t node;          // 0 = free
+    uint8_t  link;
+    uint32_t heardMs;
+    // Delta batch from this peer in progress
+    bool     active;
+    bool     haveLast;
+    bool     failed;
+    bool     partial;
+    uint16_t batch;
+    uint8_t  total;
+    uint64_t mask;
+    FYSyncVV vv;            // Sender's VV, minus the nodes it skipped
+    FYSyncVV want;          // The summary it answered
+    // Our answers to its summaries
+    bool     answered;
+    uint32_t askedSum;      // Sum of the VV we last answered...
+    uint32_t heldSum;       // ...and of ours at the time
+    uint32_t answeredMs;
+    uint8_t  backoff;       // Answer a repeat at most every summaryMs << backoff
+};
+
+// A delta being sent, one packet per next()
+struct FYSyncReply {
+    uint8_t  link;
+    uint32_t to;
+    uint16_t batch;
+    uint8_t  idx;           // Next packet
+    size_t   cursor;        // Next record to consider
+    FYSyncVV want;          // The summary being answered
+    FYSyncVV skip;          // Nodes the asker hears itself
+    FYSyncVV close;         // Our VV when queued, minus skipped and lossy nodes
+};
+
+class FYSyncNode {
+public:
+    FYSyncNode() : _self(0), _recs(NULL), _cap(0), _count(0), _offset(0), _seq(0), _batch(0),
+                   _links(0), _lastSummaryMs(0), _summaryDue(0), _replyHead(0), _replies(0),
+                   _lossyAll(false), summaryMs(2000) {
+        _vv.clear();
+        _lossy.clear();
+        memset(&_stats, 0, sizeof(_stats));
+        memset(_peers, 0, sizeof(_peers));
+    }
+
+    void init(uint32_t self, FYSyncRec* mem, size_t cap) {
+        _self = self;
+        _recs = mem;
+        _cap = mem ? cap : 0;
+        _count = 0;
+    }
+
+    // -1 if the link's MTU cannot carry a worst-case record
+    int addLink(FYSyncLink* l) {
+        if (_links >= FY_SYNC_LINKS || l->mtu() < FY_SYNC_MTU_MIN) return -1;
+        _link[_links] = l;
+        return _links++;
+    }
+
+    uint32_t self() const { return _self; }
+    uint32_t clock(uint32_t localMs) const { return localMs + _offset; }
+    uint32_t offset() const { return _offset; }
+    uint32_t seq() const { return _seq; }
+    size_t size() const { return _count; }
+    size_t capacity() const { return _cap; }
+    const FYSyncRec& at(size_t i) const { return _recs[i]; }
+    const FYSyncVV& vv() const { return _vv; }
+    const FYSyncStats& stats() const { return _stats; }
+    const FYSyncPeer& peer(size_t i) const { return _peers[i]; }
+    size_t links() const { return _links; }
+    const FYSyncLink* link(size_t i) const { return _link[i]; }
+    FYSyncLink* link(size_t i) { return _link[i]; }
+    // Writers whose changes this node lost for want of room (n = 0: none)
+    const FYSyncVV& lossy() const { return _lossy; }
+    bool lossyAll() const { return _lossyAll; }
+    bool pending() const { return _summaryDue || _replies; }
+
+    // Peers heard on a link within FY_SYNC_PEER_MS
+    size_t peersOn(uint8_t link, uint32_t localMs) const {
+        size_t n = 0;
+        for (size_t i = 0; i < FY_SYNC_PEERS; i++) {
+            if (_peers[i].node && _peers[i].link == link &&
+                localMs - _peers[i].heardMs < FY_SYNC_PEER_MS) n++;
+        }
+        return n;
+    }
+
+    const FYSyncRec* find(const uint8_t mac[6]) const {
+        for (size_t i = 0; i < _count; i++) if (memcmp(_recs[i].mac, mac, 6) == 0) return &_recs[i];
+        return NULL;
+    }
+
+    // This unit saw the device. NULL if the table (or the record's writer
+    // list) is full.
+    const FYSyncRec* observe(const FYSyncSighting& s, uint32_t localMs) {
+        FYSyncRec* r = upsert(s.mac);
+        if (!r) return NULL;
+        FYSyncOrigin* o = r->origin(_self);
+        if (!o) {
+            if (r->origins >= FY_SYNC_ORIGINS) { _stats.overflow++; return NULL; }
+            o = &r->org[r->origins++];
+            o->node = _self;
+            o->count = o->dot = 0;
+        }
+        uint32_t now = clock(localMs);
+        if (now < r->firstSeen) r->firstSeen = now;
+        if (now > r->lastSeen) r->lastSeen = now;
+
+        uint32_t ts = now;
+        if (!fySyncNewer(ts, _self, r->metaTs, r->metaNode)) ts = r->metaTs + 1;
+        r->metaTs = ts;
+        r->metaNode = _self;
+        r->rssi = s.rssi;
+        r->method = s.method;
+        r->flags = (uint8_t)((r->flags & ~FY_SYNC_R_RAVEN) | (s.raven ? FY_SYNC_R_RAVEN : 0));
+        if (s.name && s.name[0]) fySyncCopyStr(r->name, sizeof(r->name), s.name);
+        if (s.fw && s.fw[0]) fySyncCopyStr(r->fw, sizeof(r->fw), s.fw);
+
+        if (s.gps) {
+            uint32_t t = clock(s.gpsLocalMs);
+            if (!(r->flags & FY_SYNC_R_GPS) || fySyncNewer(t, _self, r->gpsTs, r->gpsNode)) {
+                r->gpsTs = t;
+                r->gpsNode = _self;
+                r->latE7 = s.latE7;
+                r->lonE7 = s.lonE7;
+                r->accDm = s.accDm;
+                r->flags |= FY_SYNC_R_GPS;
+            }
+        }
+        o->count++;
+        o->dot = ++_seq;
+        _vv.raise(_self, _seq);
+        return r;
+    }
+
+    // Periodic: queue summaries on links that have a peer (or always announce)
+    void tick(uint32_t localMs) {
+        if (localMs - _lastSummaryMs < summaryMs) return;
+        _lastSummaryMs = localMs;
+        for (uint8_t l = 0; l < _links; l++) {
+            if (_link[l]->announce() || heardOn(l, localMs)) _summaryDue |= (uint8_t)(1 << l);
+        }
+    }
+
+    // Build the next queued packet into buf (cap >= the link's MTU) and
+    // return its length, 0 when the queue is empty. Summaries go first.
+    // Report the send with sent().
+    size_t next(uint8_t* buf, size_t cap, uint8_t* link, uint32_t localMs) {
+        for (uint8_t l = 0; l < _links; l++) {
+            if (!(_summaryDue & (1 << l))) continue;
+            _summaryDue &= (uint8_t)~(1 << l);
+            *link = l;
+            return buildSummary(buf, cap, l, localMs);
+        }
+        if (!_replies) return 0;
+        FYSyncReply& q = _reply[_replyHead];
+        *link = q.link;
+        bool last;
+        size_t n = buildDelta(q, buf, cap, localMs, &last);
+        if (last) {
+            _replyHead = (uint8_t)((_replyHead + 1) % FY_SYNC_REPLIES);
+            _replies--;
+            _stats.deltas++;
+        }
+        return n;
+    }
+
+    void sent(size_t len, bool ok) {
+        if (ok) {
+            _stats.txPackets++;
+            _stats.txBytes += len;
+        } else {
+            _stats.sendFails++;
+        }
+    }
+
+    // Send everything queued, for callers that can transmit under their lock
+    void flush(uint32_t localMs) {
+        uint8_t l;
+        size_t n;
+        while ((n = next(_tx, sizeof(_tx), &l, localMs)) > 0) sent(n, _link[l]->send(_tx, n));
+    }
+
+    // One received packet. changed(rec) is called for every record a remote
+    // merge modified.
+    template <typename Fn>
+    void receive(uint8_t link, const uint8_t* buf, size_t len, uint32_t localMs, Fn changed) {
+        _stats.rxPackets++;
+        _stats.rxBytes += len;
+        FYSyncReader rd(buf, len);
+        uint8_t m0 = rd.u8(), m1 = rd.u8(), ver = rd.u8(), type = rd.u8();
+        uint32_t from = rd.u32(), to = rd.u32(), peerClock = rd.u32();
+        if (rd.bad || m0 != 'F' || m1 != 'S' || ver != FY_SYNC_VERSION || !from) { _stats.bad++; return; }
+        if (from == _self || (to && to != _self && type == FY_SYNC_SUMMARY)) return;
+        if ((int32_t)(peerClock - clock(localMs)) > 0) _offset = peerClock - localMs;
+        FYSyncPeer* p = peerFor(from, link, localMs);
+
+        if (type == FY_SYNC_SUMMARY) {
+            FYSyncVV& want = _wantVV;
+            fySyncGetVV(rd, want);
+            // Nodes it hears itself (we are on its list too, but answer for ourselves)
+            FYSyncVV& skip = _skipVV;
+            skip.clear();
+            uint8_t heard = rd.u8();
+            for (uint8_t i = 0; i < heard && i < FY_SYNC_PEERS; i++) {
+                uint32_t id = rd.u32();
+                if (id != _self) skip.raise(id, 0);
+            }
+            if (rd.bad) { _stats.bad++; return; }
+            for (size_t i = 0; i < _count; i++) {
+                if (want.behind(_recs[i], &skip)) { queueDelta(*p, link, want, skip, localMs); break; }
+            }
+            return;
+        }
+        if (type != FY_SYNC_DELTA) { _stats.bad++; return; }
+
+        uint16_t batch = rd.u16();
+        uint8_t idx = rd.u8(), flags = rd.u8(), n = rd.u8();
+        if (rd.bad || idx >= FY_SYNC_BATCH_MAX) { _stats.bad++; return; }
+        if (!p->active || p->batch != batch) {
+            p->active = true;
+            p->batch = batch;
+            p->mask = 0;
+            p->haveLast = p->failed = p->partial = false;
+        }
+
+        // No room for a record: acknowledge it anyway (see lossy above)
+        bool failed = false;
+        for (uint8_t i = 0; i < n; i++) {
+            if (!fySyncGetRec(rd, _rx, peerClock)) { failed = true; _stats.bad++; break; }
+            FYSyncRec* r = upsert(_rx.mac);
+            if (!r) { _stats.full++; dropped(_rx); continue; }
+            FYSyncMerge m = fySyncMerge(*r, _rx);
+            if (m == FY_SYNC_OVERFLOW) { _stats.overflow++; dropped(_rx); continue; }
+            if (m == FY_SYNC_CHANGED) { _stats.merged++; changed(*r); }
+        }
+        p->mask |= (uint64_t)1 << idx;
+        p->failed |= failed;
+        if (flags & FY_SYNC_F_LAST) {
+            if (!rd.bad) fySyncGetVV(rd, p->vv);
+            if (!rd.bad) fySyncGetVV(rd, p->want);
+            if (rd.bad) p->failed = true;
+            p->haveLast = true;
+            p->total = (uint8_t)(idx + 1);
+            p->partial = (flags & FY_SYNC_F_PARTIAL) != 0;
+        }
+        uint64_t all = p->total >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << p->total) - 1);
+        if (p->haveLast && (p->mask & all) == all) {
+            // The batch held every change by node k in (want[k], vv[k]]
+            if (!p->failed && !p->partial) {
+                for (uint8_t k = 0; k < p->vv.n; k++) {
+                    if (_vv.get(p->vv.node[k]) >= p->want.get(p->vv.node[k])) {
+                        _vv.raise(p->vv.node[k], p->vv.seq[k]);
+                    }
+                }
+                _stats.batches++;
+            }
+            p->active = false;
+        }
+    }
+
+private:
+    FYSyncRec* upsert(const uint8_t mac[6]) {
+        FYSyncRec* r = const_cast<FYSyncRec*>(find(mac));
+        if (r) return r;
+        if (_count >= _cap) return NULL;
+        r = &_recs[_count++];
+        r->reset(mac);
+        return r;
+    }
+
+    bool heardOn(uint8_t link, uint32_t localMs) const { return peersOn(link, localMs) != 0; }
+
+    FYSyncPeer* peerFor(uint32_t node, uint8_t link, uint32_t localMs) {
+        // Known peer, else a free slot, else the one heard longest ago
+        FYSyncPeer* slot = NULL;
+        for (size_t i = 0; i < FY_SYNC_PEERS && !slot; i++) if (_peers[i].node == node) slot = &_peers[i];
+        for (size_t i = 0; i < FY_SYNC_PEERS && !slot; i++) if (!_peers[i].node) slot = &_peers[i];
+        if (!slot) {
+            slot = &_peers[0];
+            for (size_t i = 1; i < FY_SYNC_PEERS; i++) {
+                if (localMs - _peers[i].heardMs > localMs - slot->heardMs) slot = &_peers[i];
+            }
+        }
+        if (slot->node != node) {
+            memset(slot, 0, sizeof(*slot));
+            slot->node = node;
+        }
+        slot->link = link;
+        slot->heardMs = localMs;
+        return slot;
+    }
+
+    // r had no room here: stop vouching for its writers. Our own changes are
+    // always in the table, so we still vouch for ourselves.
+    void dropped(const FYSyncRec& r) {
+        for (uint8_t i = 0; i < r.origins; i++) {
+            uint32_t id = r.org[i].node;
+            if (id == _self || _lossy.has(id)) continue;
+            if (_lossy.n >= FY_SYNC_VV) _lossyAll = true;
+            else _lossy.raise(id, 1);
+        }
+    }
+
+    bool vouches(uint32_t id) const {
+        return id == _self || (!_lossyAll && !_lossy.has(id));
+    }
+
+    void header(FYSyncWriter& w, uint8_t type, uint32_t to, uint32_t localMs) {
+        w.u8('F'); w.u8('S'); w.u8(FY_SYNC_VERSION); w.u8(type);
+        w.u32(_self); w.u32(to); w.u32(clock(localMs));
+    }
+
+    size_t mtuFor(uint8_t link, size_t cap) const {
+        return _link[link]->mtu() < cap ? _link[link]->mtu() : cap;
+    }
+
+    size_t buildSummary(uint8_t* buf, size_t cap, uint8_t link, uint32_t localMs) {
+        FYSyncWriter w(buf, mtuFor(link, cap));
+        header(w, FY_SYNC_SUMMARY, 0, localMs);
+        fySyncPutVV(w, _vv);
+        size_t countAt = w.len;
+        uint8_t n = 0;
+        w.u8(0);
+        for (size_t i = 0; i < FY_SYNC_PEERS; i++) {
+            const FYSyncPeer& p = _peers[i];
+            if (p.node && p.link == link && localMs - p.heardMs < FY_SYNC_PEER_MS) { w.u32(p.node); n++; }
+        }
+        buf[countAt] = n;
+        _stats.summaries++;
+        return w.len;
+    }
+
+    static uint32_t vvSum(const FYSyncVV& vv) {
+        uint32_t sum = 0;
+        for (uint8_t k = 0; k < vv.n; k++) sum += vv.seq[k];
+        return sum;
+    }
+
+    // Answer p's summary unless a reply to it is already queued, the queue
+    // is full, or it is a repeat - same summary, nothing new here since the
+    // last answer - that came too soon (exponential back-off)
+    void queueDelta(FYSyncPeer& p, uint8_t link, const FYSyncVV& want, const FYSyncVV& skip,
+                    uint32_t localMs) {
+        for (uint8_t i = 0; i < _replies; i++) {
+            const FYSyncReply& q = _reply[(_replyHead + i) % FY_SYNC_REPLIES];
+            if (q.to == p.node && q.link == link) return;
+        }
+        uint32_t sum = vvSum(want), held = vvSum(_vv);
+        if (p.answered && sum == p.askedSum && held == p.heldSum) {
+            if (localMs - p.answeredMs < (summaryMs << p.backoff)) { _stats.backoffs++; return; }
+            if (p.backoff < FY_SYNC_BACKOFF_MAX) p.backoff++;
+        } else {
+            p.backoff = 0;
+        }
+        if (_replies >= FY_SYNC_REPLIES) { _stats.replyDrops++; return; }
+
+        FYSyncReply& q = _reply[(_replyHead + _replies++) % FY_SYNC_REPLIES];
+        q.link = link;
+        q.to = p.node;
+        q.batch = ++_batch;
+        q.idx = 0;
+        q.cursor = 0;
+        q.want = want;
+        q.skip = skip;
+        q.close.clear();
+        for (uint8_t k = 0; k < _vv.n; k++) {
+            if (!skip.has(_vv.node[k]) && vouches(_vv.node[k])) q.close.raise(_vv.node[k], _vv.seq[k]);
+        }
+        p.answered = true;
+        p.askedSum = sum;
+        p.heldSum = held;
+        p.answeredMs = localMs;
+    }
+
+    // Next packet of q: everything `want` has not seen from nodes outside
+    // `skip`, up to the batch cap. Only the last packet carries the closing
+    // VV and `want`.
+    size_t buildDelta(FYSyncReply& q, uint8_t* buf, size_t cap, uint32_t localMs, bool* last) {
+        size_t mtu = mtuFor(q.link, cap);
+        bool final = q.idx == FY_SYNC_BATCH_MAX - 1;
+        FYSyncWriter w(buf, final ? mtu - 2 * FY_SYNC_VV_MAX : mtu);
+        header(w, FY_SYNC_DELTA, q.to, localMs);
+        w.u16(q.batch);
+        w.u8(q.idx);
+        size_t flagsAt = w.len;
+        w.u8(0);
+        size_t countAt = w.len;
+        w.u8(0);
+        uint32_t clk = clock(localMs);
+        uint8_t n = 0;
+        size_t& i = q.cursor;
+        for (; i < _count && n < 255; i++) {
+            if (!q.want.behind(_recs[i], &q.skip)) continue;
+            size_t mark = w.len;
+            fySyncPutRec(w, _recs[i], clk);
+            if (w.over) { w.rewind(mark); break; }
+            n++;
+        }
+        while (i < _count && !q.want.behind(_recs[i], &q.skip)) i++;
+        bool done = i >= _count;
+
+        uint8_t flags = 0;
+        if (done || final) {
+            w.cap = mtu;
+            size_t mark = w.len;
+            fySyncPutVV(w, q.close);
+            fySyncPutVV(w, q.want);
+            if (w.over) w.rewind(mark);
+            else flags = FY_SYNC_F_LAST | (done ? 0 : FY_SYNC_F_PARTIAL);
+        }
+        buf[flagsAt] = flags;
+        buf[countAt] = n;
+        q.idx++;
+        *last = (flags & FY_SYNC_F_LAST) || final;
+        return w.len;
+    }
+
+    uint32_t _self;
+    FYSyncRec* _recs;
+    size_t _cap;
+    size_t _count;
+    uint32_t _offset;
+    uint32_t _seq;
+    uint16_t _batch;
+    uint8_t _links;
+    uint32_t _lastSummaryMs;
+    uint8_t _summaryDue;    // Bit per link
+    uint8_t _replyHead;
+    uint8_t _replies;
+    bool _lossyAll;         // More lossy writers than _lossy holds
+    FYSyncVV _vv;
+    FYSyncVV _wantVV;
+    FYSyncVV _skipVV;
+    FYSyncVV _lossy;
+    FYSyncStats _stats;
+    FYSyncPeer _peers[FY_SYNC_PEERS];
+    FYSyncReply _reply[FY_SYNC_REPLIES];
+    FYSyncLink* _link[FY_SYNC_LINKS];
+    FYSyncRec _rx;
+    uint8_t _tx[FY_SYNC_MTU_MAX];
+
+public:
+    uint32_t summaryMs;     // Summary period per link
+};
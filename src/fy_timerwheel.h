@@ -0,0 +1,107 @@
+// ============================================================================
+// FLOCK-YOU: Hierarchical timer wheel
+// ============================================================================
+// One timer per id (0..N-1), fired from a periodic tick. Two levels of 64
+// slots: level 0 holds timers due within 64 ticks, level 1 holds later ones
+// in 64-tick buckets and is cascaded down once per 64 ticks. With the 500 ms
+// radio tick that is 32 s at full resolution and ~34 min overall; anything
+// further out parks in the last level-1 bucket and is re-filed on cascade.
+//
+// Timers live in intrusive doubly-linked lists (index arrays, no heap), so
+// schedule / reschedule / cancel are O(1) and a tick only touches the slot
+// that is due - cost does not depend on how many timers are armed.
+// Not thread-safe; the caller serializes (fyMutex in main.cpp).
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FY_WHEEL_BITS   6
+#define FY_WHEEL_SLOTS  (1u << FY_WHEEL_BITS)
+#define FY_WHEEL_MASK   (FY_WHEEL_SLOTS - 1)
+#define FY_WHEEL_SPAN   (FY_WHEEL_SLOTS * FY_WHEEL_SLOTS)
+#define FY_WHEEL_NONE   0xFFFF
+#define FY_WHEEL_IDLE   0xFF
+
+template <size_t N>
+class FYTimerWheel {
+    static_assert(N < FY_WHEEL_NONE, "ids are 16-bit");
+
+public:
+    FYTimerWheel() { reset(0); }
+
+    // Drop every timer; the wheel's clock restarts at tick
+    void reset(uint32_t tick) {
+        _now = tick;
+        for (size_t i = 0; i < 2 * FY_WHEEL_SLOTS; i++) _head[i] = FY_WHEEL_NONE;
+        for (size_t i = 0; i < N; i++) _slot[i] = FY_WHEEL_IDLE;
+    }
+
+    // (Re)arm id to fire `ticks` from now (at least one tick)
+    void schedule(uint16_t id, uint32_t ticks) {
+        cancel(id);
+        _expire[id] = _now + (ticks ? ticks : 1);
+        file(id);
+    }
+
+    void cancel(uint16_t id) {
+        uint8_t s = _slot[id];
+        if (s == FY_WHEEL_IDLE) return;
+        if (_prev[id] == FY_WHEEL_NONE) _head[s] = _next[id];
+        else _next[_prev[id]] = _next[id];
+        if (_next[id] != FY_WHEEL_NONE) _prev[_next[id]] = _prev[id];
+        _slot[id] = FY_WHEEL_IDLE;
+    }
+
+    bool armed(uint16_t id) const { return _slot[id] != FY_WHEEL_IDLE; }
+    uint32_t now() const { return _now; }
+
+    // Move the clock one tick and call fire(id) for each timer now due.
+    // fire may schedule or cancel any timer, including the one firing: due
+    // timers are unlinked one at a time from the live slot, never walked as
+    // a detached list. A (re)scheduled timer is at least one tick out, so it
+    // never lands back in the slot being drained.
+    template <typename Fn>
+    void advance(Fn fire) {
+        _now++;
+        uint16_t id;
+        if ((_now & FY_WHEEL_MASK) == 0) {
+            uint8_t s = (uint8_t)(FY_WHEEL_SLOTS + ((_now >> FY_WHEEL_BITS) & FY_WHEEL_MASK));
+            while ((id = _head[s]) != FY_WHEEL_NONE) {
+                cancel(id);
+                file(id);
+            }
+        }
+        uint8_t s = (uint8_t)(_now & FY_WHEEL_MASK);
+        while ((id = _head[s]) != FY_WHEEL_NONE) {
+            cancel(id);
+            fire(id);
+        }
+    }
+
+private:
+    void file(uint16_t id) {
+        uint32_t delta = _expire[id] - _now;
+        uint8_t s;
+        if (delta < FY_WHEEL_SLOTS) {
+            s = (uint8_t)(_expire[id] & FY_WHEEL_MASK);
+        } else {
+            uint32_t at = delta < FY_WHEEL_SPAN ? _expire[id] : _now + FY_WHEEL_SPAN - FY_WHEEL_SLOTS;
+            s = (uint8_t)(FY_WHEEL_SLOTS + ((at >> FY_WHEEL_BITS) & FY_WHEEL_MASK));
+        }
+        _slot[id] = s;
+        _prev[id] = FY_WHEEL_NONE;
+        _next[id] = _head[s];
+        if (_head[s] != FY_WHEEL_NONE) _prev[_head[s]] = id;
+        _head[s] = id;
+    }
+
+    uint32_t _now;
+    uint16_t _head[2 * FY_WHEEL_SLOTS];
+    uint32_t _expire[N];
+    uint16_t _next[N];
+    uint16_t _prev[N];
+    uint8_t  _slot[N];
+};
@@ -0,0 +1,119 @@
+// ============================================================================
+// FLOCK-YOU: Per-address verdict cache
+// ============================================================================
+// Phones, watches and trackers re-advertise every 100-300 ms with the same
+// payload. Once an advert has run the full MAC/name/manufacturer/Raven
+// pipeline and come back negative, remember (address, payload hash) so the
+// next identical advert is dropped after one hash and an 8-slot probe.
+//
+// Fixed memory: Buckets x 4 slots, each 12 bytes. Every address hashes to
+// two candidate buckets (two-choice / cuckoo-style placement); when both are
+// full the stalest of the 8 slots is replaced, so insert is O(1) with no
+// kick chains. Entries age out after ttlSec, and any payload change for the
+// same address (e.g. a scan response adding a name) replaces the entry.
+//
+// Only NEGATIVE verdicts are cached - targets always reach fyAddDetection
+// so counts, RSSI and GPS stay current.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define FY_VERDICT_WAYS 4
+
+static inline uint32_t fyVerdictHash(const uint8_t* p, size_t n) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+template <size_t Buckets>
+class FYVerdictCache {
+    static_assert((Buckets & (Buckets - 1)) == 0, "Buckets must be a power of two");
+
+public:
+    explicit FYVerdictCache(uint16_t ttlSec = 60) : _ttl(ttlSec) { clear(); }
+
+    void clear() { memset(_slots, 0, sizeof(_slots)); }
+
+    // True if this exact (address, payload) was judged a non-target recently
+    bool lookup(const uint8_t addr[6], uint32_t payloadHash, uint16_t nowSec) const {
+        uint32_t h = addrHash(addr);
+        const Slot* s = find(h, addr);
+        return s && s->payload == (payloadHash & 0x7FFFFFFFu) &&
+               (uint16_t)(nowSec - s->stamp) < _ttl;
+    }
+
+    // Record a negative verdict. Returns true if an older entry for the same
+    // address carried a different payload (an invalidation).
+    bool insert(const uint8_t addr[6], uint32_t payloadHash, uint16_t nowSec) {
+        uint32_t h = addrHash(addr);
+        payloadHash &= 0x7FFFFFFFu;
+        Slot* s = find(h, addr);
+        bool changed = s && s->payload != payloadHash;
+        if (!s) s = victim(h, nowSec);
+        memcpy(s->addr, addr, 6);
+        s->stamp = nowSec;
+        s->payload = payloadHash;
+        s->used = 1;
+        return changed;
+    }
+
+    static size_t capacity() { return Buckets * FY_VERDICT_WAYS; }
+
+private:
+    struct Slot {
+        uint8_t  addr[6];
+        uint16_t stamp;     // Seconds, wraps every ~18 h (compared mod 2^16)
+        uint32_t payload : 31;  // Low 31 bits of the payload hash
+        uint32_t used    : 1;
+    };
+
+    static uint32_t addrHash(const uint8_t a[6]) {
+        uint32_t lo = (uint32_t)a[0] | (uint32_t)a[1] << 8 | (uint32_t)a[2] << 16 | (uint32_t)a[3] << 24;
+        uint32_t hi = (uint32_t)a[4] | (uint32_t)a[5] << 8;
+        uint32_t h = lo * 0x9E3779B1u ^ (hi + 0x7F4A7C15u) * 0x85EBCA77u;
+        return h ^ (h >> 15);
+    }
+
+    // Alternate bucket uses the high bits so the two choices are independent
+    static size_t bucketA(uint32_t h) { return h & (Buckets - 1); }
+    static size_t bucketB(uint32_t h) { return (h >> 16) * 0x9E37u & (Buckets - 1); }
+
+    const Slot* find(uint32_t h, const uint8_t addr[6]) const {
+        return const_cast<FYVerdictCache*>(this)->find(h, addr);
+    }
+
+    Slot* find(uint32_t h, const uint8_t addr[6]) {
+        Slot* a = _slots[bucketA(h)];
+        Slot* b = _slots[bucketB(h)];
+        for (int i = 0; i < FY_VERDICT_WAYS; i++) {
+            if (a[i].used && memcmp(a[i].addr, addr, 6) == 0) return &a[i];
+            if (b[i].used && memcmp(b[i].addr, addr, 6) == 0) return &b[i];
+        }
+        return nullptr;
+    }
+
+    // Free slot in either bucket, else the stalest of the 8
+    Slot* victim(uint32_t h, uint16_t nowSec) {
+        Slot* a = _slots[bucketA(h)];
+        Slot* b = _slots[bucketB(h)];
+        Slot* best = &a[0];
+        uint16_t bestAge = 0;
+        for (int i = 0; i < FY_VERDICT_WAYS; i++) {
+            Slot* c[2] = {&a[i], &b[i]};
+            for (int j = 0; j < 2; j++) {
+                if (!c[j]->used) return c[j];
+                uint16_t age = (uint16_t)(nowSec - c[j]->stamp);
+                if (age >= bestAge) { bestAge = age; best = c[j]; }
+            }
+        }
+        return best;
+    }
+
+    Slot _slots[Buckets][FY_VERDICT_WAYS];
+    uint16_t _ttl;
+};
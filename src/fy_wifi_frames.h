@@ -0,0 +1,132 @@
+// ============================================================================
+// FLOCK-YOU: 802.11 frame matcher for the Wi-Fi sniffer
+// ============================================================================
+// Runs inside the promiscuous-mode RX callback, so it only reads the raw
+// frame - no allocation, no locks, no logging. Matches:
+//   - transmitter address (addr2) against the Flock OUI table, any frame type
+//   - BSSID (addr3) of beacons / probe responses against the same table
+//   - SSID element of beacons / probe responses / probe requests against a
+//     case-insensitive prefix ("Flock-XXXXXX" APs, see datasets/Flock-*.csv)
+//
+// Pure C++ with no ESP-IDF dependency so captured frames can be replayed
+// through fyWifiMatch() on a host.
+// ============================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define FY_WIFI_MATCH_NONE  0
+#define FY_WIFI_MATCH_OUI   1
+#define FY_WIFI_MATCH_SSID  2
+
+// 802.11 frame control: type in bits 2-3, subtype in bits 4-7
+#define FY_WIFI_TYPE_MGMT        0
+#define FY_WIFI_SUBTYPE_PROBE_REQ  4
+#define FY_WIFI_SUBTYPE_PROBE_RESP 5
+#define FY_WIFI_SUBTYPE_BEACON     8
+
+#define FY_WIFI_HDR_LEN     24
+#define FY_WIFI_FIXED_LEN   12    // Beacon/probe-resp timestamp+interval+caps
+
+struct FYWifiHit {
+    uint8_t mac[6];        // Matched address (or transmitter for SSID hits)
+    int8_t  rssi;
+    uint8_t channel;
+    uint8_t reason;        // FY_WIFI_MATCH_*
+    uint8_t ssidLen;
+    char    ssid[33];      // NUL-terminated, empty if none
+};
+
+static inline uint32_t fyWifiOUI(const uint8_t* mac) {
+    return ((uint32_t)mac[0] << 16) | ((uint32_t)mac[1] << 8) | mac[2];
+}
+
+// ouis must be sorted ascending (binary search)
+static inline bool fyWifiOUIMatch(const uint8_t* mac, const uint32_t* ouis, size_t n) {
+    uint32_t o = fyWifiOUI(mac);
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ouis[mid] < o) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < n && ouis[lo] == o;
+}
+
+static inline bool fyWifiPrefixMatch(const uint8_t* ssid, size_t len, const char* prefix) {
+    size_t n = strlen(prefix);
+    if (len < n) return false;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t a = ssid[i], b = (uint8_t)prefix[i];
+        if (a >= 'A' && a <= 'Z') a += 32;
+        if (b >= 'A' && b <= 'Z') b += 32;
+        if (a != b) return false;
+    }
+    return true;
+}
+
+// Locate the SSID element in a management frame body; false if absent
+static inline bool fyWifiFindSSID(const uint8_t* frame, size_t len, uint8_t subtype,
+                                  const uint8_t** ssid, uint8_t* ssidLen) {
+    size_t pos = FY_WIFI_HDR_LEN;
+    if (subtype == FY_WIFI_SUBTYPE_BEACON || subtype == FY_WIFI_SUBTYPE_PROBE_RESP) {
+        pos += FY_WIFI_FIXED_LEN;
+    }
+    while (pos + 2 <= len) {
+        uint8_t id = frame[pos], elen = frame[pos + 1];
+        if (pos + 2 + elen > len) return false;
+        if (id == 0) {
+            if (elen > 32) return false;
+            *ssid = frame + pos + 2;
+            *ssidLen = elen;
+            return true;
+        }
+        pos += 2 + elen;
+    }
+    return false;
+}
+
+// Classify one raw frame. Fills hit (minus rssi/channel) and returns
+// FY_WIFI_MATCH_* ; FY_WIFI_MATCH_NONE leaves hit untouched.
+static inline uint8_t fyWifiMatch(const uint8_t* frame, size_t len,
+                                  const uint32_t* ouis, size_t nOuis,
+                                  const char* ssidPrefix, FYWifiHit* hit) {
+    if (len < FY_WIFI_HDR_LEN) return FY_WIFI_MATCH_NONE;
+    uint8_t type = (frame[0] >> 2) & 0x3;
+    uint8_t subtype = (frame[0] >> 4) & 0xF;
+    const uint8_t* addr2 = frame + 10;
+    const uint8_t* addr3 = frame + 16;
+    bool mgmt = type == FY_WIFI_TYPE_MGMT;
+    bool hasSSID = mgmt && (subtype == FY_WIFI_SUBTYPE_BEACON ||
+                            subtype == FY_WIFI_SUBTYPE_PROBE_RESP ||
+                            subtype == FY_WIFI_SUBTYPE_PROBE_REQ);
+
+    uint8_t reason = FY_WIFI_MATCH_NONE;
+    const uint8_t* mac = addr2;
+    if (fyWifiOUIMatch(addr2, ouis, nOuis)) {
+        reason = FY_WIFI_MATCH_OUI;
+    } else if (mgmt && subtype != FY_WIFI_SUBTYPE_PROBE_REQ && fyWifiOUIMatch(addr3, ouis, nOuis)) {
+        reason = FY_WIFI_MATCH_OUI;
+        mac = addr3;
+    }
+
+    const uint8_t* ssid = NULL;
+    uint8_t ssidLen = 0;
+    if (hasSSID && fyWifiFindSSID(frame, len, subtype, &ssid, &ssidLen)) {
+        if (reason == FY_WIFI_MATCH_NONE && ssidPrefix && ssidPrefix[0] &&
+            fyWifiPrefixMatch(ssid, ssidLen, ssidPrefix)) {
+            reason = FY_WIFI_MATCH_SSID;
+        }
+    }
+    if (reason == FY_WIFI_MATCH_NONE) return reason;
+
+    memcpy(hit->mac, mac, 6);
+    hit->reason = reason;
+    hit->ssidLen = ssid ? ssidLen : 0;
+    if (hit->ssidLen) memcpy(hit->ssid, ssid, hit->ssidLen);
+    hit->ssid[hit->ssidLen] = '\0';
+    return reason;
+}
@@ -1,14 +1,17 @@
 // ============================================================================
 // FLOCK-YOU: Surveillance Device Detector with Web Dashboard
 // ============================================================================
-// Detection methods (BLE only - WiFi radio used for AP):
+// Detection methods (BLE scan + promiscuous WiFi alongside the AP):
 //   1. BLE MAC prefix matching (known Flock Safety OUIs)
 //   2. BLE device name pattern matching (case-insensitive substring)
 //   3. BLE manufacturer company ID matching (0x09C8 XUNTONG) [from wgreenberg]
 //   4. Raven gunshot detector service UUID matching
 //   5. Raven firmware version estimation from service UUID patterns
+//   6. WiFi transmitter/BSSID OUI matching (same OUI table)
+//   7. WiFi "Flock-XXXXXX" SSID matching in beacons and probes
 //
 // WiFi AP "flockyou" / "flockyou123" serves web dashboard at 192.168.4.1
+// (convoy followers: "flockyou-XXXX" on their own subnet, see setup())
 // All detections stored in memory, exportable as JSON or CSV
 // Optional WiFi STA connection for future features
 // ============================================================================
@@ -22,11 +25,31 @@
 #include <SPIFFS.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
+#include <AsyncUDP.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <new>
 #include "esp_wifi.h"
+#include "esp_coexist.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "fy_binexport.h"
+#include "fy_serialize.h"
+#include "fy_knowndb.h"
+#include "fy_camindex.h"
+#include "fy_verdict.h"
+#include "fy_ring.h"
+#include "fy_wifi_frames.h"
+#include "fy_gpsfix.h"
+#include "fy_respool.h"
+#include "fy_replay.h"
+#include "fy_timerwheel.h"
+#include "fy_coex.h"
+#include "fy_sync.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -47,8 +70,12 @@
 #define BLE_SCAN_DURATION 2      // seconds per scan
 #define BLE_SCAN_INTERVAL 3000   // ms between scans
 
-// Detection storage
+// Detection storage. Overridable (the bench build raises it); tables above
+// FY_DET_INTERNAL_MAX live in PSRAM.
+#ifndef MAX_DETECTIONS
 #define MAX_DETECTIONS 200
+#endif
+#define FY_DET_INTERNAL_MAX 200
 
 // WiFi AP credentials
 #define FY_AP_SSID "flockyou"
@@ -125,32 +152,84 @@ struct FYDetection {
     double gpsLon;
     float gpsAcc;
     bool hasGPS;
+    // Sessions this device was seen in before this boot (0 = new)
+    uint16_t knownSessions;
+    // Presence (see PRESENCE)
+    uint8_t presence;
+    uint16_t visits;
+    unsigned long enterMs;     // First sighting of the current / last visit
+    uint32_t dwellMs;          // Finished visits only - use fyDwellMs()
 };
 
+#if MAX_DETECTIONS > FY_DET_INTERNAL_MAX
+static FYDetection* fyDet = NULL;      // ps_calloc'd first thing in setup()
+#else
 static FYDetection fyDet[MAX_DETECTIONS];
+#endif
 static int fyDetCount = 0;
 static SemaphoreHandle_t fyMutex = NULL;
 
+// ============================================================================
+// RUNNING AGGREGATES
+// ============================================================================
+// Maintained by fyAddDetection / clear while they hold fyMutex, so /api/stats
+// and /api/histogram read them without locking or scanning fyDet.
+
+enum FYMethod {
+    FY_M_MAC_PREFIX, FY_M_DEVICE_NAME, FY_M_MFR_ID, FY_M_RAVEN_UUID,
+    FY_M_WIFI_OUI, FY_M_WIFI_SSID,
+#ifdef FY_BENCH
+    FY_M_BENCH,             // fyBenchInsert's synthetic rows
+#endif
+    FY_M_COUNT
+};
+static const char* fy_method_names[FY_M_COUNT] = {
+    "mac_prefix", "device_name", "ble_mfr_id", "raven_uuid", "wifi_oui", "wifi_ssid",
+#ifdef FY_BENCH
+    "bench",
+#endif
+};
+
+// Per-minute activity ring: each bucket packs (minute & 0xFFFF) << 16 | count
+// into one word so a lock-free reader never sees a count from another minute
+#define FY_HIST_MINUTES 60
+
+struct FYStats {
+    std::atomic<int> total;
+    std::atomic<int> raven;
+    std::atomic<int> withGPS;
+    std::atomic<int> byMethod[FY_M_COUNT];
+    std::atomic<uint32_t> sightings;                     // Every matched advert
+    std::atomic<uint32_t> histSeen[FY_HIST_MINUTES];     // Sightings per minute
+    std::atomic<uint32_t> histNew[FY_HIST_MINUTES];      // New devices per minute
+};
+static FYStats fyStats;
+
 // ============================================================================
 // GLOBALS
 // ============================================================================
 
 static bool fyBuzzerOn = true;
-static unsigned long fyLastBleScan = 0;
-static bool fyTriggered = false;
-static bool fyDeviceInRange = false;
-static unsigned long fyLastDetTime = 0;
-static unsigned long fyLastHB = 0;
 static NimBLEScan* fyBLEScan = NULL;
 static AsyncWebServer fyServer(80);
 
-// Phone GPS state (updated via browser Geolocation API -> /api/gps)
-static double fyGPSLat = 0;
-static double fyGPSLon = 0;
-static float  fyGPSAcc = 0;
-static bool   fyGPSValid = false;
-static unsigned long fyGPSLastUpdate = 0;
-#define GPS_STALE_MS 30000  // GPS considered stale after 30s without update
+// Phone GPS fixes (browser Geolocation API -> /api/gps/batch, see fy_gpsfix.h).
+// Written only by the web task, read lock-free by everyone else.
+#define GPS_STALE_MS       30000  // GPS considered stale 30s after the fix was taken
+#define FY_GPS_FIXES       32     // Recent fixes retained in the queue
+#define FY_GPS_BATCH_MAX   4096   // Largest accepted batch body (the dashboard sends <= 50 fixes, ~2.5 KB)
+static FYFixQueue<FY_GPS_FIXES> fyFixes;
+
+// Ingestion cost, legacy per-fix GET vs batched POST
+struct FYGPSIngestStats {
+    std::atomic<uint32_t> requests;
+    std::atomic<uint32_t> fixes;
+    std::atomic<uint32_t> rejected;    // Malformed, out of range or older than the latest
+    std::atomic<uint32_t> us;          // Handler CPU time
+    std::atomic<uint32_t> backfilled;  // Detections tagged after the fact from buffered fixes
+};
+static FYGPSIngestStats fyGPSLegacy;
+static FYGPSIngestStats fyGPSBatch;
 
 // Session persistence (SPIFFS)
 #define FY_SESSION_FILE  "/session.json"
@@ -158,7 +237,225 @@ static unsigned long fyGPSLastUpdate = 0;
 #define FY_SAVE_INTERVAL 15000  // Auto-save every 15 seconds (prevent data loss on quick power-cycle)
 static unsigned long fyLastSave = 0;
 static int fyLastSaveCount = 0;  // Track changes to avoid unnecessary writes
-static bool fySpiffsReady = false;
+static std::atomic<bool> fySpiffsReady(false);  // Set by fy_persist once mounted + promoted
+
+// Known-device index (SPIFFS) - persists across sessions, see fy_knowndb.h
+#define FY_KNOWN_FILE          "/known.db"
+#define FY_KNOWN_MAX           4096     // 128 KB of records in PSRAM
+#define FY_KNOWN_MAX_NOPSRAM   512
+#define FY_KNOWN_SAVE_INTERVAL 300000   // Flash write at most every 5 min
+static FYKnownDB fyKnown;
+static SemaphoreHandle_t fyKnownMutex = NULL;
+static uint16_t fyKnownSession = 1;
+static bool fyKnownDirty = false;
+static unsigned long fyKnownLastSave = 0;
+static FYKnownRec* fyKnownSnap = NULL;            // Save copy, taken under fyKnownMutex
+static std::atomic<bool> fyKnownSaving(false);    // One writer of /known.db at a time
+
+// Offline camera overlay - "camidx" partition, built by tools/mkcamindex.py
+#define FY_CAM_PARTITION_SUBTYPE 0x40
+#define FY_CAM_QUERY_LIMIT       500
+static FYCamIndex fyCams;
+static std::atomic<uint32_t> fyCamQueries(0);
+static std::atomic<uint32_t> fyCamTotalUs(0);
+static std::atomic<uint32_t> fyCamMaxUs(0);
+
+// Boot milestones, microseconds since reset (esp_timer clock). Saved once per
+// boot to FY_BOOT_FILE, newest last, so slow cold starts show up over time.
+#define FY_BOOT_FILE     "/boot.log"
+#define FY_BOOT_HISTORY  16
+#define FY_BOOT_SAVE_MS  30000   // Save even if no advert arrives by then
+
+struct FYBootRecord {
+    uint32_t scanStartUs;        // First BLE scan started
+    uint32_t firstAdvertUs;      // First advert of any kind (0 = none in window)
+    uint32_t apUpUs;             // softAP up
+    uint32_t dashboardUs;        // Web server listening
+    uint32_t fsReadyUs;          // Background SPIFFS mount + promotion done
+    uint16_t session;
+    uint8_t  resetReason;        // esp_reset_reason_t
+    uint8_t  reserved;
+};
+
+struct FYBootMetrics {
+    std::atomic<uint32_t> scanStartUs;
+    std::atomic<uint32_t> firstAdvertUs;
+    std::atomic<uint32_t> apUpUs;
+    std::atomic<uint32_t> dashboardUs;
+    std::atomic<uint32_t> fsReadyUs;
+    bool saved;                  // fy_persist only
+};
+static FYBootMetrics fyBoot;
+
+// ============================================================================
+// TASK LAYOUT
+// ============================================================================
+// Core 0 carries the radio stack (WiFi driver, NimBLE host), so the radio
+// task that restarts scans and drains WiFi hits sits next to it. Core 1 runs
+// the dashboard (AsyncTCP, pinned via CONFIG_ASYNC_TCP_RUNNING_CORE), audio
+// and flash writes. Nothing polls: each task blocks on its event group or
+// queue, and periodic work comes from esp_timer callbacks.
+
+#define FY_RADIO_CORE       0
+#define FY_RADIO_PRIO       5
+#define FY_RADIO_STACK      4096
+#define FY_AUDIO_CORE       1
+#define FY_AUDIO_PRIO       3
+#define FY_AUDIO_STACK      2048
+#define FY_AUDIO_QUEUE      4
+#define FY_PERSIST_CORE     1
+#define FY_PERSIST_PRIO     1
+#define FY_PERSIST_STACK    6144
+#define FY_PERSIST_QUEUE    4
+#define FY_TICK_MS          500     // Radio housekeeping: presence, rates, coexistence
+#define FY_PERSIST_TICK_MS  1000    // Autosave checks
+
+// Radio task events
+#define FY_EV_SCAN_DONE     BIT0    // NimBLE scan-complete callback
+#define FY_EV_SCAN_KICK     BIT1    // Inter-scan gap timer expired
+#define FY_EV_WIFI_HIT      BIT2    // Promiscuous callback queued a hit
+#define FY_EV_TICK          BIT3
+#define FY_EV_PRESENCE      BIT4    // Enter/exit events queued (see PRESENCE)
+#define FY_EV_COUNT         5
+#define FY_EV_ALL           (FY_EV_SCAN_DONE | FY_EV_SCAN_KICK | FY_EV_WIFI_HIT | FY_EV_TICK | FY_EV_PRESENCE)
+
+// Per-task instrumentation. Each task is the only writer of its own record.
+// Latency = time from the event being posted to the task starting on it,
+// i.e. the scheduling jitter the old 100 ms poll used to hide.
+struct FYTaskStats {
+    const char* name;
+    TaskHandle_t handle;
+    uint8_t core;
+    uint8_t prio;
+    std::atomic<uint32_t> wakeups;
+    std::atomic<uint32_t> busyUs;      // Wraps ~71 min - used as deltas
+    std::atomic<uint32_t> latSumUs;
+    std::atomic<uint32_t> latMaxUs;
+    std::atomic<uint32_t> cpuPermille; // Share of one core over the last tick window
+    uint32_t lastBusyUs;               // Radio-tick bookkeeping
+
+    explicit FYTaskStats(const char* n)
+        : name(n), handle(NULL), core(0), prio(0), wakeups(0), busyUs(0),
+          latSumUs(0), latMaxUs(0), cpuPermille(0), lastBusyUs(0) {}
+};
+static FYTaskStats fyTaskRadio("fy_radio");
+static FYTaskStats fyTaskAudio("fy_audio");
+static FYTaskStats fyTaskPersist("fy_persist");
+static FYTaskStats* const fyTasks[] = {&fyTaskRadio, &fyTaskAudio, &fyTaskPersist};
+#define FY_TASK_COUNT (sizeof(fyTasks)/sizeof(fyTasks[0]))
+
+// BLE scan cadence: NimBLE's completion callback arms the gap timer
+#define FY_SCAN_GAP_MS (BLE_SCAN_INTERVAL - BLE_SCAN_DURATION * 1000)
+
+struct FYScanStats {
+    std::atomic<uint32_t> scans;
+    std::atomic<uint32_t> startFails;
+    std::atomic<uint32_t> gapErrMaxUs;   // Worst overshoot of the inter-scan gap
+    uint32_t doneUs;
+};
+static FYScanStats fyScanStats;
+
+static EventGroupHandle_t fyRadioEvents = NULL;
+static std::atomic<uint32_t> fyEvStamp[FY_EV_COUNT];
+static QueueHandle_t fyAudioQueue = NULL;
+static QueueHandle_t fyPersistQueue = NULL;
+
+enum FYPersistOp { FY_PERSIST_BOOT, FY_PERSIST_TICK, FY_PERSIST_SYNC };
+
+struct FYPersistMsg {
+    uint8_t op;
+    uint32_t stampUs;
+};
+static esp_timer_handle_t fyScanTimer = NULL;
+static esp_timer_handle_t fyTickTimer = NULL;
+static esp_timer_handle_t fyPersistTimer = NULL;
+
+static inline uint32_t fyNowUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static void fyRadioSignal(EventBits_t bit) {
+    if (!fyRadioEvents) return;
+    for (int i = 0; i < FY_EV_COUNT; i++) {
+        if (bit & (1 << i)) fyEvStamp[i].store(fyNowUs(), std::memory_order_relaxed);
+    }
+    xEventGroupSetBits(fyRadioEvents, bit);
+}
+
+static void fyPersistPost(uint8_t op) {
+    FYPersistMsg m = {op, fyNowUs()};
+    if (fyPersistQueue) xQueueSend(fyPersistQueue, &m, 0);
+}
+
+static void fyTaskWake(FYTaskStats& t, uint32_t stampUs, uint32_t nowUs) {
+    uint32_t lat = nowUs - stampUs;
+    t.wakeups.fetch_add(1, std::memory_order_relaxed);
+    t.latSumUs.fetch_add(lat, std::memory_order_relaxed);
+    if (lat > t.latMaxUs.load(std::memory_order_relaxed)) t.latMaxUs.store(lat, std::memory_order_relaxed);
+}
+
+static void fyTaskDone(FYTaskStats& t, uint32_t startUs) {
+    t.busyUs.fetch_add(fyNowUs() - startUs, std::memory_order_relaxed);
+}
+
+static bool fyTaskStart(TaskFunction_t fn, FYTaskStats& t, uint32_t stack, uint8_t prio, uint8_t core) {
+    t.core = core;
+    t.prio = prio;
+    if (xTaskCreatePinnedToCore(fn, t.name, stack, NULL, prio, &t.handle, core) != pdPASS) {
+        printf("[FLOCK-YOU] Failed to start task %s\n", t.name);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// LOCK INSTRUMENTATION
+// ============================================================================
+// Every fyMutex holder goes through fyLock()/fyUnlock() with its site, so
+// /api/perf can show who holds the detection table for how long and how long
+// BLE inserts wait behind the web layer (insert timeouts = dropped sightings).
+
+enum FYLockSite { FY_LOCK_INSERT, FY_LOCK_RESP, FY_LOCK_SAVE, FY_LOCK_CLEAR, FY_LOCK_PRESENCE, FY_LOCK_SYNC, FY_LOCK_GPS, FY_LOCK_SITES };
+static const char* const fy_lock_site_names[FY_LOCK_SITES] = {"insert", "response", "save", "clear", "presence", "sync", "gps"};
+
+struct FYLockStats {
+    std::atomic<uint32_t> takes;
+    std::atomic<uint32_t> timeouts;
+    std::atomic<uint32_t> waitSumUs;
+    std::atomic<uint32_t> waitMaxUs;
+    std::atomic<uint32_t> holdSumUs;
+    std::atomic<uint32_t> holdMaxUs;
+};
+static FYLockStats fyLockStats[FY_LOCK_SITES];
+static uint32_t fyLockSinceUs;  // Written only by the current holder
+
+static inline void fyStatMax(std::atomic<uint32_t>& m, uint32_t v) {
+    if (v > m.load(std::memory_order_relaxed)) m.store(v, std::memory_order_relaxed);
+}
+
+static bool fyLock(FYLockSite site, uint32_t waitMs) {
+    if (!fyMutex) return false;
+    FYLockStats& st = fyLockStats[site];
+    uint32_t t0 = fyNowUs();
+    if (xSemaphoreTake(fyMutex, pdMS_TO_TICKS(waitMs)) != pdTRUE) {
+        st.timeouts.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    fyLockSinceUs = fyNowUs();
+    uint32_t wait = fyLockSinceUs - t0;
+    st.takes.fetch_add(1, std::memory_order_relaxed);
+    st.waitSumUs.fetch_add(wait, std::memory_order_relaxed);
+    fyStatMax(st.waitMaxUs, wait);
+    return true;
+}
+
+static void fyUnlock(FYLockSite site) {
+    FYLockStats& st = fyLockStats[site];
+    uint32_t hold = fyNowUs() - fyLockSinceUs;
+    st.holdSumUs.fetch_add(hold, std::memory_order_relaxed);
+    fyStatMax(st.holdMaxUs, hold);
+    xSemaphoreGive(fyMutex);
+}
 
 // ============================================================================
 // AUDIO SYSTEM
@@ -214,7 +511,6 @@ static void fyBootBeep() {
 }
 
 static void fyDetectBeep() {
-    printf("[FLOCK-YOU] Detection alert!\n");
     if (!fyBuzzerOn) return;
     // Alarm crow: two sharp ascending chirps then a caw
     fyCaw(400, 900, 100, 30);   // rising alarm chirp
@@ -232,6 +528,35 @@ static void fyHeartbeat() {
     fyCaw(480, 380, 80, 20);
 }
 
+// Sounds block for hundreds of ms, so callers only queue them; the audio
+// task plays them in order. A full queue drops the request.
+enum FYSound { FY_SND_BOOT, FY_SND_DETECT, FY_SND_HEARTBEAT };
+
+struct FYAudioMsg {
+    uint8_t sound;
+    uint32_t stampUs;
+};
+
+static void fyAudioPlay(uint8_t sound) {
+    if (sound == FY_SND_DETECT) printf("[FLOCK-YOU] Detection alert!\n");
+    if (!fyAudioQueue) return;
+    FYAudioMsg m = {sound, fyNowUs()};
+    xQueueSend(fyAudioQueue, &m, 0);
+}
+
+static void fyAudioTask(void*) {
+    FYAudioMsg m;
+    for (;;) {
+        if (xQueueReceive(fyAudioQueue, &m, portMAX_DELAY) != pdTRUE) continue;
+        uint32_t t0 = fyNowUs();
+        fyTaskWake(fyTaskAudio, m.stampUs, t0);
+        if (m.sound == FY_SND_BOOT) fyBootBeep();
+        else if (m.sound == FY_SND_DETECT) fyDetectBeep();
+        else if (m.sound == FY_SND_HEARTBEAT) fyHeartbeat();
+        fyTaskDone(fyTaskAudio, t0);
+    }
+}
+
 // ============================================================================
 // DETECTION HELPERS
 // ============================================================================
@@ -301,17 +626,602 @@ static const char* estimateRavenFW(NimBLEAdvertisedDevice* device) {
 // GPS HELPERS
 // ============================================================================
 
+// One consistent snapshot of the newest fix; false if none or stale
+static bool fyGPSCurrent(FYGPSFix& f) {
+    return fyFixes.latest(f) && (millis() - f.tMs < GPS_STALE_MS);
+}
+
 static bool fyGPSIsFresh() {
-    return fyGPSValid && (millis() - fyGPSLastUpdate < GPS_STALE_MS);
+    FYGPSFix f;
+    return fyGPSCurrent(f);
 }
 
 static void fyAttachGPS(FYDetection& d) {
-    if (fyGPSIsFresh()) {
+    FYGPSFix f;
+    if (fyGPSCurrent(f)) {
         d.hasGPS = true;
-        d.gpsLat = fyGPSLat;
-        d.gpsLon = fyGPSLon;
-        d.gpsAcc = fyGPSAcc;
+        d.gpsLat = f.latE7 / 1e7;
+        d.gpsLon = f.lonE7 / 1e7;
+        d.gpsAcc = f.acc;
+    }
+}
+
+// Web task only. Drops fixes older than the newest one already published
+// (a late batch from another phone, or a retried flush).
+static bool fyGPSPublish(FYGPSFix& f, uint32_t ageMs) {
+    uint32_t now = millis();
+    f.tMs = ageMs < now ? now - ageMs : 0;
+    FYGPSFix last;
+    if (fyFixes.latest(last) && (int32_t)(f.tMs - last.tMs) < 0) return false;
+    fyFixes.publish(f);
+    return true;
+}
+
+// Web task, after buffered fixes were published: detections made while the
+// AP was down had no fresh fix. Tag each from the retained fix closest to
+// its last sighting (within GPS_STALE_MS). Called every half ring, so a
+// long batch is matched before its oldest fixes are overwritten.
+static void fyGPSBackfill() {
+    if (!fyLock(FY_LOCK_GPS, 100)) return;
+    uint32_t tagged = 0;
+    for (int i = 0; i < fyDetCount; i++) {
+        FYDetection& d = fyDet[i];
+        FYGPSFix f;
+        if (d.hasGPS || !fyFixes.nearest(d.lastSeen, GPS_STALE_MS, f)) continue;
+        d.hasGPS = true;
+        d.gpsLat = f.latE7 / 1e7;
+        d.gpsLon = f.lonE7 / 1e7;
+        d.gpsAcc = f.acc;
+        fyStats.withGPS++;
+        tagged++;
+    }
+    fyUnlock(FY_LOCK_GPS);
+    if (tagged) {
+        fyGPSBatch.backfilled.fetch_add(tagged, std::memory_order_relaxed);
+        printf("[FLOCK-YOU] GPS: back-filled %u detections from buffered fixes\n", (unsigned)tagged);
+    }
+}
+
+// ============================================================================
+// KNOWN-DEVICE INDEX
+// ============================================================================
+
+// Runs on fy_persist after SPIFFS is up. fyKnownMutex is published last:
+// until then fyKnownNote and the web handlers skip the index.
+static void fyKnownInit() {
+    size_t cap = FY_KNOWN_MAX;
+    void* mem = psramFound() ? ps_malloc(FYKnownDB::memFor(cap)) : NULL;
+    if (!mem) {
+        cap = FY_KNOWN_MAX_NOPSRAM;
+        mem = malloc(FYKnownDB::memFor(cap));
+    }
+    if (!mem) {
+        printf("[FLOCK-YOU] Known-device index: out of memory\n");
+        return;
+    }
+    fyKnown.init(mem, cap);
+    fyKnownSnap = (FYKnownRec*)(psramFound() ? ps_malloc(cap * sizeof(FYKnownRec))
+                                             : malloc(cap * sizeof(FYKnownRec)));
+    SemaphoreHandle_t mtx = xSemaphoreCreateMutex();
+
+    if (!fySpiffsReady || !SPIFFS.exists(FY_KNOWN_FILE)) {
+        printf("[FLOCK-YOU] Known-device index: empty (cap %u)\n", (unsigned)cap);
+        fyKnownMutex = mtx;
+        return;
+    }
+    File f = SPIFFS.open(FY_KNOWN_FILE, "r");
+    FYKnownHeader h;
+    if (!f || f.read((uint8_t*)&h, sizeof(h)) != sizeof(h) ||
+        memcmp(h.magic, FY_KNOWN_MAGIC, 4) != 0 || h.version != FY_KNOWN_VERSION) {
+        printf("[FLOCK-YOU] Known-device index: bad file, starting fresh\n");
+        if (f) f.close();
+        fyKnownMutex = mtx;
+        return;
+    }
+    FYKnownRec rec;
+    for (uint32_t i = 0; i < h.count; i++) {
+        if (f.read((uint8_t*)&rec, sizeof(rec)) != sizeof(rec)) break;
+        fyKnown.loadSorted(rec);
+    }
+    f.close();
+    fyKnownSession = h.session + 1;
+    fyKnownMutex = mtx;
+    printf("[FLOCK-YOU] Known-device index: %u devices, session %u\n",
+           (unsigned)fyKnown.count(), fyKnownSession);
+}
+
+// The index is copied under fyKnownMutex and written outside it, so
+// fyKnownNote's 5 ms try-lock is not starved for the length of a flash write
+static void fyKnownSave() {
+    if (!fySpiffsReady || !fyKnownMutex || !fyKnownSnap) return;
+    bool idle = false;
+    if (!fyKnownSaving.compare_exchange_strong(idle, true)) return;  // Other task is saving
+    if (xSemaphoreTake(fyKnownMutex, pdMS_TO_TICKS(300)) != pdTRUE) {
+        fyKnownSaving = false;
+        return;
+    }
+    FYKnownHeader h;
+    memcpy(h.magic, FY_KNOWN_MAGIC, 4);
+    h.version = FY_KNOWN_VERSION;
+    h.session = fyKnownSession;
+    h.count = fyKnown.count();
+    for (size_t i = 0; i < h.count; i++) fyKnownSnap[i] = fyKnown.at(i);
+    fyKnownDirty = false;    // Changes from here on dirty it again
+    xSemaphoreGive(fyKnownMutex);
+
+    File f = SPIFFS.open(FY_KNOWN_FILE, "w");
+    if (f) {
+        {
+            FYWriter<File> w(f);
+            w.raw((const char*)&h, sizeof(h));
+            w.raw((const char*)fyKnownSnap, h.count * sizeof(FYKnownRec));
+        }
+        f.close();
+        printf("[FLOCK-YOU] Known-device index saved: %u devices\n", (unsigned)h.count);
+    } else {
+        fyKnownDirty = true;
     }
+    fyKnownLastSave = millis();
+    fyKnownSaving = false;
+}
+
+// Called from fyAddDetection (fyMutex held): fold a GPS-tagged sighting into
+// the index, or just classify when there is no fresh fix
+static void fyKnownNote(FYDetection& d) {
+    if (!fyKnownMutex || xSemaphoreTake(fyKnownMutex, pdMS_TO_TICKS(5)) != pdTRUE) return;
+    uint8_t mac[6];
+    fybPackMAC(d.mac, mac);
+    uint16_t prior = 0;
+    if (fyGPSIsFresh()) {
+        bool changed = false;
+        prior = fyKnown.observe(mac, d.gpsLat, d.gpsLon, d.gpsAcc, d.isRaven,
+                                fyKnownSession, &changed);
+        if (changed) fyKnownDirty = true;
+    } else if (const FYKnownRec* rec = fyKnown.find(mac)) {
+        prior = (rec->lastSession == fyKnownSession) ? rec->sessions - 1 : rec->sessions;
+    }
+    if (prior > d.knownSessions) d.knownSessions = prior;
+    xSemaphoreGive(fyKnownMutex);
+}
+
+// ============================================================================
+// OFFLINE CAMERA INDEX
+// ============================================================================
+
+static void fyCamInit() {
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FY_CAM_PARTITION_SUBTYPE, "camidx");
+    if (!part) {
+        printf("[FLOCK-YOU] Camera index: no camidx partition\n");
+        return;
+    }
+    const void* ptr = NULL;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+        printf("[FLOCK-YOU] Camera index: mmap failed\n");
+        return;
+    }
+    // Mapping stays for the life of the firmware - queries read flash directly
+    if (!fyCams.attach((const uint8_t*)ptr, part->size)) {
+        printf("[FLOCK-YOU] Camera index: not flashed (see tools/mkcamindex.py)\n");
+        spi_flash_munmap(handle);
+        return;
+    }
+    printf("[FLOCK-YOU] Camera index: %u known cameras in %u tiles (%u bytes)\n",
+           fyCams.pointCount(), fyCams.tileCount(), fyCams.imageSize());
+}
+
+// ============================================================================
+// AGGREGATE HELPERS
+// ============================================================================
+
+static int fyMethodIndex(const char* method) {
+    for (int i = 0; i < FY_M_COUNT; i++) {
+        if (strcmp(method, fy_method_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static inline uint32_t fyMinuteNow() {
+    return millis() / 60000UL;
+}
+
+// Writer side - caller holds fyMutex, so load+store needs no CAS
+static void fyHistBump(std::atomic<uint32_t>* ring, uint32_t minute) {
+    std::atomic<uint32_t>& b = ring[minute % FY_HIST_MINUTES];
+    uint32_t v = b.load(std::memory_order_relaxed);
+    uint32_t tag = minute & 0xFFFF;
+    uint32_t cnt = ((v >> 16) == tag) ? (v & 0xFFFF) : 0;
+    if (cnt < 0xFFFF) cnt++;
+    b.store((tag << 16) | cnt, std::memory_order_relaxed);
+}
+
+// Reader side - 0 if the bucket still holds an older minute
+static uint32_t fyHistGet(const std::atomic<uint32_t>* ring, uint32_t minute) {
+    uint32_t v = ring[minute % FY_HIST_MINUTES].load(std::memory_order_relaxed);
+    return ((v >> 16) == (minute & 0xFFFF)) ? (v & 0xFFFF) : 0;
+}
+
+static void fyStatsReset() {
+    fyStats.total = 0;
+    fyStats.raven = 0;
+    fyStats.withGPS = 0;
+    fyStats.sightings = 0;
+    for (int i = 0; i < FY_M_COUNT; i++) fyStats.byMethod[i] = 0;
+    for (int i = 0; i < FY_HIST_MINUTES; i++) {
+        fyStats.histSeen[i] = 0;
+        fyStats.histNew[i] = 0;
+    }
+}
+
+// ============================================================================
+// PRESENCE (see fy_timerwheel.h)
+// ============================================================================
+// Each detection runs its own entered -> present -> exited machine. A
+// sighting (re)arms the device's exit timer on the wheel; the radio tick
+// advances the wheel and only the devices whose timer is due are touched.
+// Enter/exit events are queued to the radio task, which sounds the alert,
+// writes the serial record and logs them; /api/presence keeps the last few
+// for the dashboard. Dwell = time between the first and last sighting of
+// each visit, summed over visits.
+
+#define FY_PRESENCE_TIMEOUT_MS  30000   // No sighting for this long -> exited
+#define FY_HEARTBEAT_MS         10000   // Soft coo while anything is in range
+#define FY_PRESENCE_QUEUE       32      // Events waiting for the radio task
+#define FY_PRESENCE_LOG         16      // Recent events for /api/presence
+#define FY_PRESENCE_HB          MAX_DETECTIONS   // Wheel id of the heartbeat
+#define FY_PRESENCE_TICKS(ms)   (((ms) + FY_TICK_MS - 1) / FY_TICK_MS)
+
+enum FYPresence { FY_PRES_NONE, FY_PRES_ENTERED, FY_PRES_PRESENT, FY_PRES_EXITED };
+static const char* const fy_presence_names[] = {"none", "entered", "present", "exited"};
+
+struct FYPresenceEvent {
+    uint8_t  type;         // FY_PRES_ENTERED or FY_PRES_EXITED
+    uint16_t visits;
+    uint32_t ms;           // millis() of the event
+    uint32_t dwellMs;      // Length of the visit that just ended (exit only)
+    char     mac[18];
+};
+
+// All guarded by fyMutex
+static FYTimerWheel<MAX_DETECTIONS + 1> fyWheel;
+static int fyPresentCount = 0;
+static FYPresenceEvent fyPresenceLog[FY_PRESENCE_LOG];
+static uint32_t fyPresenceLogCount = 0;
+// Pushed with fyMutex held (one producer at a time), popped by the radio task
+static FYSpscRing<FYPresenceEvent, FY_PRESENCE_QUEUE> fyPresenceQueue;
+
+struct FYPresenceStats {
+    std::atomic<uint32_t> enters;
+    std::atomic<uint32_t> exits;
+    std::atomic<uint32_t> dropped;     // Queue full - event logged but not announced
+    std::atomic<uint32_t> tickUsMax;   // Worst wheel advance
+};
+static FYPresenceStats fyPresenceStats;
+
+static inline uint32_t fyWheelTarget() { return millis() / FY_TICK_MS; }
+
+static uint32_t fyDwellMs(const FYDetection& d) {
+    bool active = d.presence == FY_PRES_ENTERED || d.presence == FY_PRES_PRESENT;
+    return d.dwellMs + (active ? (uint32_t)(d.lastSeen - d.enterMs) : 0);
+}
+
+// fyMutex held
+static void fyPresencePost(const FYDetection& d, uint8_t type, uint32_t dwellMs) {
+    FYPresenceEvent e;
+    e.type = type;
+    e.visits = d.visits;
+    e.ms = millis();
+    e.dwellMs = dwellMs;
+    memcpy(e.mac, d.mac, sizeof(e.mac));
+    fyPresenceLog[fyPresenceLogCount++ % FY_PRESENCE_LOG] = e;
+    (type == FY_PRES_ENTERED ? fyPresenceStats.enters : fyPresenceStats.exits)
+        .fetch_add(1, std::memory_order_relaxed);
+    if (!fyPresenceQueue.push(e)) fyPresenceStats.dropped.fetch_add(1, std::memory_order_relaxed);
+    fyRadioSignal(FY_EV_PRESENCE);
+}
+
+// fyMutex held: fyDet[idx] was just seen
+static void fyPresenceSeen(int idx) {
+    FYDetection& d = fyDet[idx];
+    if (d.presence == FY_PRES_ENTERED || d.presence == FY_PRES_PRESENT) {
+        d.presence = FY_PRES_PRESENT;
+    } else {
+        d.presence = FY_PRES_ENTERED;
+        d.enterMs = d.lastSeen;
+        d.visits++;
+        if (fyPresentCount++ == 0) fyWheel.schedule(FY_PRESENCE_HB, FY_PRESENCE_TICKS(FY_HEARTBEAT_MS));
+        fyPresencePost(d, FY_PRES_ENTERED, 0);
+    }
+    fyWheel.schedule((uint16_t)idx, FY_PRESENCE_TICKS(FY_PRESENCE_TIMEOUT_MS));
+}
+
+// fyMutex held: a wheel timer came due
+static void fyPresenceExpire(uint16_t id) {
+    if (id == FY_PRESENCE_HB) {
+        if (fyPresentCount > 0) {
+            fyAudioPlay(FY_SND_HEARTBEAT);
+            fyWheel.schedule(FY_PRESENCE_HB, FY_PRESENCE_TICKS(FY_HEARTBEAT_MS));
+        }
+        return;
+    }
+    FYDetection& d = fyDet[id];
+    if (d.presence != FY_PRES_ENTERED && d.presence != FY_PRES_PRESENT) return;
+    uint32_t visit = (uint32_t)(d.lastSeen - d.enterMs);
+    d.presence = FY_PRES_EXITED;
+    d.dwellMs += visit;
+    if (--fyPresentCount == 0) fyWheel.cancel(FY_PRESENCE_HB);
+    fyPresencePost(d, FY_PRES_EXITED, visit);
+}
+
+// Radio tick: catch the wheel up with millis()
+static void fyPresenceTick() {
+    if (!fyLock(FY_LOCK_PRESENCE, 50)) return;  // Next tick catches up
+    uint32_t t0 = fyNowUs();
+    uint32_t target = fyWheelTarget();
+    while ((int32_t)(target - fyWheel.now()) > 0) fyWheel.advance(fyPresenceExpire);
+    fyStatMax(fyPresenceStats.tickUsMax, fyNowUs() - t0);
+    fyUnlock(FY_LOCK_PRESENCE);
+}
+
+// fyMutex held (clear)
+static void fyPresenceReset() {
+    fyWheel.reset(fyWheelTarget());
+    fyPresentCount = 0;
+    fyPresenceLogCount = 0;
+}
+
+// ============================================================================
+// CONVOY SYNC (see fy_sync.h)
+// ============================================================================
+// Units in a convoy merge their detection tables. fySync holds the mergeable
+// copy of every record; local sightings go in through fySyncNote() and every
+// record a peer changes is mirrored back into fyDet, so the dashboard,
+// exports and serial stream show the whole convoy. Mirrored rows do not
+// sound the alert or enter presence - this unit did not see them.
+//
+// Links: UDP broadcast on port FY_SYNC_PORT over the AP (and, on a follower
+// built with -DFY_SYNC_UPLINK=\"<lead SSID>\", over its station link to the
+// lead unit's AP), plus a SLIP-framed UART cable with -DFY_SYNC_SERIAL.
+// Packets are handled in the AsyncUDP / UART event tasks under fyMutex.
+// Replies and summaries are only queued there; the persist task sends them
+// a packet at a time with fyMutex released, so a slow link never stalls the
+// other tasks. /api/clear empties fyDet only: fySync keeps every record,
+// since its version vector tells peers this unit holds them, and rows come
+// back into fyDet only when a peer changes them.
+
+#define FY_SYNC_PORT        4210
+#define FY_SYNC_MTU_UDP     1200
+#define FY_SYNC_SUMMARY_MS  2000
+#define FY_SYNC_LOCK_MS     100
+#define FY_SYNC_TABLE       (2 * MAX_DETECTIONS)    // With PSRAM: outlives several clears
+
+static FYSyncNode fySync;
+static bool fySyncReady = false;
+static std::atomic<uint32_t> fySyncLockMisses(0);   // Packets dropped, fyMutex busy
+static std::atomic<bool> fySyncFlushPosted(false);  // One FY_PERSIST_SYNC in the queue at a time
+static std::atomic<uint8_t> fySyncApPeers(0);       // Followers heard lately (lead: on our AP)
+
+static inline unsigned long fySyncToLocal(uint32_t t) {
+    uint32_t local = t - fySync.offset();
+    return (int32_t)local < 0 ? 0 : local;
+}
+
+// fyAddDetection (fyMutex held): record this unit's sighting. Once a peer
+// has seen the device too, the merged convoy count goes back into d; until
+// then d keeps its own count, which restarts at /api/clear while the sync
+// record's does not.
+static void fySyncNote(FYDetection& d) {
+    if (!fySyncReady) return;
+    FYSyncSighting s;
+    fybPackMAC(d.mac, s.mac);
+    s.rssi = (int8_t)(d.rssi < -128 ? -128 : d.rssi > 127 ? 127 : d.rssi);
+    int m = fyMethodIndex(d.method);
+    s.method = m < 0 ? 0xFF : (uint8_t)m;
+    s.raven = d.isRaven;
+    s.name = d.name;
+    s.fw = d.ravenFW;
+    FYGPSFix f = {0, 0, 0, 0};
+    s.gps = fyGPSCurrent(f);
+    s.gpsLocalMs = f.tMs;
+    s.latE7 = f.latE7;
+    s.lonE7 = f.lonE7;
+    s.accDm = (uint16_t)(f.acc * 10 > 65535 ? 65535 : f.acc * 10);
+    const FYSyncRec* r = fySync.observe(s, millis());
+    if (r && r->origins > 1) d.count = (int)r->count();
+}
+
+// fyMutex held: a peer changed r
+static void fySyncReflect(const FYSyncRec& r) {
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+             r.mac[0], r.mac[1], r.mac[2], r.mac[3], r.mac[4], r.mac[5]);
+    FYDetection* d = NULL;
+    for (int i = 0; i < fyDetCount && !d; i++) {
+        if (strcasecmp(fyDet[i].mac, mac) == 0) d = &fyDet[i];
+    }
+    bool added = false;
+    if (!d) {
+        if (fyDetCount >= MAX_DETECTIONS) return;
+        d = &fyDet[fyDetCount++];
+        memset(d, 0, sizeof(*d));
+        strncpy(d->mac, mac, sizeof(d->mac) - 1);
+        strncpy(d->method, r.method < FY_M_COUNT ? fy_method_names[r.method] : "unknown", sizeof(d->method) - 1);
+        d->isRaven = (r.flags & FY_SYNC_R_RAVEN) != 0;
+        d->firstSeen = fySyncToLocal(r.firstSeen);
+        added = true;
+    }
+    d->count = (int)r.count();
+    // Never move an existing row's firstSeen: records stored before this unit
+    // adopted a peer clock hold convoy times under the old offset, which the
+    // current one would turn into an earlier (clamped to 0) local time
+    unsigned long last = fySyncToLocal(r.lastSeen);
+    if (last > d->lastSeen) d->lastSeen = last;
+    d->rssi = r.rssi;
+    if (r.name[0]) strncpy(d->name, r.name, sizeof(d->name) - 1);
+    if (r.fw[0]) strncpy(d->ravenFW, r.fw, sizeof(d->ravenFW) - 1);
+    if (r.flags & FY_SYNC_R_GPS) {
+        if (!d->hasGPS) fyStats.withGPS++;
+        d->hasGPS = true;
+        d->gpsLat = r.latE7 / 1e7;
+        d->gpsLon = r.lonE7 / 1e7;
+        d->gpsAcc = r.accDm / 10.0f;
+    }
+    if (added) {
+        fyStats.total = fyDetCount;
+        if (r.method < FY_M_COUNT) fyStats.byMethod[r.method]++;
+        if (d->isRaven) fyStats.raven++;
+        fyHistBump(fyStats.histNew, fyMinuteNow());
+    }
+}
+
+static int fySyncUdpIdx = -1;
+
+// fyMutex held. On the lead unit every UDP peer is a follower's station on
+// our AP; the sniffer does not count those as phones (fyWifiHop)
+static void fySyncCountPeers() {
+#ifndef FY_SYNC_UPLINK
+    if (fySyncUdpIdx >= 0) fySyncApPeers = (uint8_t)fySync.peersOn((uint8_t)fySyncUdpIdx, millis());
+#endif
+}
+
+// One packet from any link (AsyncUDP / UART event task). A reply is left
+// queued for the persist task.
+static void fySyncRx(uint8_t link, const uint8_t* data, size_t len) {
+    if (!fyLock(FY_LOCK_SYNC, FY_SYNC_LOCK_MS)) {
+        fySyncLockMisses.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    fySync.receive(link, data, len, millis(), fySyncReflect);
+    bool pending = fySync.pending();
+    fySyncCountPeers();
+    fyUnlock(FY_LOCK_SYNC);
+    if (pending && !fySyncFlushPosted.exchange(true)) fyPersistPost(FY_PERSIST_SYNC);
+}
+
+static AsyncUDP fySyncUdp;
+
+class FYSyncUdpLink : public FYSyncLink {
+public:
+    const char* name() const { return "udp"; }
+    size_t mtu() const { return FY_SYNC_MTU_UDP; }
+    // A follower announces as soon as it is on the lead unit's AP; the lead
+    // unit answers once it has heard someone
+    bool announce() const { return WiFi.status() == WL_CONNECTED; }
+    bool send(const uint8_t* buf, size_t len) {
+        bool ok = fySyncUdp.broadcastTo((uint8_t*)buf, len, FY_SYNC_PORT, TCPIP_ADAPTER_IF_AP) == len;
+        if (WiFi.status() == WL_CONNECTED) {
+            ok = fySyncUdp.broadcastTo((uint8_t*)buf, len, FY_SYNC_PORT, TCPIP_ADAPTER_IF_STA) == len || ok;
+        }
+        return ok;
+    }
+};
+static FYSyncUdpLink fySyncUdpLink;
+
+#ifdef FY_SYNC_SERIAL
+// Unit-to-unit cable on the XIAO's D6 (TX) / D7 (RX). Sends run on the
+// persist task without fyMutex; the TX buffer just keeps them from blocking
+// on every packet.
+#define FY_SYNC_UART_BAUD   460800
+#define FY_SYNC_UART_RX     44
+#define FY_SYNC_UART_TX     43
+#define FY_SYNC_MTU_UART    1024
+#define FY_SYNC_UART_TXBUF  16384
+
+static uint8_t fySyncSlipTx[2 * FY_SYNC_MTU_UART + 2];
+static uint8_t fySyncSlipRx[FY_SYNC_MTU_UART];
+static FYSlipDecoder fySyncSlip(fySyncSlipRx, sizeof(fySyncSlipRx));
+static int fySyncUartIdx = -1;
+
+class FYSyncUartLink : public FYSyncLink {
+public:
+    const char* name() const { return "uart"; }
+    size_t mtu() const { return FY_SYNC_MTU_UART; }
+    bool send(const uint8_t* buf, size_t len) {
+        size_t n = fySlipEncode(buf, len, fySyncSlipTx, sizeof(fySyncSlipTx));
+        return n && Serial1.write(fySyncSlipTx, n) == n;
+    }
+};
+static FYSyncUartLink fySyncUartLink;
+
+static void fySyncUartRx() {
+    while (Serial1.available() > 0) {
+        size_t n = fySyncSlip.feed((uint8_t)Serial1.read());
+        if (n && fySyncUartIdx >= 0) fySyncRx((uint8_t)fySyncUartIdx, fySyncSlip.frame(), n);
+    }
+}
+#endif
+
+// Call after the softAP is up
+static void fySyncInit() {
+    size_t cap = FY_SYNC_TABLE;
+    FYSyncRec* mem = psramFound() ? (FYSyncRec*)ps_malloc(cap * sizeof(FYSyncRec)) : NULL;
+    if (!mem) {
+        cap = MAX_DETECTIONS;
+        mem = (FYSyncRec*)malloc(cap * sizeof(FYSyncRec));
+    }
+    if (!mem) {
+        printf("[FLOCK-YOU] Convoy sync disabled (no memory)\n");
+        return;
+    }
+    uint32_t id;
+    do { id = esp_random(); } while (!id);
+    fySync.init(id, mem, cap);
+    fySync.summaryMs = FY_SYNC_SUMMARY_MS;
+    fySyncUdpIdx = fySync.addLink(&fySyncUdpLink);
+#ifdef FY_SYNC_SERIAL
+    Serial1.setRxBufferSize(4096);
+    Serial1.setTxBufferSize(FY_SYNC_UART_TXBUF);
+    Serial1.begin(FY_SYNC_UART_BAUD, SERIAL_8N1, FY_SYNC_UART_RX, FY_SYNC_UART_TX);
+    fySyncUartIdx = fySync.addLink(&fySyncUartLink);
+    Serial1.onReceive(fySyncUartRx);
+#endif
+#ifdef FY_SYNC_UPLINK
+    WiFi.begin(FY_SYNC_UPLINK, FY_AP_PASS);
+#endif
+    if (fySyncUdp.listen(FY_SYNC_PORT)) {
+        fySyncUdp.onPacket([](AsyncUDPPacket& p) {
+            if (fySyncUdpIdx >= 0) fySyncRx((uint8_t)fySyncUdpIdx, p.data(), p.length());
+        });
+    }
+    fySyncReady = true;
+    printf("[FLOCK-YOU] Convoy sync: node %08x, UDP %u%s\n", (unsigned)id, FY_SYNC_PORT,
+#ifdef FY_SYNC_SERIAL
+           ", UART"
+#else
+           ""
+#endif
+           );
+}
+
+// Persist task: send what is queued. Each packet is built under fyMutex and
+// transmitted after releasing it.
+static uint8_t fySyncOut[FY_SYNC_MTU_MAX];
+
+static void fySyncFlush() {
+    fySyncFlushPosted = false;
+    size_t last = 0;
+    bool ok = false;
+    for (;;) {
+        if (!fyLock(FY_LOCK_SYNC, FY_SYNC_LOCK_MS)) return;
+        if (last) fySync.sent(last, ok);
+        uint8_t link = 0;
+        last = fySync.next(fySyncOut, sizeof(fySyncOut), &link, millis());
+        FYSyncLink* l = last ? fySync.link(link) : NULL;
+        fyUnlock(FY_LOCK_SYNC);
+        if (!last) return;
+        ok = l->send(fySyncOut, last);
+    }
+}
+
+// Persist tick: periodic summaries, plus anything a packet handler queued
+// while the persist queue was full
+static void fySyncTick() {
+    if (!fySyncReady || !fyLock(FY_LOCK_SYNC, FY_SYNC_LOCK_MS)) return;
+    fySync.tick(millis());
+    fySyncCountPeers();
+    fyUnlock(FY_LOCK_SYNC);
+    fySyncFlush();
 }
 
 // ============================================================================
@@ -321,7 +1231,11 @@ static void fyAttachGPS(FYDetection& d) {
 static int fyAddDetection(const char* mac, const char* name, int rssi,
                           const char* method, bool isRaven = false,
                           const char* ravenFW = "") {
-    if (!fyMutex || xSemaphoreTake(fyMutex, pdMS_TO_TICKS(100)) != pdTRUE) return -1;
+    if (!fyLock(FY_LOCK_INSERT, 100)) return -1;
+
+    uint32_t minute = fyMinuteNow();
+    fyStats.sightings.fetch_add(1, std::memory_order_relaxed);
+    fyHistBump(fyStats.histSeen, minute);
 
     // Update existing by MAC
     for (int i = 0; i < fyDetCount; i++) {
@@ -333,8 +1247,13 @@ static int fyAddDetection(const char* mac, const char* name, int rssi,
                 strncpy(fyDet[i].name, name, sizeof(fyDet[i].name) - 1);
             }
             // Update GPS on every re-sighting (captures movement)
+            bool hadGPS = fyDet[i].hasGPS;
             fyAttachGPS(fyDet[i]);
-            xSemaphoreGive(fyMutex);
+            if (!hadGPS && fyDet[i].hasGPS) fyStats.withGPS++;
+            fyKnownNote(fyDet[i]);
+            fySyncNote(fyDet[i]);
+            fyPresenceSeen(i);
+            fyUnlock(FY_LOCK_INSERT);
             return i;
         }
     }
@@ -344,12 +1263,8 @@ static int fyAddDetection(const char* mac, const char* name, int rssi,
         FYDetection& d = fyDet[fyDetCount];
         memset(&d, 0, sizeof(d));
         strncpy(d.mac, mac, sizeof(d.mac) - 1);
-        // Sanitize name for JSON safety
-        if (name) {
-            for (int j = 0; j < (int)sizeof(d.name) - 1 && name[j]; j++) {
-                d.name[j] = (name[j] == '"' || name[j] == '\\') ? '_' : name[j];
-            }
-        }
+        // Stored raw - every writer escapes for its own format (fy_serialize.h)
+        if (name) strncpy(d.name, name, sizeof(d.name) - 1);
         d.rssi = rssi;
         strncpy(d.method, method, sizeof(d.method) - 1);
         d.firstSeen = millis();
@@ -359,22 +1274,481 @@ static int fyAddDetection(const char* mac, const char* name, int rssi,
         strncpy(d.ravenFW, ravenFW ? ravenFW : "", sizeof(d.ravenFW) - 1);
         // Attach GPS from phone
         fyAttachGPS(d);
+        fyKnownNote(d);
+        fySyncNote(d);
         int idx = fyDetCount++;
-        xSemaphoreGive(fyMutex);
+        fyPresenceSeen(idx);
+        fyStats.total = fyDetCount;
+        int m = fyMethodIndex(d.method);
+        if (m >= 0) fyStats.byMethod[m]++;
+        if (d.isRaven) fyStats.raven++;
+        if (d.hasGPS) fyStats.withGPS++;
+        fyHistBump(fyStats.histNew, minute);
+        fyUnlock(FY_LOCK_INSERT);
         return idx;
     }
 
-    xSemaphoreGive(fyMutex);
+    fyUnlock(FY_LOCK_INSERT);
     return -1;
 }
 
+// ============================================================================
+// VERDICT CACHE (see fy_verdict.h)
+// ============================================================================
+
+#define FY_VERDICT_BUCKETS 256   // x4 ways = 1024 advertisers, 12 KB
+#define FY_VERDICT_TTL     60    // seconds before a negative verdict is re-checked
+
+// Only touched from the NimBLE host task (onResult) - no locking needed
+static FYVerdictCache<FY_VERDICT_BUCKETS> fyVerdicts(FY_VERDICT_TTL);
+
+struct FYVerdictStats {
+    std::atomic<uint32_t> lookups;
+    std::atomic<uint32_t> hits;
+    std::atomic<uint32_t> invalidations;   // Same address, new payload
+    std::atomic<uint32_t> missCount;       // Full pipeline runs that cached a verdict
+    std::atomic<uint32_t> missUs;          // ...and their total CPU time
+    std::atomic<uint32_t> hitUs;           // Total time spent on cache hits
+};
+static FYVerdictStats fyVerdictStats;
+
+// Build with -DFY_ADV_TRACE to log every advert and its verdict in the
+// format tools/verdict_replay.cpp reads, for replaying real traffic through
+// the cache off-device. Costs a serial line per advert - capture only.
+static inline void fyAdvTrace(const uint8_t* native, const uint8_t* payload, size_t len,
+                              bool target) {
+#ifdef FY_ADV_TRACE
+    char hex[2 * 62 + 1];             // Advert + scan response
+    size_t n = len < 62 ? len : 62;
+    for (size_t i = 0; i < n; i++) snprintf(hex + 2 * i, 3, "%02x", payload[i]);
+    hex[2 * n] = '\0';
+    printf("ADV %lu %02x%02x%02x%02x%02x%02x %c %s\n", (unsigned long)millis(),
+           native[0], native[1], native[2], native[3], native[4], native[5],
+           target ? 't' : 'n', hex);
+#else
+    (void)native; (void)payload; (void)len; (void)target;
+#endif
+}
+
+// ============================================================================
+// SERIAL STREAM (see fy_replay.h)
+// ============================================================================
+// Detection records on the serial line are numbered per boot and kept in a
+// replay ring, so the host bridge can pick up where it left off after a USB
+// drop instead of re-pulling the table over HTTP:
+//
+//   {"seq":42,"uptime":123456,"boot":"9f3a01c2","detection_method":...}
+//
+// Host -> device, one line:   RESUME <boot> <seq>
+// Answer: {"resume":{"boot":"..","from":a,"to":b,"lost":n}} followed by
+// records a..b, byte-identical to the originals. A different boot id (the
+// unit rebooted) replays everything still retained; lost counts requested
+// records that already aged out. A record that could not be kept goes out
+// as {"seq":N,...,"lost":true}. Live records never interleave with a replay.
+//
+// A replay runs in slices of FY_SERIAL_SLICE lines, releasing fySerialMutex
+// between them. Live records that arrive meanwhile are numbered and stored
+// but not printed - the replay carries on through them in order. A live
+// record that still times out on the mutex is never silently dropped: the
+// next holder numbers it and emits a lost marker in its place.
+
+#define FY_SERIAL_REPLAY      128     // Records retained (PSRAM)
+#define FY_SERIAL_REPLAY_INT  16      // Fallback from internal RAM
+#define FY_SERIAL_SLOT        384     // Longest line kept for replay
+#define FY_SERIAL_LINE_MAX    1024    // Longest line rendered (all-escape worst case ~700)
+#define FY_SERIAL_CMD_MAX     48
+#define FY_SERIAL_SLICE       8       // Replay lines per fySerialMutex hold
+#define FY_SERIAL_LOCK_MS     200     // Live record wait; longest hold is slice_us_max (/api/serial)
+
+static FYReplayRing fySerialRing;
+static SemaphoreHandle_t fySerialMutex = NULL;  // Guards the ring, seq and line buffer
+static uint32_t fySerialSeq = 0;                // Last issued
+static uint32_t fySerialBoot = 0;               // Random per boot, never 0
+static char fySerialBootHex[9];
+static char fySerialLine[FY_SERIAL_LINE_MAX];
+static char fySerialCmd[FY_SERIAL_CMD_MAX];     // Persist task only
+static size_t fySerialCmdLen = 0;
+static bool fySerialReplaying = false;          // Live records are printed by the replay
+static std::atomic<uint32_t> fySerialMissed(0); // Timed out, not yet numbered
+
+struct FYSerialStats {
+    std::atomic<uint32_t> resumes;
+    std::atomic<uint32_t> replayed;    // Records re-sent
+    std::atomic<uint32_t> lost;        // Requested but aged out of the ring
+    std::atomic<uint32_t> dropped;     // fySerialMutex timeout - sent as a lost marker
+    std::atomic<uint32_t> sliceUsMax;  // Longest fySerialMutex hold by a replay slice
+};
+static FYSerialStats fySerialStats;
+
+static void fySerialInit() {
+    fySerialMutex = xSemaphoreCreateMutex();
+    fySerialBoot = esp_random() | 1;
+    snprintf(fySerialBootHex, sizeof(fySerialBootHex), "%08x", (unsigned)fySerialBoot);
+    size_t slots = FY_SERIAL_REPLAY;
+    void* mem = psramFound() ? ps_malloc(FYReplayRing::memFor(slots, FY_SERIAL_SLOT)) : NULL;
+    if (!mem) {
+        slots = FY_SERIAL_REPLAY_INT;
+        mem = malloc(FYReplayRing::memFor(slots, FY_SERIAL_SLOT));
+    }
+    fySerialRing.init(mem, slots, FY_SERIAL_SLOT);
+}
+
+// Caller holds fySerialMutex
+static void fySerialLost(uint32_t seq, uint32_t uptime) {
+    FYStdoutSink so;
+    FYWriter<FYStdoutSink, 128> w(so);
+    w.raw("{\"seq\":").u32(seq).raw(",\"uptime\":").u32(uptime)
+     .raw(",\"boot\":\"").raw(fySerialBootHex).raw("\",\"lost\":true}\n");
+}
+
+// Caller holds fySerialMutex: number the records that timed out on it, in
+// arrival order, as lost markers
+static void fySerialCatchUp() {
+    for (uint32_t n = fySerialMissed.exchange(0); n; n--) {
+        uint32_t seq = ++fySerialSeq;
+        uint32_t uptime = millis();
+        fySerialRing.put(seq, uptime, NULL, FY_SERIAL_SLOT + 1);
+        if (!fySerialReplaying) fySerialLost(seq, uptime);
+    }
+}
+
+// Numbers, stores and emits one record. body(w) writes the fields after the
+// stream header, without the closing brace.
+template <typename Fn>
+static void fySerialRecord(Fn body) {
+    if (!fySerialMutex || xSemaphoreTake(fySerialMutex, pdMS_TO_TICKS(FY_SERIAL_LOCK_MS)) != pdTRUE) {
+        fySerialMissed.fetch_add(1, std::memory_order_relaxed);
+        fySerialStats.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    fySerialCatchUp();
+    uint32_t seq = ++fySerialSeq;
+    uint32_t uptime = millis();
+    FYBufSink line = {(uint8_t*)fySerialLine, sizeof(fySerialLine), 0, false};
+    {
+        FYWriter<FYBufSink, 128> w(line);
+        w.raw("{\"seq\":").u32(seq).raw(",\"uptime\":").u32(uptime)
+         .raw(",\"boot\":\"").raw(fySerialBootHex).raw("\",");
+        body(w);
+        w.raw("}\n");
+    }
+    if (line.overflow) {
+        fySerialRing.put(seq, uptime, NULL, FY_SERIAL_SLOT + 1);
+        if (!fySerialReplaying) fySerialLost(seq, uptime);
+    } else {
+        fySerialRing.put(seq, uptime, fySerialLine, line.len);
+        if (!fySerialReplaying) fwrite(fySerialLine, 1, line.len, stdout);
+    }
+    xSemaphoreGive(fySerialMutex);
+}
+
+// Persist task. Replays from the requested record up to the newest one,
+// including records numbered while the replay runs.
+static void fySerialResume(uint32_t boot, uint32_t seq) {
+    if (!fySerialMutex || xSemaphoreTake(fySerialMutex, pdMS_TO_TICKS(FY_SERIAL_LOCK_MS)) != pdTRUE) return;
+    fySerialCatchUp();
+    uint32_t newest = fySerialRing.newest();
+    uint32_t oldest = fySerialRing.oldest();
+    uint32_t from = boot == fySerialBoot ? seq + 1 : 1;
+    uint32_t lost = 0;
+    if (from > newest + 1) from = newest + 1;
+    if (oldest && from < oldest) {
+        lost = oldest - from;
+        from = oldest;
+    }
+    {
+        FYStdoutSink so;
+        FYWriter<FYStdoutSink, 128> w(so);
+        w.raw("{\"resume\":{\"boot\":\"").raw(fySerialBootHex)
+         .raw("\",\"from\":").u32(from).raw(",\"to\":").u32(newest)
+         .raw(",\"lost\":").u32(lost).raw("}}\n");
+    }
+    fySerialReplaying = true;
+    uint32_t s = from, sent = 0;
+    for (;;) {
+        uint32_t t0 = fyNowUs();
+        for (int i = 0; i < FY_SERIAL_SLICE && s && s <= fySerialRing.newest(); i++, s++, sent++) {
+            const FYReplayRing::Slot* r = fySerialRing.get(s);
+            if (r && r->len) fwrite(r->line, 1, r->len, stdout);
+            else fySerialLost(s, r ? r->uptime : 0);
+        }
+        fySerialCatchUp();
+        bool done = !s || s > fySerialRing.newest();
+        if (done) fySerialReplaying = false;
+        uint32_t held = fyNowUs() - t0;
+        if (held > fySerialStats.sliceUsMax.load(std::memory_order_relaxed)) fySerialStats.sliceUsMax = held;
+        xSemaphoreGive(fySerialMutex);
+        if (done) break;
+        vTaskDelay(1);   // Let a waiting live record in, whatever its priority
+        // Live records are held back until the replay ends - it must finish
+        xSemaphoreTake(fySerialMutex, portMAX_DELAY);
+    }
+    fySerialStats.resumes.fetch_add(1, std::memory_order_relaxed);
+    fySerialStats.replayed.fetch_add(sent, std::memory_order_relaxed);
+    fySerialStats.lost.fetch_add(lost, std::memory_order_relaxed);
+    printf("[FLOCK-YOU] Serial resume: replayed %u, lost %u\n", (unsigned)sent, (unsigned)lost);
+}
+
+// Host commands, polled from the persist task
+static void fySerialPoll() {
+    // Timed-out records get their lost markers even if no later record comes
+    if (fySerialMissed.load(std::memory_order_relaxed) &&
+        xSemaphoreTake(fySerialMutex, pdMS_TO_TICKS(FY_SERIAL_LOCK_MS)) == pdTRUE) {
+        fySerialCatchUp();
+        xSemaphoreGive(fySerialMutex);
+    }
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c < 0) break;
+        if (c != '\n' && c != '\r') {
+            if (fySerialCmdLen < FY_SERIAL_CMD_MAX - 1) fySerialCmd[fySerialCmdLen++] = (char)c;
+            continue;
+        }
+        fySerialCmd[fySerialCmdLen] = '\0';
+        unsigned int boot = 0, seq = 0;
+        if (fySerialCmdLen && sscanf(fySerialCmd, "RESUME %x %u", &boot, &seq) == 2) {
+            fySerialResume(boot, seq);
+        }
+        fySerialCmdLen = 0;
+    }
+}
+
+// ============================================================================
+// DETECTION REPORTING
+// ============================================================================
+
+// Log line, Flask serial JSON and alert for one matched sighting. channel > 0
+// marks a WiFi hit: name is then the SSID and the record uses protocol "wifi".
+static void fyReportDetection(int idx, const char* mac, const char* name, int rssi,
+                              const char* method, bool isRaven, const char* ravenFW,
+                              int channel) {
+    // Human-readable log
+    printf("[FLOCK-YOU] DETECTED: %s %s RSSI:%d [%s] count:%d\n",
+           mac, name, rssi, method, idx >= 0 ? fyDet[idx].count : 0);
+
+    // JSON serial output (Flask-compatible format for live ingestion)
+    fySerialRecord([&](FYWriter<FYBufSink, 128>& w) {
+        w.raw("\"detection_method\":\"").json(method);
+        if (channel > 0) {
+            w.raw("\",\"protocol\":\"wifi\",\"mac_address\":\"").json(mac)
+             .raw("\",\"ssid\":\"").json(name)
+             .raw("\",\"channel\":").i32(channel);
+        } else {
+            w.raw("\",\"protocol\":\"bluetooth_le\",\"mac_address\":\"").json(mac)
+             .raw("\",\"device_name\":\"").json(name).ch('"');
+        }
+        w.raw(",\"rssi\":").i32(rssi);
+        if (isRaven) {
+            w.raw(",\"is_raven\":true,\"raven_fw\":\"").json(ravenFW).ch('"');
+        }
+        FYGPSFix fix;
+        if (fyGPSCurrent(fix)) {
+            w.raw(",\"gps\":{\"latitude\":").fixed(fix.latE7 / 1e7, 8)
+             .raw(",\"longitude\":").fixed(fix.lonE7 / 1e7, 8)
+             .raw(",\"accuracy\":").fixed(fix.acc, 1).ch('}');
+        }
+    });
+
+}
+
+// Radio task: announce queued enter/exit events. The alert sounds once per
+// device entering range (a second device arriving gets its own).
+static void fyPresenceDrain() {
+    FYPresenceEvent e;
+    while (fyPresenceQueue.pop(e)) {
+        bool enter = e.type == FY_PRES_ENTERED;
+        if (enter) {
+            printf("[FLOCK-YOU] %s entered range (visit %u)\n", e.mac, (unsigned)e.visits);
+            fyAudioPlay(FY_SND_DETECT);
+        } else {
+            printf("[FLOCK-YOU] %s out of range after %.1f s\n", e.mac, e.dwellMs / 1000.0);
+        }
+        fySerialRecord([&](FYWriter<FYBufSink, 128>& w) {
+            w.raw("\"event\":\"").raw(enter ? "enter" : "exit")
+             .raw("\",\"mac_address\":\"").json(e.mac)
+             .raw("\",\"visits\":").u32(e.visits);
+            if (!enter) w.raw(",\"dwell_ms\":").u32(e.dwellMs);
+        });
+    }
+}
+
+// ============================================================================
+// RADIO COEXISTENCE (see fy_coex.h)
+// ============================================================================
+// The AP and the BLE scanner share the radio through the coexistence
+// arbiter. The radio tick samples advert and response-byte counters, lets
+// FYCoexPolicy pick BLE / WIFI / BALANCE and applies it with
+// esp_coex_preference_set. Time, adverts and bytes are charged to whichever
+// preference was in force, so /api/coex shows what each one costs.
+//
+// The AP beacon interval is stretched once at boot, before any phone joins
+// (changing the AP config later restarts the AP). Power save stays at
+// MIN_MODEM: the driver requires modem sleep while BLE is enabled, and the
+// AP interface itself never sleeps.
+
+#define FY_COEX_HOLD_MS     5000    // BLE preference after a target sighting
+#define FY_COEX_TX_BPS      16384   // Response throughput that counts as a large transfer
+#define FY_COEX_DWELL_MS    2000    // Minimum time in a preference before leaving it
+#define FY_COEX_BEACON_TU   200     // AP beacon interval, TU (default 100)
+
+static const esp_coex_prefer_t fy_coex_prefer[FY_COEX_MODES] = {
+    ESP_COEX_PREFER_BALANCE, ESP_COEX_PREFER_BT, ESP_COEX_PREFER_WIFI
+};
+
+struct FYCoexStats {
+    std::atomic<uint32_t> adverts;       // Every onResult, before the verdict cache
+    std::atomic<uint32_t> sightings;     // Target matches, BLE and WiFi
+    std::atomic<uint32_t> txBytes;       // Response bytes, every route (fyTxNote)
+    std::atomic<uint32_t> advertsPs;     // During the last full second
+    std::atomic<uint32_t> txBps;
+    std::atomic<uint32_t> switches;
+    std::atomic<uint32_t> setFails;
+    std::atomic<uint32_t> modeMs[FY_COEX_MODES];
+    std::atomic<uint32_t> modeAdverts[FY_COEX_MODES];
+    std::atomic<uint32_t> modeTx[FY_COEX_MODES];
+    uint32_t lastAdverts;                // Radio-tick bookkeeping
+    uint32_t lastTx;
+    uint32_t lastSightings;
+    uint32_t rateAdverts;
+    uint32_t rateTx;
+    unsigned long lastTickMs;
+    unsigned long lastRateMs;
+    uint16_t beaconTU;
+    bool psOk;
+};
+static FYCoexStats fyCoexStats;
+
+// Every response body counts toward the transfer rate: chunked exports as
+// TCP takes each chunk, SPIFFS downloads as the file is read out, streamed
+// and fixed bodies when they are handed to the server.
+static inline void fyTxNote(size_t n) {
+    fyCoexStats.txBytes.fetch_add((uint32_t)n, std::memory_order_relaxed);
+}
+
+// FYWriter sink over an AsyncResponseStream that counts what it writes
+struct FYTxStream {
+    AsyncResponseStream& out;
+    size_t write(const uint8_t* p, size_t n) {
+        fyTxNote(n);
+        return out.write(p, n);
+    }
+};
+
+static void fySend(AsyncWebServerRequest* r, int code, const char* type, const char* body) {
+    fyTxNote(strlen(body));
+    r->send(code, type, body);
+}
+
+// SPIFFS file response, counted as it is read out
+static AsyncWebServerResponse* fyFileResponse(AsyncWebServerRequest* r, const char* path, const char* type) {
+    File f = SPIFFS.open(path, "r");
+    if (!f) return NULL;
+    size_t len = f.size();
+    return r->beginResponse(type, len, [f](uint8_t* buf, size_t maxLen, size_t index) mutable -> size_t {
+        size_t n = f.read(buf, maxLen);
+        fyTxNote(n);
+        if (!n) f.close();
+        return n;
+    });
+}
+
+// Written by /api/coex, copied into the policy by the radio tick
+static std::atomic<uint8_t> fyCoexPin(FY_COEX_AUTO);
+static std::atomic<uint32_t> fyCoexHoldMs(FY_COEX_HOLD_MS);
+static std::atomic<uint32_t> fyCoexTxBps(FY_COEX_TX_BPS);
+
+static FYCoexPolicy fyCoex(FY_COEX_HOLD_MS, FY_COEX_TX_BPS, FY_COEX_DWELL_MS);
+static std::atomic<uint8_t> fyCoexApplied(FY_COEX_MODES);   // Preference in force
+static bool fyCoexActive = false;
+
+static bool fyCoexApply(uint8_t mode) {
+    if (esp_coex_preference_set(fy_coex_prefer[mode]) != ESP_OK) {
+        fyCoexStats.setFails.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    fyCoexApplied.store(mode, std::memory_order_relaxed);
+    return true;
+}
+
+// Call after the softAP is up, before any station can have joined
+static void fyCoexInit() {
+    wifi_config_t conf;
+    if (esp_wifi_get_config(WIFI_IF_AP, &conf) == ESP_OK) {
+        fyCoexStats.beaconTU = conf.ap.beacon_interval;
+        conf.ap.beacon_interval = FY_COEX_BEACON_TU;
+        if (esp_wifi_set_config(WIFI_IF_AP, &conf) == ESP_OK) fyCoexStats.beaconTU = FY_COEX_BEACON_TU;
+    }
+    fyCoexStats.psOk = esp_wifi_set_ps(WIFI_PS_MIN_MODEM) == ESP_OK;
+    fyCoexApply(FY_COEX_BALANCE);
+    fyCoexStats.lastTickMs = fyCoexStats.lastRateMs = millis();
+    fyCoexActive = true;
+    printf("[FLOCK-YOU] Coexistence: beacon %u TU, modem sleep %s, preference %s\n",
+           (unsigned)fyCoexStats.beaconTU, fyCoexStats.psOk ? "on" : "FAILED",
+           fy_coex_mode_names[fyCoexApplied.load()]);
+}
+
+// Radio tick: charge the interval to the preference in force, refresh the
+// per-second rates, then re-decide
+static void fyCoexTick() {
+    FYCoexStats& s = fyCoexStats;
+    unsigned long now = millis();
+    uint32_t adv = s.adverts.load(std::memory_order_relaxed);
+    uint32_t tx = s.txBytes.load(std::memory_order_relaxed);
+    uint32_t sight = s.sightings.load(std::memory_order_relaxed);
+
+    uint8_t cur = fyCoexApplied.load(std::memory_order_relaxed);
+    if (cur < FY_COEX_MODES) {
+        s.modeMs[cur].fetch_add((uint32_t)(now - s.lastTickMs), std::memory_order_relaxed);
+        s.modeAdverts[cur].fetch_add(adv - s.lastAdverts, std::memory_order_relaxed);
+        s.modeTx[cur].fetch_add(tx - s.lastTx, std::memory_order_relaxed);
+    }
+    s.lastTickMs = now;
+    s.lastAdverts = adv;
+    s.lastTx = tx;
+
+    if (now - s.lastRateMs >= 1000) {
+        unsigned long dt = now - s.lastRateMs;
+        s.advertsPs = (uint32_t)((uint64_t)(adv - s.rateAdverts) * 1000 / dt);
+        s.txBps = (uint32_t)((uint64_t)(tx - s.rateTx) * 1000 / dt);
+        s.rateAdverts = adv;
+        s.rateTx = tx;
+        s.lastRateMs = now;
+    }
+
+    fyCoex.pinned = fyCoexPin.load(std::memory_order_relaxed);
+    fyCoex.holdMs = fyCoexHoldMs.load(std::memory_order_relaxed);
+    fyCoex.txBps = fyCoexTxBps.load(std::memory_order_relaxed);
+    uint8_t want = fyCoex.update(now, sight - s.lastSightings, s.txBps.load(std::memory_order_relaxed));
+    s.lastSightings = sight;
+    if (want != cur && fyCoexApply(want)) s.switches.fetch_add(1, std::memory_order_relaxed);
+}
+
 // ============================================================================
 // BLE SCANNING
 // ============================================================================
 
 class FYBLECallbacks : public NimBLEAdvertisedDeviceCallbacks {
     void onResult(NimBLEAdvertisedDevice* dev) override {
+        int64_t t0 = esp_timer_get_time();
+        fyCoexStats.adverts.fetch_add(1, std::memory_order_relaxed);
+        if (!fyBoot.firstAdvertUs.load(std::memory_order_relaxed)) {
+            fyBoot.firstAdvertUs.store((uint32_t)t0, std::memory_order_relaxed);
+        }
         NimBLEAddress addr = dev->getAddress();
+
+        // Short-circuit repeat adverts already judged non-target
+        const uint8_t* native = addr.getNative();
+        uint32_t payloadHash = fyVerdictHash(dev->getPayload(), dev->getPayloadLength());
+        uint16_t nowSec = (uint16_t)(millis() / 1000);
+        fyVerdictStats.lookups.fetch_add(1, std::memory_order_relaxed);
+        if (fyVerdicts.lookup(native, payloadHash, nowSec)) {
+            fyVerdictStats.hits.fetch_add(1, std::memory_order_relaxed);
+            fyVerdictStats.hitUs.fetch_add((uint32_t)(esp_timer_get_time() - t0),
+                                           std::memory_order_relaxed);
+            fyAdvTrace(native, dev->getPayload(), dev->getPayloadLength(), false);
+            return;
+        }
+
         std::string addrStr = addr.toString();
 
         // Safe MAC byte extraction
@@ -431,72 +1805,218 @@ class FYBLECallbacks : public NimBLEAdvertisedDeviceCallbacks {
             }
         }
 
-        if (detected) {
-            int idx = fyAddDetection(addrStr.c_str(), name.c_str(), rssi,
-                                     method, isRaven, ravenFW);
+        if (!detected) {
+            if (fyVerdicts.insert(native, payloadHash, nowSec)) {
+                fyVerdictStats.invalidations.fetch_add(1, std::memory_order_relaxed);
+            }
+            fyVerdictStats.missCount.fetch_add(1, std::memory_order_relaxed);
+            fyVerdictStats.missUs.fetch_add((uint32_t)(esp_timer_get_time() - t0),
+                                            std::memory_order_relaxed);
+            fyAdvTrace(native, dev->getPayload(), dev->getPayloadLength(), false);
+            return;
+        }
+        fyAdvTrace(native, dev->getPayload(), dev->getPayloadLength(), true);
 
-            // Human-readable log
-            printf("[FLOCK-YOU] DETECTED: %s %s RSSI:%d [%s] count:%d\n",
-                   addrStr.c_str(), name.c_str(), rssi, method,
-                   idx >= 0 ? fyDet[idx].count : 0);
+        fyCoexStats.sightings.fetch_add(1, std::memory_order_relaxed);
+        int idx = fyAddDetection(addrStr.c_str(), name.c_str(), rssi,
+                                 method, isRaven, ravenFW);
+        fyReportDetection(idx, addrStr.c_str(), name.c_str(), rssi, method,
+                          isRaven, ravenFW, 0);
+    }
+};
 
-            // JSON serial output (Flask-compatible format for live ingestion)
-            // Build GPS fragment if available
-            char gpsBuf[80] = "";
-            if (fyGPSIsFresh()) {
-                snprintf(gpsBuf, sizeof(gpsBuf),
-                    ",\"gps\":{\"latitude\":%.8f,\"longitude\":%.8f,\"accuracy\":%.1f}",
-                    fyGPSLat, fyGPSLon, fyGPSAcc);
-            }
-            if (isRaven) {
-                printf("{\"detection_method\":\"%s\",\"protocol\":\"bluetooth_le\","
-                       "\"mac_address\":\"%s\",\"device_name\":\"%s\","
-                       "\"rssi\":%d,\"is_raven\":true,\"raven_fw\":\"%s\"%s}\n",
-                       method, addrStr.c_str(), name.c_str(), rssi, ravenFW, gpsBuf);
-            } else {
-                printf("{\"detection_method\":\"%s\",\"protocol\":\"bluetooth_le\","
-                       "\"mac_address\":\"%s\",\"device_name\":\"%s\","
-                       "\"rssi\":%d%s}\n",
-                       method, addrStr.c_str(), name.c_str(), rssi, gpsBuf);
-            }
+// ============================================================================
+// WIFI SNIFFER (see fy_wifi_frames.h)
+// ============================================================================
+// Promiscuous RX runs on the same radio as the dashboard AP. The RX callback
+// executes in the WiFi driver task, so it only matches the frame, pushes a
+// hit into a lock-free ring and wakes the radio task, which drains the ring
+// into the table.
+//
+// Channel hopping is scheduled around AP duty: the radio leaves the AP
+// channel only while no phone is associated, dwells briefly on one foreign
+// channel, then returns home before the next hop so the AP keeps beaconing.
+// With a client connected it stays on the AP channel.
+
+#define FY_WIFI_SSID_PREFIX "Flock-"
+#define FY_WIFI_RING        64      // Matched frames buffered between drains
+#define FY_WIFI_DWELL_MS    120     // Time on each foreign channel
+#define FY_WIFI_HOME_MS     240     // Time back on the AP channel between hops
+#define FY_WIFI_MAX_CHANNEL 13
+#define FY_WIFI_REPORT_MS   2000    // Serial/log rate limit per device (beacons ~10/s)
+
+#define FY_MAC_PREFIX_COUNT (sizeof(mac_prefixes)/sizeof(mac_prefixes[0]))
+
+static uint32_t fyWifiOUIs[FY_MAC_PREFIX_COUNT];    // Sorted, for binary search
+static size_t fyWifiOUICount = 0;
+static FYSpscRing<FYWifiHit, FY_WIFI_RING> fyWifiRing;
+static bool fyWifiActive = false;
+static uint8_t fyWifiHome = 1;
+static uint8_t fyWifiNext = 1;
+static std::atomic<uint8_t> fyWifiChannel(1);
+static esp_timer_handle_t fyWifiHopTimer = NULL;
+static unsigned long fyWifiLastReport[MAX_DETECTIONS];
+
+struct FYWifiStats {
+    std::atomic<uint32_t> frames;      // Every frame the RX callback saw
+    std::atomic<uint32_t> matched;
+    std::atomic<uint32_t> dropped;     // Ring full - radio task fell behind
+    std::atomic<uint32_t> hops;
+    std::atomic<uint32_t> fps;         // Frames during the last full second
+    std::atomic<uint32_t> matchedPs;   // Matches during the last full second
+    uint32_t lastFrames;               // Radio-tick rate bookkeeping
+    uint32_t lastMatched;
+    unsigned long lastRateMs;
+};
+static FYWifiStats fyWifiStats;
+
+static void fyWifiRx(void* buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    fyWifiStats.frames.fetch_add(1, std::memory_order_relaxed);
+    // sig_len includes the 4-byte FCS
+    size_t len = pkt->rx_ctrl.sig_len > 4 ? pkt->rx_ctrl.sig_len - 4 : 0;
+    FYWifiHit hit;
+    if (!fyWifiMatch(pkt->payload, len, fyWifiOUIs, fyWifiOUICount,
+                     FY_WIFI_SSID_PREFIX, &hit)) return;
+    hit.rssi = (int8_t)pkt->rx_ctrl.rssi;
+    hit.channel = (uint8_t)pkt->rx_ctrl.channel;
+    fyWifiStats.matched.fetch_add(1, std::memory_order_relaxed);
+    if (!fyWifiRing.push(hit)) fyWifiStats.dropped.fetch_add(1, std::memory_order_relaxed);
+    fyRadioSignal(FY_EV_WIFI_HIT);
+}
 
-            if (!fyTriggered) {
-                fyTriggered = true;
-                fyDetectBeep();
-            }
-            fyDeviceInRange = true;
-            fyLastDetTime = millis();
-            fyLastHB = millis();
+// esp_timer callback - alternates home / foreign channel, re-arms itself
+static void fyWifiHop(void*) {
+    // Convoy follower on the lead unit's AP: the channel is not ours to change
+    if (WiFi.status() == WL_CONNECTED) {
+        esp_timer_start_once(fyWifiHopTimer, (uint64_t)FY_WIFI_HOME_MS * 1000);
+        return;
+    }
+    uint8_t cur = fyWifiChannel.load(std::memory_order_relaxed);
+    uint8_t target = fyWifiHome;
+    uint32_t holdMs = FY_WIFI_HOME_MS;
+    // Hop only while no phone is on the AP. Convoy followers stay joined
+    // for the whole drive and tolerate the dwell, so they do not count.
+    int phones = (int)WiFi.softAPgetStationNum() - (int)fySyncApPeers.load(std::memory_order_relaxed);
+    if (cur == fyWifiHome && phones <= 0) {
+        target = fyWifiNext;
+        do {
+            fyWifiNext = fyWifiNext % FY_WIFI_MAX_CHANNEL + 1;
+        } while (fyWifiNext == fyWifiHome);
+        holdMs = FY_WIFI_DWELL_MS;
+        fyWifiStats.hops.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (target != cur && esp_wifi_set_channel(target, WIFI_SECOND_CHAN_NONE) == ESP_OK) {
+        fyWifiChannel.store(target, std::memory_order_relaxed);
+    }
+    esp_timer_start_once(fyWifiHopTimer, (uint64_t)holdMs * 1000);
+}
+
+// Call after the softAP is up
+static void fyWifiSnifferInit() {
+    // OUI table from mac_prefixes, sorted and de-duplicated
+    fyWifiOUICount = 0;
+    for (size_t i = 0; i < FY_MAC_PREFIX_COUNT; i++) {
+        unsigned int a, b, c;
+        if (sscanf(mac_prefixes[i], "%02x:%02x:%02x", &a, &b, &c) != 3) continue;
+        uint32_t oui = (a << 16) | (b << 8) | c;
+        size_t j = fyWifiOUICount;
+        while (j > 0 && fyWifiOUIs[j - 1] > oui) { fyWifiOUIs[j] = fyWifiOUIs[j - 1]; j--; }
+        if (j > 0 && fyWifiOUIs[j - 1] == oui) {
+            memmove(&fyWifiOUIs[j], &fyWifiOUIs[j + 1], (fyWifiOUICount - j) * sizeof(uint32_t));
+            continue;
         }
+        fyWifiOUIs[j] = oui;
+        fyWifiOUICount++;
     }
-};
+
+    uint8_t primary = 1;
+    wifi_second_chan_t second;
+    if (esp_wifi_get_channel(&primary, &second) == ESP_OK && primary) fyWifiHome = primary;
+    fyWifiChannel = fyWifiHome;
+    fyWifiNext = fyWifiHome % FY_WIFI_MAX_CHANNEL + 1;
+
+    wifi_promiscuous_filter_t filter = {};
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_DATA;
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(&fyWifiRx);
+    if (esp_wifi_set_promiscuous(true) != ESP_OK) {
+        printf("[FLOCK-YOU] WiFi sniffer unavailable\n");
+        return;
+    }
+    fyWifiActive = true;
+
+    esp_timer_create_args_t args = {};
+    args.callback = &fyWifiHop;
+    args.name = "fy_wifi_hop";
+    if (esp_timer_create(&args, &fyWifiHopTimer) == ESP_OK) {
+        esp_timer_start_once(fyWifiHopTimer, (uint64_t)FY_WIFI_HOME_MS * 1000);
+    }
+    fyWifiStats.lastRateMs = millis();
+    printf("[FLOCK-YOU] WiFi sniffer ACTIVE (%u OUIs, SSID \"%s*\", AP ch %u)\n",
+           (unsigned)fyWifiOUICount, FY_WIFI_SSID_PREFIX, fyWifiHome);
+}
+
+// Radio task side: move queued hits into the table
+static void fyWifiDrain() {
+    FYWifiHit h;
+    while (fyWifiRing.pop(h)) {
+        char mac[18];
+        snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 h.mac[0], h.mac[1], h.mac[2], h.mac[3], h.mac[4], h.mac[5]);
+        const char* method = h.reason == FY_WIFI_MATCH_SSID ? "wifi_ssid" : "wifi_oui";
+        fyCoexStats.sightings.fetch_add(1, std::memory_order_relaxed);
+        int idx = fyAddDetection(mac, h.ssid, h.rssi, method);
+        // A beaconing AP matches ~10x/s: table stays current, reports are throttled
+        if (idx >= 0 && fyDet[idx].count > 1 &&
+            millis() - fyWifiLastReport[idx] < FY_WIFI_REPORT_MS) continue;
+        if (idx >= 0) fyWifiLastReport[idx] = millis();
+        fyReportDetection(idx, mac, h.ssid, h.rssi, method, false, "", h.channel);
+    }
+}
+
+// Radio tick: per-second frame/match rates
+static void fyWifiRates() {
+    unsigned long now = millis();
+    if (now - fyWifiStats.lastRateMs >= 1000) {
+        uint32_t f = fyWifiStats.frames.load(std::memory_order_relaxed);
+        uint32_t m = fyWifiStats.matched.load(std::memory_order_relaxed);
+        unsigned long dt = now - fyWifiStats.lastRateMs;
+        fyWifiStats.fps = (uint32_t)((uint64_t)(f - fyWifiStats.lastFrames) * 1000 / dt);
+        fyWifiStats.matchedPs = (uint32_t)((uint64_t)(m - fyWifiStats.lastMatched) * 1000 / dt);
+        fyWifiStats.lastFrames = f;
+        fyWifiStats.lastMatched = m;
+        fyWifiStats.lastRateMs = now;
+    }
+}
 
 // ============================================================================
 // JSON HELPER
 // ============================================================================
 
-static void writeDetectionsJSON(AsyncResponseStream *resp) {
-    resp->print("[");
-    if (fyMutex && xSemaphoreTake(fyMutex, pdMS_TO_TICKS(200)) == pdTRUE) {
-        for (int i = 0; i < fyDetCount; i++) {
-            if (i > 0) resp->print(",");
-            resp->printf(
-                "{\"mac\":\"%s\",\"name\":\"%s\",\"rssi\":%d,\"method\":\"%s\","
-                "\"first\":%lu,\"last\":%lu,\"count\":%d,"
-                "\"raven\":%s,\"fw\":\"%s\"",
-                fyDet[i].mac, fyDet[i].name, fyDet[i].rssi, fyDet[i].method,
-                fyDet[i].firstSeen, fyDet[i].lastSeen, fyDet[i].count,
-                fyDet[i].isRaven ? "true" : "false", fyDet[i].ravenFW);
-            // Append GPS if present
-            if (fyDet[i].hasGPS) {
-                resp->printf(",\"gps\":{\"lat\":%.8f,\"lon\":%.8f,\"acc\":%.1f}",
-                    fyDet[i].gpsLat, fyDet[i].gpsLon, fyDet[i].gpsAcc);
-            }
-            resp->print("}");
-        }
-        xSemaphoreGive(fyMutex);
+// One detection object - shared by the web export and the SPIFFS session file
+template <typename W>
+static void fyWriteDetJSON(W& w, const FYDetection& d) {
+    w.raw("{\"mac\":\"").json(d.mac)
+     .raw("\",\"name\":\"").json(d.name)
+     .raw("\",\"rssi\":").i32(d.rssi)
+     .raw(",\"method\":\"").json(d.method)
+     .raw("\",\"first\":").u32(d.firstSeen)
+     .raw(",\"last\":").u32(d.lastSeen)
+     .raw(",\"count\":").i32(d.count)
+     .raw(",\"raven\":").boolean(d.isRaven)
+     .raw(",\"fw\":\"").json(d.ravenFW).ch('"');
+    if (d.knownSessions) w.raw(",\"known\":").u32(d.knownSessions);
+    w.raw(",\"pres\":\"").raw(fy_presence_names[d.presence])
+     .raw("\",\"visits\":").u32(d.visits)
+     .raw(",\"dwell\":").u32(fyDwellMs(d));
+    // Append GPS if present
+    if (d.hasGPS) {
+        w.raw(",\"gps\":{\"lat\":").fixed(d.gpsLat, 8)
+         .raw(",\"lon\":").fixed(d.gpsLon, 8)
+         .raw(",\"acc\":").fixed(d.gpsAcc, 1).ch('}');
     }
-    resp->print("]");
+    w.ch('}');
 }
 
 // ============================================================================
@@ -504,38 +2024,30 @@ static void writeDetectionsJSON(AsyncResponseStream *resp) {
 // ============================================================================
 
 static void fySaveSession() {
-    if (!fySpiffsReady || !fyMutex) return;
-    if (xSemaphoreTake(fyMutex, pdMS_TO_TICKS(300)) != pdTRUE) return;
+    if (!fySpiffsReady || !fyLock(FY_LOCK_SAVE, 300)) return;
 
     File f = SPIFFS.open(FY_SESSION_FILE, "w");
-    if (!f) { xSemaphoreGive(fyMutex); return; }
+    if (!f) { fyUnlock(FY_LOCK_SAVE); return; }
 
-    f.print("[");
-    for (int i = 0; i < fyDetCount; i++) {
-        if (i > 0) f.print(",");
-        FYDetection& d = fyDet[i];
-        f.printf("{\"mac\":\"%s\",\"name\":\"%s\",\"rssi\":%d,\"method\":\"%s\","
-                 "\"first\":%lu,\"last\":%lu,\"count\":%d,"
-                 "\"raven\":%s,\"fw\":\"%s\"",
-                 d.mac, d.name, d.rssi, d.method,
-                 d.firstSeen, d.lastSeen, d.count,
-                 d.isRaven ? "true" : "false", d.ravenFW);
-        if (d.hasGPS) {
-            f.printf(",\"gps\":{\"lat\":%.8f,\"lon\":%.8f,\"acc\":%.1f}", d.gpsLat, d.gpsLon, d.gpsAcc);
+    {
+        FYWriter<File> w(f);
+        w.ch('[');
+        for (int i = 0; i < fyDetCount; i++) {
+            if (i > 0) w.ch(',');
+            fyWriteDetJSON(w, fyDet[i]);
         }
-        f.print("}");
+        w.ch(']');
     }
-    f.print("]");
     f.close();
     fyLastSaveCount = fyDetCount;
     printf("[FLOCK-YOU] Session saved: %d detections\n", fyDetCount);
-    xSemaphoreGive(fyMutex);
+    fyUnlock(FY_LOCK_SAVE);
 }
 
 static void fyPromotePrevSession() {
     // Copy current session to prev_session on boot, then delete original
     // NOTE: SPIFFS.rename() is unreliable on ESP32 — use copy+delete instead
-    if (!fySpiffsReady) return;
+    // Runs from fyPersistBoot() once mounted, before fySpiffsReady is set
     if (!SPIFFS.exists(FY_SESSION_FILE)) {
         printf("[FLOCK-YOU] No prior session file to promote\n");
         return;
@@ -546,68 +2058,401 @@ static void fyPromotePrevSession() {
         printf("[FLOCK-YOU] Failed to open session file for promotion\n");
         return;
     }
-    String data = src.readString();
-    src.close();
+    if (src.size() == 0) {
+        src.close();
+        printf("[FLOCK-YOU] Session file empty, skipping promotion\n");
+        SPIFFS.remove(FY_SESSION_FILE);
+        return;
+    }
+
+    // Write to prev_session (overwrite any existing), streamed in small
+    // chunks rather than buffering the whole file in a String
+    File dst = SPIFFS.open(FY_PREV_FILE, "w");
+    if (!dst) {
+        src.close();
+        printf("[FLOCK-YOU] Failed to create prev_session file\n");
+        return;
+    }
+    uint8_t buf[512];
+    size_t total = 0, n;
+    while ((n = src.read(buf, sizeof(buf))) > 0) {
+        dst.write(buf, n);
+        total += n;
+    }
+    src.close();
+    dst.close();
+
+    // Delete the old session file so it doesn't get re-promoted next boot
+    SPIFFS.remove(FY_SESSION_FILE);
+    printf("[FLOCK-YOU] Prior session promoted: %u bytes\n", (unsigned)total);
+}
+
+// ============================================================================
+// BOOT METRICS
+// ============================================================================
+
+static void fyBootSave() {
+    FYBootRecord hist[FY_BOOT_HISTORY];
+    size_t n = 0;
+    if (SPIFFS.exists(FY_BOOT_FILE)) {
+        File f = SPIFFS.open(FY_BOOT_FILE, "r");
+        if (f) {
+            n = f.read((uint8_t*)hist, sizeof(hist)) / sizeof(FYBootRecord);
+            f.close();
+        }
+    }
+    if (n == FY_BOOT_HISTORY) {
+        memmove(&hist[0], &hist[1], (n - 1) * sizeof(FYBootRecord));
+        n--;
+    }
+    FYBootRecord& b = hist[n++];
+    memset(&b, 0, sizeof(b));
+    b.scanStartUs = fyBoot.scanStartUs;
+    b.firstAdvertUs = fyBoot.firstAdvertUs;
+    b.apUpUs = fyBoot.apUpUs;
+    b.dashboardUs = fyBoot.dashboardUs;
+    b.fsReadyUs = fyBoot.fsReadyUs;
+    b.session = fyKnownSession;
+    b.resetReason = (uint8_t)esp_reset_reason();
+
+    File f = SPIFFS.open(FY_BOOT_FILE, "w");
+    if (!f) return;
+    f.write((const uint8_t*)hist, n * sizeof(FYBootRecord));
+    f.close();
+    printf("[FLOCK-YOU] Boot: scan %.0f ms, first advert %.0f ms, AP %.0f ms, dashboard %.0f ms\n",
+           b.scanStartUs / 1000.0, b.firstAdvertUs / 1000.0, b.apUpUs / 1000.0, b.dashboardUs / 1000.0);
+}
+
+template <typename W>
+static void fyWriteBootJSON(W& w, const FYBootRecord& b) {
+    w.raw("{\"session\":").u32(b.session)
+     .raw(",\"reset_reason\":").u32(b.resetReason)
+     .raw(",\"scan_start_ms\":").fixed(b.scanStartUs / 1000.0, 1)
+     .raw(",\"first_advert_ms\":");
+    if (b.firstAdvertUs) w.fixed(b.firstAdvertUs / 1000.0, 1);
+    else w.raw("null");
+    w.raw(",\"ap_up_ms\":").fixed(b.apUpUs / 1000.0, 1)
+     .raw(",\"dashboard_ms\":").fixed(b.dashboardUs / 1000.0, 1)
+     .raw(",\"fs_ready_ms\":").fixed(b.fsReadyUs / 1000.0, 1)
+     .ch('}');
+}
+
+// ============================================================================
+// RESPONSE POOL (see fy_respool.h)
+// ============================================================================
+// The detection list and every export are generated lazily into one pooled
+// chunk per request. Each filler call that finds the chunk drained refills it
+// a row at a time under one short fyMutex hold, then hands it to AsyncTCP as
+// the window opens. No body is ever built in full, and when every chunk is
+// out the request is answered 503 + Retry-After instead of allocating.
+
+#define FY_RESP_CHUNKS       6       // Concurrent data responses (PSRAM)
+#define FY_RESP_CHUNK        8192
+#define FY_RESP_CHUNKS_INT   3       // Fallback from internal RAM without PSRAM
+#define FY_RESP_CHUNK_INT    2048
+#define FY_RESP_UNIT_MAX     1024    // Largest single row / header piece, escaped
+#define FY_RESP_LOCK_MS      50
+#define FY_RESP_RETRY_AFTER  "2"
+
+static FYChunkPool<FY_RESP_CHUNKS> fyRespPool;
+
+struct FYRespStats {
+    std::atomic<uint32_t> served;      // Responses finished or aborted by the client
+    std::atomic<uint32_t> bytes;
+    std::atomic<uint32_t> latSumMs;    // Request to last byte handed to TCP
+    std::atomic<uint32_t> latMaxMs;
+    std::atomic<uint32_t> lockMisses;  // Refill deferred (fyMutex busy)
+    std::atomic<uint32_t> auxBytes;    // Per-request side memory (generators, binary string table)
+    std::atomic<uint32_t> auxPeak;
+};
+static FYRespStats fyRespStats;
+
+static void fyRespInit() {
+    size_t count = FY_RESP_CHUNKS, size = FY_RESP_CHUNK;
+    uint8_t* mem = psramFound() ? (uint8_t*)ps_malloc(count * size) : NULL;
+    if (!mem) {
+        count = FY_RESP_CHUNKS_INT;
+        size = FY_RESP_CHUNK_INT;
+        mem = (uint8_t*)malloc(count * size);
+    }
+    fyRespPool.init(mem, count, size);
+    printf("[FLOCK-YOU] Response pool: %u x %u bytes%s\n",
+           (unsigned)fyRespPool.count(), (unsigned)fyRespPool.chunkSize(),
+           psramFound() ? " (PSRAM)" : "");
+}
+
+static void fyRespAux(int32_t delta) {
+    uint32_t n = fyRespStats.auxBytes.fetch_add((uint32_t)delta, std::memory_order_relaxed) + delta;
+    fyStatMax(fyRespStats.auxPeak, n);
+}
+
+class FYRespGen {
+public:
+    FYRespGen() : _chunk(-1), _off(0), _done(false), _startUs(fyNowUs()), _bytes(0), _self(0) {
+        _sink.buf = NULL;
+        _sink.cap = _sink.len = 0;
+        _sink.overflow = false;
+    }
+
+    virtual ~FYRespGen() {
+        if (_self) fyRespAux(-(int32_t)_self);
+        if (_chunk < 0) return;
+        fyRespPool.release(_chunk);
+        uint32_t ms = (fyNowUs() - _startUs) / 1000;
+        fyRespStats.served.fetch_add(1, std::memory_order_relaxed);
+        fyRespStats.bytes.fetch_add(_bytes, std::memory_order_relaxed);
+        fyRespStats.latSumMs.fetch_add(ms, std::memory_order_relaxed);
+        fyStatMax(fyRespStats.latMaxMs, ms);
+    }
+
+    // self: sizeof the concrete generator, counted as aux while it lives
+    void attach(int chunk, size_t self) {
+        _self = self;
+        fyRespAux((int32_t)self);
+        _chunk = chunk;
+        _sink.buf = fyRespPool.chunk(chunk);
+        _sink.cap = fyRespPool.chunkSize();
+    }
+
+    // AwsResponseFiller body: 0 ends the response
+    size_t fill(uint8_t* dst, size_t maxLen) {
+        if (_off == _sink.len) {
+            if (_done) return 0;
+            _sink.len = _off = 0;
+            if (!fyLock(FY_LOCK_RESP, FY_RESP_LOCK_MS)) {
+                fyRespStats.lockMisses.fetch_add(1, std::memory_order_relaxed);
+                return RESPONSE_TRY_AGAIN;
+            }
+            while (!_done && _sink.cap - _sink.len >= FY_RESP_UNIT_MAX) _done = !produce(_sink);
+            fyUnlock(FY_LOCK_RESP);
+            if (_sink.len == 0) return 0;
+        }
+        size_t n = _sink.len - _off;
+        if (n > maxLen) n = maxLen;
+        memcpy(dst, _sink.buf + _off, n);
+        _off += n;
+        _bytes += n;
+        fyTxNote(n);
+        return n;
+    }
+
+protected:
+    // Emit the next unit (header, one row or footer) with fyMutex held;
+    // false once the last one is written
+    virtual bool produce(FYBufSink& s) = 0;
+
+private:
+    int _chunk;
+    FYBufSink _sink;
+    size_t _off;
+    bool _done;
+    uint32_t _startUs;
+    uint32_t _bytes;
+    size_t _self;
+};
+
+// Rows appended mid-download are included and a clear ends the list early;
+// the text formats stay well-formed either way.
+class FYJsonGen : public FYRespGen {
+public:
+    FYJsonGen() : _row(-1) {}
+protected:
+    bool produce(FYBufSink& s) {
+        FYWriter<FYBufSink, 128> w(s);
+        if (_row < 0) { w.ch('['); _row = 0; return true; }
+        if (_row >= fyDetCount) { w.ch(']'); return false; }
+        if (_row) w.ch(',');
+        fyWriteDetJSON(w, fyDet[_row++]);
+        return true;
+    }
+private:
+    int _row;
+};
+
+class FYCsvGen : public FYRespGen {
+public:
+    FYCsvGen() : _row(-1) {}
+protected:
+    bool produce(FYBufSink& s) {
+        FYWriter<FYBufSink, 128> w(s);
+        if (_row < 0) {
+            w.raw("mac,name,rssi,method,first_seen_ms,last_seen_ms,count,is_raven,raven_fw,latitude,longitude,gps_accuracy,visits,dwell_ms\r\n");
+            _row = 0;
+            return true;
+        }
+        if (_row >= fyDetCount) return false;
+        const FYDetection& d = fyDet[_row++];
+        w.ch('"').csv(d.mac).raw("\",\"").csv(d.name).raw("\",").i32(d.rssi)
+         .raw(",\"").csv(d.method).raw("\",").u32(d.firstSeen)
+         .ch(',').u32(d.lastSeen).ch(',').i32(d.count)
+         .ch(',').boolean(d.isRaven).raw(",\"").csv(d.ravenFW).raw("\",");
+        if (d.hasGPS) {
+            w.fixed(d.gpsLat, 8).ch(',').fixed(d.gpsLon, 8).ch(',').fixed(d.gpsAcc, 1);
+        } else {
+            w.raw(",,");
+        }
+        w.ch(',').u32(d.visits).ch(',').u32(fyDwellMs(d)).ch('\n');
+        return true;
+    }
+private:
+    int _row;
+};
+
+class FYKmlGen : public FYRespGen {
+public:
+    FYKmlGen() : _row(-1) {}
+protected:
+    bool produce(FYBufSink& s) {
+        FYWriter<FYBufSink, 128> w(s);
+        if (_row < 0) {
+            w.raw("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n"
+                  "<name>Flock-You Detections</name>\n"
+                  "<description>Surveillance device detections with GPS</description>\n");
+            // Detection pin style
+            w.raw("<Style id=\"det\"><IconStyle><color>ff4489ec</color>"
+                  "<scale>1.0</scale></IconStyle></Style>\n"
+                  "<Style id=\"raven\"><IconStyle><color>ff4444ef</color>"
+                  "<scale>1.2</scale></IconStyle></Style>\n");
+            _row = 0;
+            return true;
+        }
+        if (_row >= fyDetCount) { w.raw("</Document>\n</kml>"); return false; }
+        const FYDetection& d = fyDet[_row++];
+        if (!d.hasGPS) return true;  // Skip detections without GPS
+        w.raw("<Placemark>\n<name>").xml(d.mac).raw("</name>\n");
+        w.raw("<styleUrl>#").raw(d.isRaven ? "raven" : "det").raw("</styleUrl>\n");
+        w.raw("<description><![CDATA[");
+        if (d.name[0]) w.raw("<b>Name:</b> ").xml(d.name).raw("<br/>");
+        w.raw("<b>Method:</b> ").xml(d.method)
+         .raw("<br/><b>RSSI:</b> ").i32(d.rssi)
+         .raw(" dBm<br/><b>Count:</b> ").i32(d.count).raw("<br/>");
+        if (d.isRaven) w.raw("<b>Raven FW:</b> ").xml(d.ravenFW).raw("<br/>");
+        w.raw("<b>Dwell:</b> ").fixed(fyDwellMs(d) / 1000.0, 0).raw(" s over ").u32(d.visits).raw(" visit(s)<br/>");
+        w.raw("<b>Accuracy:</b> ").fixed(d.gpsAcc, 1).raw(" m");
+        w.raw("]]></description>\n<Point><coordinates>")
+         .fixed(d.gpsLon, 8).ch(',').fixed(d.gpsLat, 8)
+         .raw(",0</coordinates></Point>\n</Placemark>\n");
+        return true;
+    }
+private:
+    int _row;
+};
+
+// FYDB (see fy_binexport.h). The header carries the string table and record
+// count, so both are fixed on the first refill: strings are copied into a
+// per-request arena (names change in place on re-sighting) and rows added
+// later are left out. A name that changes mid-download exports as none; a
+// clear mid-download truncates the file, which api/fybin.py reports.
+// The encoder's string index (~2 KB, more in the bench build) is allocated
+// with the arena, from PSRAM when present, and counted the same way.
+class FYBinGen : public FYRespGen {
+public:
+    typedef FYBinEncoder<MAX_DETECTIONS + 16> Encoder;
+
+    FYBinGen() : _enc(NULL), _stage(0), _str(0), _row(0), _records(0), _arena(NULL), _arenaLen(0) {}
+    ~FYBinGen() {
+        if (_arena) {
+            free(_arena);
+            fyRespAux(-(int32_t)_arenaLen);
+        }
+        if (_enc) {
+            _enc->~Encoder();
+            free(_enc);
+            fyRespAux(-(int32_t)sizeof(Encoder));
+        }
+    }
+protected:
+    bool produce(FYBufSink& s) {
+        switch (_stage) {
+        case 0: {
+            void* mem = psramFound() ? ps_malloc(sizeof(Encoder)) : malloc(sizeof(Encoder));
+            if (!mem) return false;   // Empty body - api/fybin.py reports it truncated
+            _enc = new (mem) Encoder();
+            fyRespAux((int32_t)sizeof(Encoder));
+            intern();
+            _enc->writePreamble(s, millis());
+            _stage = 1;
+            return true;
+        }
+        case 1:
+            if (_str < _enc->count()) _enc->writeString(s, _str++);
+            else { _enc->writeRecordCount(s, _records); _stage = 2; }
+            return true;
+        default:
+            if (_row >= _records || _row >= fyDetCount) return false;
+            if (!_enc->writeRecord(s, fyDet[_row])) {
+                // Short file: api/fybin.py reports it truncated
+                printf("[FLOCK-YOU] FYDB export: row %d method \"%s\" not in string table, stopping\n",
+                       _row, fyDet[_row].method);
+                return false;
+            }
+            _row++;
+            return true;
+        }
+    }
+private:
+    void intern() {
+        _enc->reset();
+        size_t need = 0;
+        for (int i = 0; i < fyDetCount; i++) {
+            need += strlen(fyDet[i].method) + strlen(fyDet[i].name) + strlen(fyDet[i].ravenFW) + 3;
+        }
+        _arena = need ? (char*)(psramFound() ? ps_malloc(need) : malloc(need)) : NULL;
+        if (!_arena) return;  // Still a valid (empty) file
+        _arenaLen = need;
+        fyRespAux((int32_t)need);
+        size_t used = 0;
+        // Methods first: they must all make it into the table (fy_binexport.h)
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < fyDetCount; i++) {
+                const char* strs[3] = {fyDet[i].method, fyDet[i].name, fyDet[i].ravenFW};
+                for (int k = pass ? 1 : 0; k < (pass ? 3 : 1); k++) {
+                    if (!strs[k][0]) continue;
+                    size_t before = _enc->count();
+                    char* copy = _arena + used;
+                    strcpy(copy, strs[k]);
+                    _enc->intern(copy);
+                    if (_enc->count() > before) used += strlen(copy) + 1;
+                }
+            }
+        }
+        _records = fyDetCount;
+    }
 
-    if (data.length() == 0) {
-        printf("[FLOCK-YOU] Session file empty, skipping promotion\n");
-        SPIFFS.remove(FY_SESSION_FILE);
-        return;
-    }
+    // Names are the only per-device strings; methods and FW versions add a few
+    Encoder* _enc;
+    int _stage;
+    size_t _str;
+    int _row;
+    int _records;
+    char* _arena;
+    size_t _arenaLen;
+};
 
-    // Write to prev_session (overwrite any existing)
-    File dst = SPIFFS.open(FY_PREV_FILE, "w");
-    if (!dst) {
-        printf("[FLOCK-YOU] Failed to create prev_session file\n");
+// Claims a chunk before building the generator, so a refused request costs
+// nothing beyond the 503
+template <typename G>
+static void fyRespSend(AsyncWebServerRequest* r, const char* type, const char* filename = NULL) {
+    int chunk = fyRespPool.acquire();
+    G* gen = chunk < 0 ? NULL : new (std::nothrow) G();
+    if (!gen) {
+        fyRespPool.release(chunk);
+        AsyncWebServerResponse* resp = r->beginResponse(503, "application/json", "{\"error\":\"busy\"}");
+        resp->addHeader("Retry-After", FY_RESP_RETRY_AFTER);
+        r->send(resp);
         return;
     }
-    dst.print(data);
-    dst.close();
-
-    // Delete the old session file so it doesn't get re-promoted next boot
-    SPIFFS.remove(FY_SESSION_FILE);
-    printf("[FLOCK-YOU] Prior session promoted: %d bytes\n", data.length());
-}
-
-// ============================================================================
-// KML EXPORT
-// ============================================================================
-
-static void writeDetectionsKML(AsyncResponseStream *resp) {
-    resp->print("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-                "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n"
-                "<name>Flock-You Detections</name>\n"
-                "<description>Surveillance device detections with GPS</description>\n");
-
-    // Detection pin style
-    resp->print("<Style id=\"det\"><IconStyle><color>ff4489ec</color>"
-                "<scale>1.0</scale></IconStyle></Style>\n"
-                "<Style id=\"raven\"><IconStyle><color>ff4444ef</color>"
-                "<scale>1.2</scale></IconStyle></Style>\n");
-
-    if (fyMutex && xSemaphoreTake(fyMutex, pdMS_TO_TICKS(300)) == pdTRUE) {
-        for (int i = 0; i < fyDetCount; i++) {
-            FYDetection& d = fyDet[i];
-            if (!d.hasGPS) continue;  // Skip detections without GPS
-            resp->print("<Placemark>\n");
-            resp->printf("<name>%s</name>\n", d.mac);
-            resp->printf("<styleUrl>#%s</styleUrl>\n", d.isRaven ? "raven" : "det");
-            resp->print("<description><![CDATA[");
-            if (d.name[0]) resp->printf("<b>Name:</b> %s<br/>", d.name);
-            resp->printf("<b>Method:</b> %s<br/>"
-                         "<b>RSSI:</b> %d dBm<br/>"
-                         "<b>Count:</b> %d<br/>",
-                         d.method, d.rssi, d.count);
-            if (d.isRaven) resp->printf("<b>Raven FW:</b> %s<br/>", d.ravenFW);
-            resp->printf("<b>Accuracy:</b> %.1f m", d.gpsAcc);
-            resp->print("]]></description>\n");
-            resp->printf("<Point><coordinates>%.8f,%.8f,0</coordinates></Point>\n",
-                         d.gpsLon, d.gpsLat);
-            resp->print("</Placemark>\n");
-        }
-        xSemaphoreGive(fyMutex);
-    }
-    resp->print("</Document>\n</kml>");
+    gen->attach(chunk, sizeof(G));
+    std::shared_ptr<FYRespGen> g(gen);
+    AsyncWebServerResponse* resp = r->beginChunkedResponse(type,
+        [g](uint8_t* buf, size_t maxLen, size_t index) -> size_t { return g->fill(buf, maxLen); });
+    if (filename) {
+        char cd[96];
+        snprintf(cd, sizeof(cd), "attachment; filename=\"%s\"", filename);
+        resp->addHeader("Content-Disposition", cd);
+    }
+    r->send(resp);
 }
 
 // ============================================================================
@@ -662,20 +2507,25 @@ h4{color:#ec4899;font-size:14px;margin-bottom:8px}
 <button class="a" onclick="tab(0,this)">LIVE</button>
 <button onclick="tab(1,this)">PREV</button>
 <button onclick="tab(2,this)">DB</button>
+<button onclick="tab(4,this)">NEAR</button>
 <button onclick="tab(3,this)">TOOLS</button>
 </div>
 <div class="cn">
 <div class="pn a" id="p0">
+<div style="font-size:10px;color:#8b5cf6;margin-bottom:2px">ACTIVITY / MIN (LAST HOUR) &bull; <span style="color:#ec4899">NEW</span></div>
+<canvas id="hG" height="36" style="width:100%;display:block;margin-bottom:8px"></canvas>
 <div id="dL"><div class="empty">Scanning for surveillance devices...<br>BLE active on all channels</div></div>
 </div>
 <div class="pn" id="p1"><div id="hL"><div class="empty">Loading prior session...</div></div></div>
 <div class="pn" id="p2"><div id="pC">Loading patterns...</div></div>
+<div class="pn" id="p4"><div id="nL"><div class="empty">Tap GPS to locate yourself</div></div></div>
 <div class="pn" id="p3">
 <h4>EXPORT DETECTIONS</h4>
 <p style="font-size:10px;color:#8b5cf6;margin-bottom:8px">Download current session to import into Flask dashboard</p>
 <button class="btn" onclick="location.href='/api/export/json'">DOWNLOAD JSON</button>
 <button class="btn" onclick="location.href='/api/export/csv'">DOWNLOAD CSV</button>
 <button class="btn" onclick="location.href='/api/export/kml'" style="background:#22c55e">DOWNLOAD KML (GPS MAP)</button>
+<button class="btn" onclick="location.href='/api/export/bin'" style="background:#6366f1">DOWNLOAD BINARY (FYDB)</button>
 <hr class="sep">
 <h4>PRIOR SESSION</h4>
 <button class="btn" onclick="location.href='/api/history/json'" style="background:#6366f1">DOWNLOAD PREV JSON</button>
@@ -686,15 +2536,29 @@ h4{color:#ec4899;font-size:14px;margin-bottom:8px}
 </div>
 <script>
 let D=[],H=[];
-function tab(i,el){document.querySelectorAll('.tb button').forEach(b=>b.classList.remove('a'));document.querySelectorAll('.pn').forEach(p=>p.classList.remove('a'));el.classList.add('a');document.getElementById('p'+i).classList.add('a');if(i===1&&!window._hL)loadHistory();if(i===2&&!window._pL)loadPat();}
+function tab(i,el){document.querySelectorAll('.tb button').forEach(b=>b.classList.remove('a'));document.querySelectorAll('.pn').forEach(p=>p.classList.remove('a'));el.classList.add('a');document.getElementById('p'+i).classList.add('a');if(i===1&&!window._hL)loadHistory();if(i===2&&!window._pL)loadPat();if(i===4)loadNear();}
 function refresh(){fetch('/api/detections').then(r=>r.json()).then(d=>{D=d;render();stats();}).catch(()=>{});}
 function render(){const el=document.getElementById('dL');if(!D.length){el.innerHTML='<div class="empty">Scanning for surveillance devices...<br>BLE active on all channels</div>';return;}
-D.sort((a,b)=>b.last-a.last);el.innerHTML=D.map(card).join('');}
+D.sort((a,b)=>b.last-a.last);el.innerHTML=D.map(d=>card(d)).join('');}
 function stats(){document.getElementById('sT').textContent=D.length;document.getElementById('sR').textContent=D.filter(d=>d.raven).length;
 fetch('/api/stats').then(r=>r.json()).then(s=>{let g=document.getElementById('sG');if(s.gps_valid){g.textContent=s.gps_tagged+'/'+s.total;g.style.color='#22c55e';}else{g.textContent='OFF';g.style.color='#ef4444';}}).catch(()=>{});}
-function card(d){return '<div class="det"><div class="mac">'+d.mac+(d.name?'<span class="nm">'+d.name+'</span>':'')+'</div><div class="inf"><span>RSSI: '+d.rssi+'</span><span>'+d.method+'</span><span style="color:#ec4899;font-weight:bold">&times;'+d.count+'</span>'+(d.raven?'<span class="rv">RAVEN '+d.fw+'</span>':'')+(d.gps?'<span style="color:#22c55e">&#9673; '+d.gps.lat.toFixed(5)+','+d.gps.lon.toFixed(5)+'</span>':'<span style="color:#666">no gps</span>')+'</div></div>';}
+function card(d,prior){return '<div class="det"><div class="mac">'+esc(d.mac)+(d.name?'<span class="nm">'+esc(d.name)+'</span>':'')+'</div><div class="inf"><span>RSSI: '+d.rssi+'</span><span>'+esc(d.method)+'</span><span style="color:#ec4899;font-weight:bold">&times;'+d.count+'</span>'+(d.raven?'<span class="rv">RAVEN '+esc(d.fw)+'</span>':'')+(d.known?'<span style="color:#facc15">KNOWN &times;'+d.known+'</span>':'<span style="color:#8b5cf6">NEW</span>')+(!prior&&(d.pres==='entered'||d.pres==='present')?'<span style="color:#22d3ee">IN RANGE '+dur(d.dwell)+'</span>':(d.dwell?'<span style="color:#666">dwell '+dur(d.dwell)+'</span>':''))+(d.gps?'<span style="color:#22c55e">&#9673; '+d.gps.lat.toFixed(5)+','+d.gps.lon.toFixed(5)+'</span>':'<span style="color:#666">no gps</span>')+'</div></div>';}
+function hist(){fetch('/api/histogram').then(r=>r.json()).then(h=>{let c=document.getElementById('hG'),x=c.getContext('2d'),w=c.width=c.clientWidth,ht=c.height,mx=Math.max(1,...h.seen),bw=w/h.seen.length;
+x.clearRect(0,0,w,ht);h.seen.forEach((v,i)=>{let y=v/mx*ht;x.fillStyle='#8b5cf6';x.fillRect(i*bw,ht-y,bw-1,y);y=h.new[i]/mx*ht;x.fillStyle='#ec4899';x.fillRect(i*bw,ht-y,bw-1,y);});}).catch(()=>{});}
+function dur(ms){let t=Math.round(ms/1000);return t<60?t+'s':Math.floor(t/60)+'m'+(t%60)+'s';}
+function esc(s){return String(s).replace(/[&<>"]/g,c=>'&#'+c.charCodeAt(0)+';');}
+// Known cameras (offline datasets) + previously seen devices within 2 km of the phone
+let _pos=null;
+function loadNear(){let el=document.getElementById('nL');if(!_pos){el.innerHTML='<div class="empty">Tap GPS to locate yourself</div>';return;}
+let la=_pos[0],lo=_pos[1],dl=0.018,dn=dl/Math.cos(la*Math.PI/180);
+const dist=(a,b)=>Math.round(6371000*Math.hypot((b-lo)*Math.PI/180*Math.cos(la*Math.PI/180),(a-la)*Math.PI/180));
+Promise.all([fetch('/api/cameras?s='+(la-dl)+'&w='+(lo-dn)+'&n='+(la+dl)+'&e='+(lo+dn)).then(r=>r.ok?r.json():{points:[]}),
+fetch('/api/nearby?lat='+la+'&lon='+lo+'&r=2000').then(r=>r.json())]).then(([c,k])=>{
+let rows=c.points.map(p=>({d:dist(p.lat,p.lon),t:p.src,l:p.label})).concat(k.devices.map(v=>({d:v.dist,t:'seen &times;'+v.sessions,l:v.mac}))).filter(r=>r.d<=2000).sort((a,b)=>a.d-b.d);
+el.innerHTML='<div style="font-size:11px;color:#8b5cf6;margin-bottom:8px">'+rows.length+' known within 2 km'+(c.query_us!==undefined?' &bull; index query '+c.query_us+' &micro;s':'')+'</div>'+
+(rows.length?rows.map(r=>'<div class="det"><div class="mac">'+r.d+' m<span class="nm">'+r.t+'</span></div><div class="inf"><span>'+esc(r.l)+'</span></div></div>').join(''):'<div class="empty">Nothing known nearby</div>');}).catch(()=>{});}
 function loadHistory(){fetch('/api/history').then(r=>r.json()).then(d=>{H=d;let el=document.getElementById('hL');if(!H.length){el.innerHTML='<div class="empty">No prior session data</div>';return;}
-H.sort((a,b)=>b.last-a.last);el.innerHTML='<div style="font-size:11px;color:#8b5cf6;margin-bottom:8px">'+H.length+' detections from prior session</div>'+H.map(card).join('');window._hL=1;}).catch(()=>{document.getElementById('hL').innerHTML='<div class="empty">No prior session data</div>';});}
+H.sort((a,b)=>b.last-a.last);el.innerHTML='<div style="font-size:11px;color:#8b5cf6;margin-bottom:8px">'+H.length+' detections from prior session</div>'+H.map(d=>card(d,1)).join('');window._hL=1;}).catch(()=>{document.getElementById('hL').innerHTML='<div class="empty">No prior session data</div>';});}
 function loadPat(){fetch('/api/patterns').then(r=>r.json()).then(p=>{let h='';
 h+='<div class="pg"><h3>MAC Prefixes ('+p.macs.length+')</h3><div class="it">'+p.macs.map(m=>'<span>'+m+'</span>').join('')+'</div></div>';
 h+='<div class="pg"><h3>BLE Device Names ('+p.names.length+')</h3><div class="it">'+p.names.map(n=>'<span>'+n+'</span>').join('')+'</div></div>';
@@ -706,9 +2570,19 @@ document.getElementById('pC').innerHTML=h;window._pL=1;}).catch(()=>{});}
 // HTTP works on: Android Chrome (local IPs), some Android browsers.
 // Won't work on: iOS Safari (needs HTTPS always).
 // We only request on user tap (gesture) for best permission prompt chance.
-let _gW=null,_gOk=false,_gTried=false;
-function sendGPS(p){_gOk=true;let g=document.getElementById('sG');g.textContent='OK';g.style.color='#22c55e';
-fetch('/api/gps?lat='+p.coords.latitude+'&lon='+p.coords.longitude+'&acc='+(p.coords.accuracy||0)).catch(()=>{});}
+// Fixes are buffered and POSTed in batches of up to 50 (oldest first, age
+// relative to the flush; 50 worst-case lines stay under FY_GPS_BATCH_MAX).
+// A failed flush (AP drop) keeps them for the next one; a batch the unit
+// rejects (4xx) is dropped so it cannot jam the queue.
+let _gW=null,_gOk=false,_gTried=false,_gq=[],_gBusy=false,_gLast=0;
+function flushGPS(){if(_gBusy||!_gq.length)return;_gBusy=true;let n=Math.min(_gq.length,50),now=Date.now();
+let b=_gq.slice(0,n).map(f=>Math.max(0,now-f.t)+','+f.la.toFixed(7)+','+f.lo.toFixed(7)+','+f.a.toFixed(1)).join('\n');
+fetch('/api/gps/batch',{method:'POST',body:b,headers:{'Content-Type':'text/plain'},keepalive:true})
+.then(r=>{if(r.ok||(r.status>=400&&r.status<500))_gq.splice(0,n);if(r.ok){_gLast=Date.now();if(_gq.length)setTimeout(flushGPS,0);}}).catch(()=>{}).finally(()=>{_gBusy=false;});}
+function sendGPS(p){_gOk=true;_pos=[p.coords.latitude,p.coords.longitude];let g=document.getElementById('sG');g.textContent='OK';g.style.color='#22c55e';
+_gq.push({t:p.timestamp||Date.now(),la:p.coords.latitude,lo:p.coords.longitude,a:p.coords.accuracy||0});
+if(_gq.length>100)_gq.splice(0,_gq.length-100);
+if(Date.now()-_gLast>=3000)flushGPS();}
 function gpsErr(e){_gOk=false;let g=document.getElementById('sG');
 var msg='ERR';if(e.code===1){msg='DENIED';g.style.color='#ef4444';alert('GPS permission denied. On iPhone, GPS requires HTTPS which this device cannot provide. On Android Chrome, tap the lock/info icon in the address bar and allow Location.');}
 else if(e.code===2){msg='N/A';g.style.color='#ef4444';}
@@ -720,12 +2594,86 @@ let g=document.getElementById('sG');g.textContent='...';g.style.color='#facc15';
 _gW=navigator.geolocation.watchPosition(sendGPS,gpsErr,{enableHighAccuracy:true,maximumAge:5000,timeout:15000});return true;}
 function reqGPS(){if(!navigator.geolocation){alert('GPS not available in this browser.');return;}
 if(_gOk){return;}
-if(!window.isSecureContext){alert('GPS requires a secure context (HTTPS). This HTTP page may not get GPS permission.\\n\\nAndroid Chrome: try chrome://flags and enable "Insecure origins treated as secure", add http://192.168.4.1\\n\\niPhone: GPS will not work over HTTP.');}
+if(!window.isSecureContext){alert('GPS requires a secure context (HTTPS). This HTTP page may not get GPS permission.\\n\\nAndroid Chrome: try chrome://flags and enable "Insecure origins treated as secure", add '+location.origin+'\\n\\niPhone: GPS will not work over HTTP.');}
 startGPS();_gTried=true;}
-refresh();setInterval(refresh,2500);
+refresh();setInterval(refresh,2500);hist();setInterval(hist,15000);setInterval(flushGPS,3000);
+setInterval(()=>{if(document.getElementById('p4').classList.contains('a'))loadNear();},10000);
 </script></body></html>
 )rawliteral";
 
+#ifdef FY_BENCH
+// ============================================================================
+// BENCHMARK HOOKS (-DFY_BENCH, see env:xiao_esp32s3_bench)
+// ============================================================================
+// Synthetic BLE producer for tools/fybench.py. Inserts locally administered
+// 02:fb:xx MACs through the same fyAddDetection() path as real adverts, at a
+// fixed rate from a task on the radio core, so insert starvation behind the
+// web layer shows up in /api/perf exactly as it would for a real drive.
+// Bench rows are saved to the session file like any other - don't flash this
+// build for actual use.
+
+#define FY_BENCH_STACK      3072
+#define FY_BENCH_MAX_RATE   1000    // Inserts per second
+
+static std::atomic<uint32_t> fyBenchRate(0);
+static std::atomic<uint32_t> fyBenchInserted(0);
+static std::atomic<uint32_t> fyBenchRejected(0);  // Table full or fyMutex timeout
+static TaskHandle_t fyBenchTask = NULL;
+
+static bool fyBenchInsert(uint32_t i) {
+    char mac[18], name[24];
+    snprintf(mac, sizeof(mac), "02:fb:%02x:%02x:%02x:%02x",
+             (unsigned)(i >> 24) & 0xFF, (unsigned)(i >> 16) & 0xFF,
+             (unsigned)(i >> 8) & 0xFF, (unsigned)i & 0xFF);
+    snprintf(name, sizeof(name), "Bench %u", (unsigned)i);
+    bool ok = fyAddDetection(mac, name, -40 - (int)(i % 50), fy_method_names[FY_M_BENCH]) >= 0;
+    (ok ? fyBenchInserted : fyBenchRejected).fetch_add(1, std::memory_order_relaxed);
+    return ok;
+}
+
+// Cycles through MAX_DETECTIONS synthetic devices: new rows until the
+// table is full, re-sightings after that
+static void fyBenchLoop(void*) {
+    uint32_t n = 0;
+    for (;;) {
+        uint32_t rate = fyBenchRate.load(std::memory_order_relaxed);
+        if (!rate) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        fyBenchInsert(n++ % MAX_DETECTIONS);
+        TickType_t gap = pdMS_TO_TICKS(1000 / rate);
+        vTaskDelay(gap ? gap : 1);
+    }
+}
+
+static void fyBenchSetRate(uint32_t rate) {
+    fyBenchRate.store(rate > FY_BENCH_MAX_RATE ? FY_BENCH_MAX_RATE : rate);
+    if (!fyBenchTask) {
+        xTaskCreatePinnedToCore(fyBenchLoop, "fy_bench", FY_BENCH_STACK, NULL,
+                                FY_RADIO_PRIO, &fyBenchTask, FY_RADIO_CORE);
+    } else {
+        xTaskNotifyGive(fyBenchTask);
+    }
+}
+
+static void fyBenchResetStats() {
+    for (int i = 0; i < FY_LOCK_SITES; i++) {
+        FYLockStats& st = fyLockStats[i];
+        st.takes = 0; st.timeouts = 0;
+        st.waitSumUs = 0; st.waitMaxUs = 0;
+        st.holdSumUs = 0; st.holdMaxUs = 0;
+    }
+    fyRespStats.served = 0; fyRespStats.bytes = 0;
+    fyRespStats.latSumMs = 0; fyRespStats.latMaxMs = 0;
+    fyRespStats.lockMisses = 0;
+    fyRespStats.auxPeak = fyRespStats.auxBytes.load();
+    fyRespPool.resetStats();
+    fyBenchInserted = 0;
+    fyBenchRejected = 0;
+}
+#endif
+
 // ============================================================================
 // WEB SERVER SETUP
 // ============================================================================
@@ -733,221 +2681,928 @@ refresh();setInterval(refresh,2500);
 static void fySetupServer() {
     // Dashboard
     fyServer.on("/", HTTP_GET, [](AsyncWebServerRequest *r) {
+        fyTxNote(sizeof(FY_HTML) - 1);
         r->send(200, "text/html", FY_HTML);
     });
 
     // API: Detection list
     fyServer.on("/api/detections", HTTP_GET, [](AsyncWebServerRequest *r) {
+        fyRespSend<FYJsonGen>(r, "application/json");
+    });
+
+    // API: Stats (includes GPS status) - O(1), reads running aggregates
+    fyServer.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *r) {
+        char buf[448];
+        FYGPSFix fix;
+        bool everFix = fyFixes.latest(fix);
+        int n = snprintf(buf, sizeof(buf),
+            "{\"total\":%d,\"raven\":%d,\"ble\":\"active\",\"wifi\":\"%s\","
+            "\"gps_valid\":%s,\"gps_age\":%lu,\"gps_tagged\":%d,"
+            "\"sightings\":%u,\"last_min\":%u,\"known_db\":%u,\"methods\":{",
+            fyStats.total.load(), fyStats.raven.load(),
+            fyWifiActive ? "active" : "off",
+            (everFix && millis() - fix.tMs < GPS_STALE_MS) ? "true" : "false",
+            everFix ? (unsigned long)(millis() - fix.tMs) : 0UL,
+            fyStats.withGPS.load(),
+            (unsigned)fyStats.sightings.load(),
+            (unsigned)fyHistGet(fyStats.histSeen, fyMinuteNow()),
+            (unsigned)fyKnown.count());
+        for (int i = 0; i < FY_M_COUNT && n < (int)sizeof(buf); i++) {
+            n += snprintf(buf + n, sizeof(buf) - n, "%s\"%s\":%d",
+                          i ? "," : "", fy_method_names[i], fyStats.byMethod[i].load());
+        }
+        if (n < (int)sizeof(buf)) snprintf(buf + n, sizeof(buf) - n, "}}");
+        fySend(r, 200, "application/json", buf);
+    });
+
+    // API: Per-minute activity for the last hour (oldest first, last = current minute)
+    fyServer.on("/api/histogram", HTTP_GET, [](AsyncWebServerRequest *r) {
         AsyncResponseStream *resp = r->beginResponseStream("application/json");
-        writeDetectionsJSON(resp);
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            uint32_t now = fyMinuteNow();
+            uint32_t first = now >= FY_HIST_MINUTES - 1 ? now - (FY_HIST_MINUTES - 1) : 0;
+            w.raw("{\"bucket_ms\":60000,\"uptime\":").u32(millis()).raw(",\"seen\":[");
+            for (uint32_t m = first; m <= now; m++) {
+                if (m != first) w.ch(',');
+                w.u32(fyHistGet(fyStats.histSeen, m));
+            }
+            w.raw("],\"new\":[");
+            for (uint32_t m = first; m <= now; m++) {
+                if (m != first) w.ch(',');
+                w.u32(fyHistGet(fyStats.histNew, m));
+            }
+            w.raw("]}");
+        }
         r->send(resp);
     });
 
-    // API: Stats (includes GPS status)
-    fyServer.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *r) {
-        int raven = 0, withGPS = 0;
-        if (fyMutex && xSemaphoreTake(fyMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            for (int i = 0; i < fyDetCount; i++) {
-                if (fyDet[i].isRaven) raven++;
-                if (fyDet[i].hasGPS) withGPS++;
+    // API: GPS ingestion cost - legacy GET vs batched POST
+    fyServer.on("/api/gps/stats", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            const FYGPSIngestStats* src[2] = {&fyGPSLegacy, &fyGPSBatch};
+            const char* names[2] = {"legacy", "batch"};
+            w.ch('{');
+            for (int i = 0; i < 2; i++) {
+                uint32_t req = src[i]->requests.load(), fixes = src[i]->fixes.load();
+                uint32_t us = src[i]->us.load();
+                w.ch('"').raw(names[i]).raw("\":{\"requests\":").u32(req)
+                 .raw(",\"fixes\":").u32(fixes)
+                 .raw(",\"rejected\":").u32(src[i]->rejected.load())
+                 .raw(",\"fixes_per_request\":").fixed(req ? (double)fixes / req : 0, 2)
+                 .raw(",\"us_per_request\":").fixed(req ? (double)us / req : 0, 1)
+                 .raw(",\"us_per_fix\":").fixed(fixes ? (double)us / fixes : 0, 1)
+                 .raw(",\"backfilled\":").u32(src[i]->backfilled.load())
+                 .raw("},");
             }
-            xSemaphoreGive(fyMutex);
+            FYGPSFix fix;
+            bool have = fyFixes.latest(fix);
+            w.raw("\"queue\":{\"capacity\":").u32(fyFixes.capacity())
+             .raw(",\"published\":").u32(fyFixes.published())
+             .raw(",\"latest_age_ms\":");
+            if (have) w.u32(millis() - fix.tMs);
+            else w.raw("null");
+            w.raw("}}");
         }
-        char buf[256];
-        snprintf(buf, sizeof(buf),
-            "{\"total\":%d,\"raven\":%d,\"ble\":\"active\","
-            "\"gps_valid\":%s,\"gps_age\":%lu,\"gps_tagged\":%d}",
-            fyDetCount, raven,
-            fyGPSIsFresh() ? "true" : "false",
-            fyGPSValid ? (millis() - fyGPSLastUpdate) : 0UL,
-            withGPS);
-        r->send(200, "application/json", buf);
+        r->send(resp);
+    });
+
+    // API: Batched GPS fixes (POST body, one "age_ms,lat,lon,acc" per line)
+    fyServer.on("/api/gps/batch", HTTP_POST, [](AsyncWebServerRequest *r) {
+        int64_t t0 = esp_timer_get_time();
+        const char* body = (const char*)r->_tempObject;
+        if (!body) {
+            fySend(r, 400, "application/json", "{\"error\":\"empty or oversized batch\"}");
+            return;
+        }
+        uint32_t accepted = 0, stale = 0;
+        size_t bad = fyGpsParseBatch(body, strlen(body), [&](uint32_t age, FYGPSFix& f) {
+            if (fyGPSPublish(f, age)) {
+                if (++accepted % (FY_GPS_FIXES / 2) == 0) fyGPSBackfill();
+            } else {
+                stale++;
+            }
+        });
+        if (accepted % (FY_GPS_FIXES / 2)) fyGPSBackfill();
+        fyGPSBatch.requests.fetch_add(1, std::memory_order_relaxed);
+        fyGPSBatch.fixes.fetch_add(accepted, std::memory_order_relaxed);
+        fyGPSBatch.rejected.fetch_add(bad + stale, std::memory_order_relaxed);
+        fyGPSBatch.us.fetch_add((uint32_t)(esp_timer_get_time() - t0), std::memory_order_relaxed);
+        char buf[64];
+        snprintf(buf, sizeof(buf), "{\"accepted\":%u,\"rejected\":%u}",
+                 (unsigned)accepted, (unsigned)(bad + stale));
+        fySend(r, 200, "application/json", buf);
+    }, NULL, [](AsyncWebServerRequest *r, uint8_t *data, size_t len, size_t index, size_t total) {
+        // Collect the body; freed with the request (_tempObject)
+        if (total > FY_GPS_BATCH_MAX) return;
+        if (index == 0 && !r->_tempObject) r->_tempObject = calloc(1, total + 1);
+        if (r->_tempObject && index + len <= total) memcpy((uint8_t*)r->_tempObject + index, data, len);
     });
 
-    // API: Receive GPS from phone browser
+    // API: Single fix (legacy query-string form, kept for older clients)
     fyServer.on("/api/gps", HTTP_GET, [](AsyncWebServerRequest *r) {
         if (r->hasParam("lat") && r->hasParam("lon")) {
-            fyGPSLat = r->getParam("lat")->value().toDouble();
-            fyGPSLon = r->getParam("lon")->value().toDouble();
-            fyGPSAcc = r->hasParam("acc") ? r->getParam("acc")->value().toFloat() : 0;
-            fyGPSValid = true;
-            fyGPSLastUpdate = millis();
-            r->send(200, "application/json", "{\"status\":\"ok\"}");
+            int64_t t0 = esp_timer_get_time();
+            FYGPSFix f;
+            f.latE7 = (int32_t)(r->getParam("lat")->value().toDouble() * 1e7);
+            f.lonE7 = (int32_t)(r->getParam("lon")->value().toDouble() * 1e7);
+            f.acc = r->hasParam("acc") ? r->getParam("acc")->value().toFloat() : 0;
+            bool ok = fyGPSPublish(f, 0);
+            fyGPSLegacy.requests.fetch_add(1, std::memory_order_relaxed);
+            (ok ? fyGPSLegacy.fixes : fyGPSLegacy.rejected).fetch_add(1, std::memory_order_relaxed);
+            fyGPSLegacy.us.fetch_add((uint32_t)(esp_timer_get_time() - t0), std::memory_order_relaxed);
+            fySend(r, 200, "application/json", "{\"status\":\"ok\"}");
         } else {
-            r->send(400, "application/json", "{\"error\":\"lat,lon required\"}");
+            fySend(r, 400, "application/json", "{\"error\":\"lat,lon required\"}");
         }
     });
 
-    // API: Pattern database
-    fyServer.on("/api/patterns", HTTP_GET, [](AsyncWebServerRequest *r) {
+    // API: Known devices near a point (?lat=&lon=&r=metres, default 500)
+    fyServer.on("/api/nearby", HTTP_GET, [](AsyncWebServerRequest *r) {
+        if (!r->hasParam("lat") || !r->hasParam("lon")) {
+            fySend(r, 400, "application/json", "{\"error\":\"lat,lon required\"}");
+            return;
+        }
+        double lat = r->getParam("lat")->value().toDouble();
+        double lon = r->getParam("lon")->value().toDouble();
+        double rad = r->hasParam("r") ? r->getParam("r")->value().toDouble() : 500;
+        if (rad < 10) rad = 10;
+        if (rad > 50000) rad = 50000;
+        if (!fyKnownMutex || xSemaphoreTake(fyKnownMutex, pdMS_TO_TICKS(200)) != pdTRUE) {
+            fySend(r, 503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
         AsyncResponseStream *resp = r->beginResponseStream("application/json");
-        resp->print("{\"macs\":[");
-        for (size_t i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-            if (i > 0) resp->print(",");
-            resp->printf("\"%s\"", mac_prefixes[i]);
-        }
-        resp->print("],\"names\":[");
-        for (size_t i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
-            if (i > 0) resp->print(",");
-            resp->printf("\"%s\"", device_name_patterns[i]);
-        }
-        resp->print("],\"mfr\":[");
-        for (size_t i = 0; i < sizeof(ble_manufacturer_ids)/sizeof(ble_manufacturer_ids[0]); i++) {
-            if (i > 0) resp->print(",");
-            resp->printf("%u", ble_manufacturer_ids[i]);
-        }
-        resp->print("],\"raven\":[");
-        for (size_t i = 0; i < sizeof(raven_service_uuids)/sizeof(raven_service_uuids[0]); i++) {
-            if (i > 0) resp->print(",");
-            resp->printf("\"%s\"", raven_service_uuids[i]);
-        }
-        resp->print("]}");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("{\"radius\":").fixed(rad, 0).raw(",\"session\":").u32(fyKnownSession)
+             .raw(",\"devices\":[");
+            int n = 0;
+            fyKnown.nearby(lat, lon, rad, [&](const FYKnownRec& k, double dist) {
+                char mac[18];
+                snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+                         k.mac[0], k.mac[1], k.mac[2], k.mac[3], k.mac[4], k.mac[5]);
+                if (n++) w.ch(',');
+                w.raw("{\"mac\":\"").raw(mac)
+                 .raw("\",\"lat\":").fixed(k.latE7 / 1e7, 7)
+                 .raw(",\"lon\":").fixed(k.lonE7 / 1e7, 7)
+                 .raw(",\"dist\":").fixed(dist, 0)
+                 .raw(",\"sessions\":").u32(k.sessions)
+                 .raw(",\"first_session\":").u32(k.firstSession)
+                 .raw(",\"last_session\":").u32(k.lastSession)
+                 .raw(",\"raven\":").boolean(k.flags & FY_KNOWN_RAVEN).ch('}');
+                return n < 100;
+            });
+            w.raw("],\"count\":").i32(n).ch('}');
+        }
+        xSemaphoreGive(fyKnownMutex);
         r->send(resp);
     });
 
-    // API: Export JSON (downloadable file)
-    fyServer.on("/api/export/json", HTTP_GET, [](AsyncWebServerRequest *r) {
+    // API: Camera index status and query latency (registered first: "/api/cameras"
+    // would otherwise also match "/api/cameras/info")
+    fyServer.on("/api/cameras/info", HTTP_GET, [](AsyncWebServerRequest *r) {
+        char buf[256];
+        uint32_t q = fyCamQueries;
+        snprintf(buf, sizeof(buf),
+            "{\"present\":%s,\"points\":%u,\"tiles\":%u,\"level\":%u,\"bytes\":%u,"
+            "\"queries\":%u,\"avg_us\":%u,\"max_us\":%u}",
+            fyCams.ready() ? "true" : "false",
+            fyCams.pointCount(), fyCams.tileCount(), fyCams.level(), fyCams.imageSize(),
+            q, q ? (unsigned)(fyCamTotalUs / q) : 0u, (unsigned)fyCamMaxUs.load());
+        fySend(r, 200, "application/json", buf);
+    });
+
+    // API: Known cameras from the offline datasets in a bounding box
+    // (?s=&w=&n=&e= degrees, optional limit). Reports its own query latency.
+    fyServer.on("/api/cameras", HTTP_GET, [](AsyncWebServerRequest *r) {
+        if (!r->hasParam("s") || !r->hasParam("w") || !r->hasParam("n") || !r->hasParam("e")) {
+            fySend(r, 400, "application/json", "{\"error\":\"s,w,n,e required\"}");
+            return;
+        }
+        if (!fyCams.ready()) {
+            fySend(r, 404, "application/json", "{\"error\":\"camera index not flashed\"}");
+            return;
+        }
+        double s = r->getParam("s")->value().toDouble();
+        double w = r->getParam("w")->value().toDouble();
+        double n = r->getParam("n")->value().toDouble();
+        double e = r->getParam("e")->value().toDouble();
+        int limit = r->hasParam("limit") ? r->getParam("limit")->value().toInt() : 200;
+        if (limit < 1 || limit > FY_CAM_QUERY_LIMIT) limit = FY_CAM_QUERY_LIMIT;
+
         AsyncResponseStream *resp = r->beginResponseStream("application/json");
-        resp->addHeader("Content-Disposition", "attachment; filename=\"flockyou_detections.json\"");
-        writeDetectionsJSON(resp);
+        int64_t t0 = esp_timer_get_time();
+        int count = 0;
+        bool truncated = false;
+        {
+            FYWriter<AsyncResponseStream> wr(*resp);
+            wr.raw("{\"points\":[");
+            fyCams.query(s, w, n, e, [&](const FYCamPoint& p) {
+                if (count >= limit) { truncated = true; return false; }
+                if (count++) wr.ch(',');
+                wr.raw("{\"lat\":").fixed(p.latE7 / 1e7, 7)
+                  .raw(",\"lon\":").fixed(p.lonE7 / 1e7, 7)
+                  .raw(",\"src\":\"")
+                  .raw(p.source < FY_CAM_SRC_COUNT ? fy_cam_source_names[p.source] : "?")
+                  .raw("\",\"label\":\"").json(fyCams.label(p)).raw("\"}");
+                return true;
+            });
+            uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+            fyCamQueries++;
+            fyCamTotalUs += us;
+            if (us > fyCamMaxUs) fyCamMaxUs = us;
+            wr.raw("],\"count\":").i32(count)
+              .raw(",\"truncated\":").boolean(truncated)
+              .raw(",\"query_us\":").u32(us).ch('}');
+        }
         r->send(resp);
     });
 
-    // API: Export CSV (downloadable file, includes GPS)
-    fyServer.on("/api/export/csv", HTTP_GET, [](AsyncWebServerRequest *r) {
-        AsyncResponseStream *resp = r->beginResponseStream("text/csv");
-        resp->addHeader("Content-Disposition", "attachment; filename=\"flockyou_detections.csv\"");
-        resp->println("mac,name,rssi,method,first_seen_ms,last_seen_ms,count,is_raven,raven_fw,latitude,longitude,gps_accuracy");
-        if (fyMutex && xSemaphoreTake(fyMutex, pdMS_TO_TICKS(200)) == pdTRUE) {
-            for (int i = 0; i < fyDetCount; i++) {
-                FYDetection& d = fyDet[i];
-                if (d.hasGPS) {
-                    resp->printf("\"%s\",\"%s\",%d,\"%s\",%lu,%lu,%d,%s,\"%s\",%.8f,%.8f,%.1f\n",
-                        d.mac, d.name, d.rssi, d.method,
-                        d.firstSeen, d.lastSeen, d.count,
-                        d.isRaven ? "true" : "false", d.ravenFW,
-                        d.gpsLat, d.gpsLon, d.gpsAcc);
-                } else {
-                    resp->printf("\"%s\",\"%s\",%d,\"%s\",%lu,%lu,%d,%s,\"%s\",,,\n",
-                        d.mac, d.name, d.rssi, d.method,
-                        d.firstSeen, d.lastSeen, d.count,
-                        d.isRaven ? "true" : "false", d.ravenFW);
+    // API: Verdict cache effectiveness (hit rate, CPU time saved)
+    fyServer.on("/api/cache", HTTP_GET, [](AsyncWebServerRequest *r) {
+        uint32_t look = fyVerdictStats.lookups, hits = fyVerdictStats.hits;
+        uint32_t miss = fyVerdictStats.missCount, missUs = fyVerdictStats.missUs;
+        uint32_t hitUs = fyVerdictStats.hitUs;
+        // Saved = what the hits would have cost at the average full-pipeline price
+        double avgMiss = miss ? (double)missUs / miss : 0;
+        double avgHit = hits ? (double)hitUs / hits : 0;
+        double savedMs = hits * (avgMiss - avgHit) / 1000.0;
+        char buf[320];
+        snprintf(buf, sizeof(buf),
+            "{\"capacity\":%u,\"ttl_s\":%u,\"lookups\":%u,\"hits\":%u,"
+            "\"hit_rate\":%.4f,\"invalidations\":%u,\"avg_miss_us\":%.1f,"
+            "\"avg_hit_us\":%.2f,\"cpu_saved_ms\":%.1f}",
+            (unsigned)fyVerdicts.capacity(), FY_VERDICT_TTL, look, hits,
+            look ? (double)hits / look : 0.0, (unsigned)fyVerdictStats.invalidations.load(),
+            avgMiss, avgHit, savedMs > 0 ? savedMs : 0.0);
+        fySend(r, 200, "application/json", buf);
+    });
+
+    // API: WiFi sniffer - channel schedule, frame rate and ring drops
+    fyServer.on("/api/wifi", HTTP_GET, [](AsyncWebServerRequest *r) {
+        char buf[384];
+        snprintf(buf, sizeof(buf),
+            "{\"active\":%s,\"channel\":%u,\"home_channel\":%u,\"stations\":%u,"
+            "\"hops\":%u,\"frames\":%u,\"fps\":%u,\"matched\":%u,\"matched_ps\":%u,"
+            "\"dropped\":%u,\"queued\":%u,\"ring\":%u,\"ouis\":%u,\"ssid_prefix\":\"%s\"}",
+            fyWifiActive ? "true" : "false",
+            (unsigned)fyWifiChannel.load(), (unsigned)fyWifiHome,
+            (unsigned)WiFi.softAPgetStationNum(),
+            (unsigned)fyWifiStats.hops.load(), (unsigned)fyWifiStats.frames.load(),
+            (unsigned)fyWifiStats.fps.load(), (unsigned)fyWifiStats.matched.load(),
+            (unsigned)fyWifiStats.matchedPs.load(), (unsigned)fyWifiStats.dropped.load(),
+            (unsigned)fyWifiRing.size(), (unsigned)fyWifiRing.capacity(),
+            (unsigned)fyWifiOUICount, FY_WIFI_SSID_PREFIX);
+        fySend(r, 200, "application/json", buf);
+    });
+
+    // API: Radio coexistence - preference in force, per-second BLE/WiFi load and
+    // what each preference has delivered. ?mode=auto|balance|ble|wifi pins it,
+    // ?hold_ms= and ?tx_bps= tune the policy.
+    fyServer.on("/api/coex", HTTP_GET, [](AsyncWebServerRequest *r) {
+        if (r->hasParam("mode")) {
+            String m = r->getParam("mode")->value();
+            for (uint8_t i = 0; i <= FY_COEX_AUTO; i++) {
+                if (m == fy_coex_mode_names[i]) fyCoexPin = i;
+            }
+        }
+        if (r->hasParam("hold_ms")) fyCoexHoldMs = (uint32_t)r->getParam("hold_ms")->value().toInt();
+        if (r->hasParam("tx_bps")) fyCoexTxBps = (uint32_t)r->getParam("tx_bps")->value().toInt();
+
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            uint8_t applied = fyCoexApplied.load();
+            w.raw("{\"active\":").boolean(fyCoexActive)
+             .raw(",\"mode\":\"").raw(applied < FY_COEX_MODES ? fy_coex_mode_names[applied] : "none")
+             .raw("\",\"pinned\":\"").raw(fy_coex_mode_names[fyCoexPin.load()])
+             .raw("\",\"hold_ms\":").u32(fyCoexHoldMs.load())
+             .raw(",\"tx_bps_threshold\":").u32(fyCoexTxBps.load())
+             .raw(",\"dwell_ms\":").u32(FY_COEX_DWELL_MS)
+             .raw(",\"switches\":").u32(fyCoexStats.switches.load())
+             .raw(",\"set_fails\":").u32(fyCoexStats.setFails.load())
+             .raw(",\"beacon_tu\":").u32(fyCoexStats.beaconTU)
+             .raw(",\"modem_sleep\":").boolean(fyCoexStats.psOk)
+             .raw(",\"stations\":").u32(WiFi.softAPgetStationNum())
+             .raw(",\"streams\":").u32(fyRespPool.inUse())
+             .raw(",\"adverts_ps\":").u32(fyCoexStats.advertsPs.load())
+             .raw(",\"tx_bps\":").u32(fyCoexStats.txBps.load())
+             .raw(",\"wifi_fps\":").u32(fyWifiStats.fps.load())
+             .raw(",\"adverts\":").u32(fyCoexStats.adverts.load())
+             .raw(",\"sightings\":").u32(fyCoexStats.sightings.load())
+             .raw(",\"modes\":{");
+            for (uint8_t i = 0; i < FY_COEX_MODES; i++) {
+                uint32_t ms = fyCoexStats.modeMs[i].load();
+                uint32_t adv = fyCoexStats.modeAdverts[i].load();
+                uint32_t tx = fyCoexStats.modeTx[i].load();
+                if (i) w.ch(',');
+                w.ch('"').raw(fy_coex_mode_names[i])
+                 .raw("\":{\"seconds\":").u32(ms / 1000)
+                 .raw(",\"adverts_ps\":").fixed(ms ? adv * 1000.0 / ms : 0.0, 1)
+                 .raw(",\"tx_bps\":").u32(ms ? (uint32_t)((uint64_t)tx * 1000 / ms) : 0)
+                 .ch('}');
+            }
+            w.raw("}}");
+        }
+        r->send(resp);
+    });
+
+    // API: Task layout - wake latency (scheduling jitter), CPU share, stack headroom
+    fyServer.on("/api/tasks", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("{\"uptime\":").u32(millis()).raw(",\"tasks\":[");
+            for (size_t i = 0; i < FY_TASK_COUNT; i++) {
+                const FYTaskStats& t = *fyTasks[i];
+                uint32_t wakes = t.wakeups.load();
+                if (i) w.ch(',');
+                w.raw("{\"name\":\"").json(t.name)
+                 .raw("\",\"core\":").u32(t.core)
+                 .raw(",\"prio\":").u32(t.prio)
+                 .raw(",\"wakeups\":").u32(wakes)
+                 .raw(",\"cpu_pct\":").fixed(t.cpuPermille.load() / 10.0, 1)
+                 .raw(",\"lat_avg_us\":").u32(wakes ? t.latSumUs.load() / wakes : 0)
+                 .raw(",\"lat_max_us\":").u32(t.latMaxUs.load())
+                 .raw(",\"stack_free\":").u32(t.handle ? uxTaskGetStackHighWaterMark(t.handle) : 0)
+                 .ch('}');
+            }
+            w.raw("],\"scan\":{\"count\":").u32(fyScanStats.scans.load())
+             .raw(",\"start_fails\":").u32(fyScanStats.startFails.load())
+             .raw(",\"gap_ms\":").u32(FY_SCAN_GAP_MS)
+             .raw(",\"gap_err_max_us\":").u32(fyScanStats.gapErrMaxUs.load())
+             .raw("}}");
+        }
+        r->send(resp);
+    });
+
+    // API: fyMutex wait/hold per holder and heap headroom (tools/fybench.py)
+    fyServer.on("/api/perf", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("{\"uptime\":").u32(millis())
+             .raw(",\"detections\":").i32(fyDetCount)
+             .raw(",\"capacity\":").u32(MAX_DETECTIONS)
+             .raw(",\"heap_free\":").u32(ESP.getFreeHeap())
+             .raw(",\"heap_min\":").u32(ESP.getMinFreeHeap())
+             .raw(",\"locks\":[");
+            for (int i = 0; i < FY_LOCK_SITES; i++) {
+                const FYLockStats& st = fyLockStats[i];
+                uint32_t takes = st.takes.load();
+                if (i) w.ch(',');
+                w.raw("{\"site\":\"").raw(fy_lock_site_names[i])
+                 .raw("\",\"takes\":").u32(takes)
+                 .raw(",\"timeouts\":").u32(st.timeouts.load())
+                 .raw(",\"wait_avg_us\":").u32(takes ? st.waitSumUs.load() / takes : 0)
+                 .raw(",\"wait_max_us\":").u32(st.waitMaxUs.load())
+                 .raw(",\"hold_avg_us\":").u32(takes ? st.holdSumUs.load() / takes : 0)
+                 .raw(",\"hold_max_us\":").u32(st.holdMaxUs.load())
+                 .ch('}');
+            }
+            w.ch(']');
+#ifdef FY_BENCH
+            w.raw(",\"bench\":{\"rate\":").u32(fyBenchRate.load())
+             .raw(",\"inserted\":").u32(fyBenchInserted.load())
+             .raw(",\"rejected\":").u32(fyBenchRejected.load())
+             .ch('}');
+#endif
+            w.ch('}');
+        }
+        r->send(resp);
+    });
+
+#ifdef FY_BENCH
+    // API: Bench control - ?fill=N inserts N synthetic devices now,
+    // ?rate=R sets the background producer (0 stops it), ?reset=1 zeroes the
+    // lock / response counters
+    fyServer.on("/api/bench", HTTP_GET, [](AsyncWebServerRequest *r) {
+        uint32_t filled = 0;
+        if (r->hasParam("reset")) fyBenchResetStats();
+        if (r->hasParam("fill")) {
+            long n = r->getParam("fill")->value().toInt();
+            for (long i = 0; i < n && fyDetCount < MAX_DETECTIONS; i++) {
+                if (fyBenchInsert((uint32_t)i)) filled++;
+            }
+        }
+        if (r->hasParam("rate")) fyBenchSetRate((uint32_t)r->getParam("rate")->value().toInt());
+        char buf[96];
+        snprintf(buf, sizeof(buf), "{\"capacity\":%d,\"count\":%d,\"filled\":%u,\"rate\":%u}",
+                 MAX_DETECTIONS, fyDetCount, (unsigned)filled, (unsigned)fyBenchRate.load());
+        fySend(r, 200, "application/json", buf);
+    });
+#endif
+
+    // API: Devices in range and the latest enter/exit events (newest first)
+    fyServer.on("/api/presence", HTTP_GET, [](AsyncWebServerRequest *r) {
+        if (!fyLock(FY_LOCK_RESP, 100)) {
+            fySend(r, 503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("{\"present\":").i32(fyPresentCount)
+             .raw(",\"timeout_ms\":").u32(FY_PRESENCE_TIMEOUT_MS)
+             .raw(",\"enters\":").u32(fyPresenceStats.enters.load())
+             .raw(",\"exits\":").u32(fyPresenceStats.exits.load())
+             .raw(",\"dropped\":").u32(fyPresenceStats.dropped.load())
+             .raw(",\"tick_us_max\":").u32(fyPresenceStats.tickUsMax.load())
+             .raw(",\"events\":[");
+            uint32_t n = fyPresenceLogCount < FY_PRESENCE_LOG ? fyPresenceLogCount : FY_PRESENCE_LOG;
+            for (uint32_t i = 0; i < n; i++) {
+                const FYPresenceEvent& e = fyPresenceLog[(fyPresenceLogCount - 1 - i) % FY_PRESENCE_LOG];
+                if (i) w.ch(',');
+                w.raw("{\"event\":\"").raw(e.type == FY_PRES_ENTERED ? "enter" : "exit")
+                 .raw("\",\"mac\":\"").json(e.mac)
+                 .raw("\",\"ms\":").u32(e.ms)
+                 .raw(",\"visits\":").u32(e.visits)
+                 .raw(",\"dwell\":").u32(e.dwellMs).ch('}');
+            }
+            w.raw("]}");
+        }
+        fyUnlock(FY_LOCK_RESP);
+        r->send(resp);
+    });
+
+    // API: Convoy sync - this node, its version vector, peers and wire counters
+    fyServer.on("/api/sync", HTTP_GET, [](AsyncWebServerRequest *r) {
+        if (!fyLock(FY_LOCK_RESP, 100)) {
+            fySend(r, 503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            char hex[9];
+            snprintf(hex, sizeof(hex), "%08x", (unsigned)fySync.self());
+            const FYSyncStats& st = fySync.stats();
+            uint32_t now = millis();
+            w.raw("{\"enabled\":").boolean(fySyncReady)
+             .raw(",\"node\":\"").raw(hex)
+             .raw("\",\"seq\":").u32(fySync.seq())
+             .raw(",\"clock_offset_ms\":").u32(fySync.offset())
+             .raw(",\"records\":").u32(fySync.size())
+             .raw(",\"capacity\":").u32(fySync.capacity())
+             .raw(",\"links\":[");
+            for (size_t i = 0; i < fySync.links(); i++) {
+                if (i) w.ch(',');
+                w.ch('"').raw(fySync.link(i)->name()).ch('"');
+            }
+            w.raw("],\"vv\":{");
+            const FYSyncVV& vv = fySync.vv();
+            for (uint8_t i = 0; i < vv.n; i++) {
+                snprintf(hex, sizeof(hex), "%08x", (unsigned)vv.node[i]);
+                if (i) w.ch(',');
+                w.ch('"').raw(hex).raw("\":").u32(vv.seq[i]);
+            }
+            w.raw("},\"peers\":[");
+            bool first = true;
+            for (size_t i = 0; i < FY_SYNC_PEERS; i++) {
+                const FYSyncPeer& p = fySync.peer(i);
+                if (!p.node) continue;
+                snprintf(hex, sizeof(hex), "%08x", (unsigned)p.node);
+                if (!first) w.ch(',');
+                first = false;
+                w.raw("{\"node\":\"").raw(hex)
+                 .raw("\",\"link\":\"").raw(p.link < fySync.links() ? fySync.link(p.link)->name() : "?")
+                 .raw("\",\"heard_ms_ago\":").u32(now - p.heardMs).ch('}');
+            }
+            w.raw("],\"tx_bytes\":").u32(st.txBytes)
+             .raw(",\"rx_bytes\":").u32(st.rxBytes)
+             .raw(",\"tx_packets\":").u32(st.txPackets)
+             .raw(",\"rx_packets\":").u32(st.rxPackets)
+             .raw(",\"send_fails\":").u32(st.sendFails)
+             .raw(",\"summaries\":").u32(st.summaries)
+             .raw(",\"deltas\":").u32(st.deltas)
+             .raw(",\"batches\":").u32(st.batches)
+             .raw(",\"merged\":").u32(st.merged)
+             .raw(",\"overflow\":").u32(st.overflow)
+             .raw(",\"full\":").u32(st.full)
+             .raw(",\"lossy_writers\":").u32(fySync.lossyAll() ? FY_SYNC_VV : fySync.lossy().n)
+             .raw(",\"backoffs\":").u32(st.backoffs)
+             .raw(",\"reply_drops\":").u32(st.replyDrops)
+             .raw(",\"bad\":").u32(st.bad)
+             .raw(",\"lock_misses\":").u32(fySyncLockMisses.load()).ch('}');
+        }
+        fyUnlock(FY_LOCK_RESP);
+        r->send(resp);
+    });
+
+    // API: Serial stream position and resume counters
+    fyServer.on("/api/serial", HTTP_GET, [](AsyncWebServerRequest *r) {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+            "{\"boot\":\"%s\",\"seq\":%u,\"oldest\":%u,\"capacity\":%u,"
+            "\"resumes\":%u,\"replayed\":%u,\"lost\":%u,\"dropped\":%u,\"slice_us_max\":%u}",
+            fySerialBootHex, (unsigned)fySerialRing.newest(), (unsigned)fySerialRing.oldest(),
+            (unsigned)fySerialRing.capacity(), (unsigned)fySerialStats.resumes.load(),
+            (unsigned)fySerialStats.replayed.load(), (unsigned)fySerialStats.lost.load(),
+            (unsigned)fySerialStats.dropped.load(), (unsigned)fySerialStats.sliceUsMax.load());
+        fySend(r, 200, "application/json", buf);
+    });
+
+    // API: Response pool - memory in use / peak and per-request latency
+    fyServer.on("/api/resp", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            uint32_t served = fyRespStats.served.load();
+            size_t chunk = fyRespPool.chunkSize();
+            w.raw("{\"chunks\":").u32(fyRespPool.count())
+             .raw(",\"chunk_bytes\":").u32(chunk)
+             .raw(",\"in_use\":").u32(fyRespPool.inUse())
+             .raw(",\"peak_in_use\":").u32(fyRespPool.peak())
+             .raw(",\"peak_bytes\":").u32(fyRespPool.peak() * chunk + fyRespStats.auxPeak.load())
+             .raw(",\"aux_peak_bytes\":").u32(fyRespStats.auxPeak.load())
+             .raw(",\"served\":").u32(served)
+             .raw(",\"refused\":").u32(fyRespPool.refused())
+             .raw(",\"lock_misses\":").u32(fyRespStats.lockMisses.load())
+             .raw(",\"bytes\":").u32(fyRespStats.bytes.load())
+             .raw(",\"lat_avg_ms\":").u32(served ? fyRespStats.latSumMs.load() / served : 0)
+             .raw(",\"lat_max_ms\":").u32(fyRespStats.latMaxMs.load())
+             .ch('}');
+        }
+        r->send(resp);
+    });
+
+    // API: Boot timings - this boot plus the persisted history (oldest first)
+    fyServer.on("/api/boot", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            FYBootRecord cur;
+            memset(&cur, 0, sizeof(cur));
+            cur.scanStartUs = fyBoot.scanStartUs;
+            cur.firstAdvertUs = fyBoot.firstAdvertUs;
+            cur.apUpUs = fyBoot.apUpUs;
+            cur.dashboardUs = fyBoot.dashboardUs;
+            cur.fsReadyUs = fyBoot.fsReadyUs;
+            cur.session = fyKnownSession;
+            cur.resetReason = (uint8_t)esp_reset_reason();
+            w.raw("{\"current\":");
+            fyWriteBootJSON(w, cur);
+            w.raw(",\"history\":[");
+            if (fySpiffsReady && SPIFFS.exists(FY_BOOT_FILE)) {
+                File f = SPIFFS.open(FY_BOOT_FILE, "r");
+                FYBootRecord b;
+                for (int i = 0; f && f.read((uint8_t*)&b, sizeof(b)) == sizeof(b); i++) {
+                    if (i) w.ch(',');
+                    fyWriteBootJSON(w, b);
                 }
+                if (f) f.close();
+            }
+            w.raw("]}");
+        }
+        r->send(resp);
+    });
+
+    // API: Pattern database
+    fyServer.on("/api/patterns", HTTP_GET, [](AsyncWebServerRequest *r) {
+        AsyncResponseStream *resp = r->beginResponseStream("application/json");
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("{\"macs\":[");
+            for (size_t i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
+                if (i > 0) w.ch(',');
+                w.ch('"').json(mac_prefixes[i]).ch('"');
+            }
+            w.raw("],\"names\":[");
+            for (size_t i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
+                if (i > 0) w.ch(',');
+                w.ch('"').json(device_name_patterns[i]).ch('"');
+            }
+            w.raw("],\"mfr\":[");
+            for (size_t i = 0; i < sizeof(ble_manufacturer_ids)/sizeof(ble_manufacturer_ids[0]); i++) {
+                if (i > 0) w.ch(',');
+                w.u32(ble_manufacturer_ids[i]);
             }
-            xSemaphoreGive(fyMutex);
+            w.raw("],\"raven\":[");
+            for (size_t i = 0; i < sizeof(raven_service_uuids)/sizeof(raven_service_uuids[0]); i++) {
+                if (i > 0) w.ch(',');
+                w.ch('"').json(raven_service_uuids[i]).ch('"');
+            }
+            w.raw("]}");
         }
         r->send(resp);
     });
 
+    // API: Export JSON (downloadable file)
+    fyServer.on("/api/export/json", HTTP_GET, [](AsyncWebServerRequest *r) {
+        fyRespSend<FYJsonGen>(r, "application/json", "flockyou_detections.json");
+    });
+
+    // API: Export compact binary (FYDB v1, decode with api/fybin.py)
+    fyServer.on("/api/export/bin", HTTP_GET, [](AsyncWebServerRequest *r) {
+        fyRespSend<FYBinGen>(r, "application/octet-stream", "flockyou_detections.fyb");
+    });
+
+    // API: Export CSV (downloadable file, includes GPS)
+    fyServer.on("/api/export/csv", HTTP_GET, [](AsyncWebServerRequest *r) {
+        fyRespSend<FYCsvGen>(r, "text/csv", "flockyou_detections.csv");
+    });
+
     // API: Export KML (GPS-tagged detections for Google Earth)
     fyServer.on("/api/export/kml", HTTP_GET, [](AsyncWebServerRequest *r) {
-        AsyncResponseStream *resp = r->beginResponseStream("application/vnd.google-earth.kml+xml");
-        resp->addHeader("Content-Disposition", "attachment; filename=\"flockyou_detections.kml\"");
-        writeDetectionsKML(resp);
-        r->send(resp);
+        fyRespSend<FYKmlGen>(r, "application/vnd.google-earth.kml+xml", "flockyou_detections.kml");
     });
 
     // API: Prior session history (JSON)
     fyServer.on("/api/history", HTTP_GET, [](AsyncWebServerRequest *r) {
-        if (fySpiffsReady && SPIFFS.exists(FY_PREV_FILE)) {
-            r->send(SPIFFS, FY_PREV_FILE, "application/json");
-        } else {
-            r->send(200, "application/json", "[]");
-        }
+        AsyncWebServerResponse *resp = NULL;
+        if (fySpiffsReady && SPIFFS.exists(FY_PREV_FILE)) resp = fyFileResponse(r, FY_PREV_FILE, "application/json");
+        if (resp) r->send(resp);
+        else fySend(r, 200, "application/json", "[]");
     });
 
     // API: Download prior session as JSON file
     fyServer.on("/api/history/json", HTTP_GET, [](AsyncWebServerRequest *r) {
-        if (fySpiffsReady && SPIFFS.exists(FY_PREV_FILE)) {
-            AsyncWebServerResponse *resp = r->beginResponse(SPIFFS, FY_PREV_FILE, "application/json");
+        AsyncWebServerResponse *resp = NULL;
+        if (fySpiffsReady && SPIFFS.exists(FY_PREV_FILE)) resp = fyFileResponse(r, FY_PREV_FILE, "application/json");
+        if (resp) {
             resp->addHeader("Content-Disposition", "attachment; filename=\"flockyou_prev_session.json\"");
             r->send(resp);
         } else {
-            r->send(404, "application/json", "{\"error\":\"no prior session\"}");
+            fySend(r, 404, "application/json", "{\"error\":\"no prior session\"}");
         }
     });
 
     // API: Download prior session as KML (reads JSON from SPIFFS, converts)
     fyServer.on("/api/history/kml", HTTP_GET, [](AsyncWebServerRequest *r) {
         if (!fySpiffsReady || !SPIFFS.exists(FY_PREV_FILE)) {
-            r->send(404, "application/json", "{\"error\":\"no prior session\"}");
+            fySend(r, 404, "application/json", "{\"error\":\"no prior session\"}");
             return;
         }
         File f = SPIFFS.open(FY_PREV_FILE, "r");
-        if (!f) { r->send(500, "text/plain", "read error"); return; }
+        if (!f) { fySend(r, 500, "text/plain", "read error"); return; }
         String content = f.readString();
         f.close();
         if (content.length() == 0) {
-            r->send(404, "application/json", "{\"error\":\"prior session empty\"}");
+            fySend(r, 404, "application/json", "{\"error\":\"prior session empty\"}");
             return;
         }
         AsyncResponseStream *resp = r->beginResponseStream("application/vnd.google-earth.kml+xml");
         resp->addHeader("Content-Disposition", "attachment; filename=\"flockyou_prev_session.kml\"");
-        resp->print("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-                    "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n"
-                    "<name>Flock-You Prior Session</name>\n"
-                    "<description>Surveillance device detections from prior session</description>\n"
-                    "<Style id=\"det\"><IconStyle><color>ff4489ec</color>"
-                    "<scale>1.0</scale></IconStyle></Style>\n"
-                    "<Style id=\"raven\"><IconStyle><color>ff4444ef</color>"
-                    "<scale>1.2</scale></IconStyle></Style>\n");
-        // Parse JSON array and emit placemarks
-        JsonDocument doc;
-        DeserializationError err = deserializeJson(doc, content);
-        if (!err && doc.is<JsonArray>()) {
-            int placed = 0;
-            for (JsonObject d : doc.as<JsonArray>()) {
-                JsonObject gps = d["gps"];
-                if (!gps || !gps.containsKey("lat")) continue;
-                bool isRaven = d["raven"] | false;
-                resp->printf("<Placemark><name>%s</name>\n", d["mac"] | "?");
-                resp->printf("<styleUrl>#%s</styleUrl>\n", isRaven ? "raven" : "det");
-                resp->print("<description><![CDATA[");
-                if (d["name"].is<const char*>() && strlen(d["name"] | "") > 0)
-                    resp->printf("<b>Name:</b> %s<br/>", d["name"] | "");
-                resp->printf("<b>Method:</b> %s<br/><b>RSSI:</b> %d<br/><b>Count:</b> %d",
-                    d["method"] | "?", d["rssi"] | 0, d["count"] | 1);
-                if (isRaven && d["fw"].is<const char*>())
-                    resp->printf("<br/><b>Raven FW:</b> %s", d["fw"] | "");
-                resp->print("]]></description>\n");
-                resp->printf("<Point><coordinates>%.8f,%.8f,0</coordinates></Point>\n",
-                    (double)(gps["lon"] | 0.0), (double)(gps["lat"] | 0.0));
-                resp->print("</Placemark>\n");
-                placed++;
+        {
+            FYTxStream tx = {*resp};
+            FYWriter<FYTxStream> w(tx);
+            w.raw("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n"
+                  "<name>Flock-You Prior Session</name>\n"
+                  "<description>Surveillance device detections from prior session</description>\n"
+                  "<Style id=\"det\"><IconStyle><color>ff4489ec</color>"
+                  "<scale>1.0</scale></IconStyle></Style>\n"
+                  "<Style id=\"raven\"><IconStyle><color>ff4444ef</color>"
+                  "<scale>1.2</scale></IconStyle></Style>\n");
+            // Parse JSON array and emit placemarks
+            JsonDocument doc;
+            DeserializationError err = deserializeJson(doc, content);
+            if (!err && doc.is<JsonArray>()) {
+                int placed = 0;
+                for (JsonObject d : doc.as<JsonArray>()) {
+                    JsonObject gps = d["gps"];
+                    if (!gps || !gps.containsKey("lat")) continue;
+                    bool isRaven = d["raven"] | false;
+                    w.raw("<Placemark><name>").xml(d["mac"] | "?").raw("</name>\n");
+                    w.raw("<styleUrl>#").raw(isRaven ? "raven" : "det").raw("</styleUrl>\n");
+                    w.raw("<description><![CDATA[");
+                    if (d["name"].is<const char*>() && strlen(d["name"] | "") > 0)
+                        w.raw("<b>Name:</b> ").xml(d["name"] | "").raw("<br/>");
+                    w.raw("<b>Method:</b> ").xml(d["method"] | "?")
+                     .raw("<br/><b>RSSI:</b> ").i32(d["rssi"] | 0)
+                     .raw("<br/><b>Count:</b> ").i32(d["count"] | 1);
+                    if (isRaven && d["fw"].is<const char*>())
+                        w.raw("<br/><b>Raven FW:</b> ").xml(d["fw"] | "");
+                    w.raw("]]></description>\n<Point><coordinates>")
+                     .fixed((double)(gps["lon"] | 0.0), 8).ch(',')
+                     .fixed((double)(gps["lat"] | 0.0), 8)
+                     .raw(",0</coordinates></Point>\n</Placemark>\n");
+                    placed++;
+                }
+                printf("[FLOCK-YOU] Prior session KML: %d placemarks\n", placed);
+            } else {
+                printf("[FLOCK-YOU] Prior session KML: JSON parse failed\n");
             }
-            printf("[FLOCK-YOU] Prior session KML: %d placemarks\n", placed);
-        } else {
-            printf("[FLOCK-YOU] Prior session KML: JSON parse failed\n");
+            w.raw("</Document>\n</kml>");
         }
-        resp->print("</Document>\n</kml>");
         r->send(resp);
     });
 
     // API: Clear all detections (saves current session first)
     fyServer.on("/api/clear", HTTP_GET, [](AsyncWebServerRequest *r) {
         fySaveSession();  // Persist before clearing
-        if (fyMutex && xSemaphoreTake(fyMutex, pdMS_TO_TICKS(200)) == pdTRUE) {
+        if (fyKnownDirty) fyKnownSave();
+        if (fyLock(FY_LOCK_CLEAR, 200)) {
             fyDetCount = 0;
-            memset(fyDet, 0, sizeof(fyDet));
-            fyTriggered = false;
-            fyDeviceInRange = false;
-            xSemaphoreGive(fyMutex);
+            memset(fyDet, 0, MAX_DETECTIONS * sizeof(FYDetection));
+            fyStatsReset();
+            fyPresenceReset();
+            fyUnlock(FY_LOCK_CLEAR);
         }
-        r->send(200, "application/json", "{\"status\":\"cleared\"}");
+        fySend(r, 200, "application/json", "{\"status\":\"cleared\"}");
         printf("[FLOCK-YOU] All detections cleared (session saved)\n");
     });
 
     fyServer.begin();
+    fyBoot.dashboardUs = fyNowUs();
     printf("[FLOCK-YOU] Web server started on port 80\n");
 }
 
+// ============================================================================
+// TASKS
+// ============================================================================
+
+// NimBLE host task: scan window ended
+static void fyScanComplete(NimBLEScanResults) {
+    fyRadioSignal(FY_EV_SCAN_DONE);
+}
+
+static void fyTimerSignal(void* bit) {
+    fyRadioSignal((EventBits_t)(uintptr_t)bit);
+}
+
+static void fyPersistTimerCb(void*) {
+    fyPersistPost(FY_PERSIST_TICK);
+}
+
+// Deferred from setup(): mount (may format), promote last session, load the
+// known index. Autosave stays off until fySpiffsReady, so the new session
+// can never overwrite the one being promoted.
+static void fyPersistBoot() {
+    if (SPIFFS.begin(true)) {
+        printf("[FLOCK-YOU] SPIFFS ready\n");
+        // Promote last session to prev_session before we start a new one.
+        // Only then open SPIFFS to the other tasks: a save from /api/clear
+        // during promotion would overwrite /session.json mid-copy.
+        fyPromotePrevSession();
+        fySpiffsReady = true;
+    } else {
+        printf("[FLOCK-YOU] SPIFFS init failed - no persistence\n");
+    }
+    fyKnownInit();
+    fyBoot.fsReadyUs = fyNowUs();
+}
+
+static void fyScanStart() {
+    if (fyBLEScan->start(BLE_SCAN_DURATION, fyScanComplete, false)) {
+        if (!fyBoot.scanStartUs.load(std::memory_order_relaxed)) fyBoot.scanStartUs = fyNowUs();
+        fyScanStats.scans.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Host busy (e.g. still tearing down the last scan) - retry after a gap
+        fyScanStats.startFails.fetch_add(1, std::memory_order_relaxed);
+        esp_timer_start_once(fyScanTimer, (uint64_t)FY_SCAN_GAP_MS * 1000);
+    }
+}
+
+static void fyCpuTick() {
+    static uint32_t lastUs = 0;
+    uint32_t now = fyNowUs();
+    uint32_t window = now - lastUs;
+    lastUs = now;
+    if (!window) return;
+    for (size_t i = 0; i < FY_TASK_COUNT; i++) {
+        FYTaskStats* t = fyTasks[i];
+        uint32_t busy = t->busyUs.load(std::memory_order_relaxed);
+        t->cpuPermille.store((uint32_t)((uint64_t)(busy - t->lastBusyUs) * 1000 / window),
+                             std::memory_order_relaxed);
+        t->lastBusyUs = busy;
+    }
+}
+
+static void fyRadioTask(void*) {
+    for (;;) {
+        EventBits_t bits = xEventGroupWaitBits(fyRadioEvents, FY_EV_ALL, pdTRUE, pdFALSE, portMAX_DELAY);
+        uint32_t t0 = fyNowUs();
+        for (int i = 0; i < FY_EV_COUNT; i++) {
+            if (bits & (1 << i)) fyTaskWake(fyTaskRadio, fyEvStamp[i].load(std::memory_order_relaxed), t0);
+        }
+
+        if (bits & FY_EV_SCAN_DONE) {
+            fyBLEScan->clearResults();
+            fyScanStats.doneUs = t0;
+            esp_timer_start_once(fyScanTimer, (uint64_t)FY_SCAN_GAP_MS * 1000);
+        }
+        if (bits & FY_EV_SCAN_KICK) {
+            uint32_t gap = t0 - fyScanStats.doneUs;
+            uint32_t over = gap > FY_SCAN_GAP_MS * 1000UL ? gap - FY_SCAN_GAP_MS * 1000UL : 0;
+            if (over > fyScanStats.gapErrMaxUs.load(std::memory_order_relaxed)) {
+                fyScanStats.gapErrMaxUs.store(over, std::memory_order_relaxed);
+            }
+            fyScanStart();
+        }
+        if (bits & FY_EV_WIFI_HIT) fyWifiDrain();
+        if (bits & (FY_EV_PRESENCE | FY_EV_TICK)) fyPresenceDrain();
+        if (bits & FY_EV_TICK) {
+            fyPresenceTick();
+            if (fyWifiActive) fyWifiRates();
+            if (fyCoexActive) fyCoexTick();
+            fyCpuTick();
+        }
+        fyTaskDone(fyTaskRadio, t0);
+    }
+}
+
+// Autosave + known-index flush (was polled from loop())
+static void fyPersistTask(void*) {
+    FYPersistMsg m;
+    for (;;) {
+        if (xQueueReceive(fyPersistQueue, &m, portMAX_DELAY) != pdTRUE) continue;
+        uint32_t t0 = fyNowUs();
+        fyTaskWake(fyTaskPersist, m.stampUs, t0);
+        if (m.op == FY_PERSIST_BOOT) {
+            fyPersistBoot();
+            fyTaskDone(fyTaskPersist, t0);
+            continue;
+        }
+        if (m.op == FY_PERSIST_SYNC) {
+            fySyncFlush();
+            fyTaskDone(fyTaskPersist, t0);
+            continue;
+        }
+
+        // Boot metrics: once the first advert is in (or the window closes)
+        if (!fyBoot.saved && fySpiffsReady &&
+            (fyBoot.firstAdvertUs || millis() >= FY_BOOT_SAVE_MS)) {
+            fyBootSave();
+            fyBoot.saved = true;
+        }
+
+        // Auto-save session to SPIFFS every 15s if detections changed
+        // Also triggers an early save 5s after first detection to minimize loss on power-cycle
+        if (fySpiffsReady && millis() - fyLastSave >= FY_SAVE_INTERVAL) {
+            if (fyDetCount > 0 && fyDetCount != fyLastSaveCount) {
+                fySaveSession();
+            }
+            fyLastSave = millis();
+        } else if (fySpiffsReady && fyDetCount > 0 && fyLastSaveCount == 0 &&
+                   millis() - fyLastSave >= 5000) {
+            // Quick first-save: persist within 5s of first detection
+            fySaveSession();
+            fyLastSave = millis();
+        }
+
+        // Known-device index: bounded flash writes, only when something changed
+        if (fyKnownDirty && millis() - fyKnownLastSave >= FY_KNOWN_SAVE_INTERVAL) {
+            fyKnownSave();
+        }
+
+        // Host bridge commands (RESUME)
+        fySerialPoll();
+        fySyncTick();
+        fyTaskDone(fyTaskPersist, t0);
+    }
+}
+
+static void fyTasksInit() {
+    fyRadioEvents = xEventGroupCreate();
+    fyAudioQueue = xQueueCreate(FY_AUDIO_QUEUE, sizeof(FYAudioMsg));
+    fyPersistQueue = xQueueCreate(FY_PERSIST_QUEUE, sizeof(FYPersistMsg));
+
+    fyTaskStart(fyRadioTask, fyTaskRadio, FY_RADIO_STACK, FY_RADIO_PRIO, FY_RADIO_CORE);
+    fyTaskStart(fyAudioTask, fyTaskAudio, FY_AUDIO_STACK, FY_AUDIO_PRIO, FY_AUDIO_CORE);
+    fyTaskStart(fyPersistTask, fyTaskPersist, FY_PERSIST_STACK, FY_PERSIST_PRIO, FY_PERSIST_CORE);
+
+    esp_timer_create_args_t args = {};
+    args.callback = &fyTimerSignal;
+    args.arg = (void*)(uintptr_t)FY_EV_SCAN_KICK;
+    args.name = "fy_scan_gap";
+    esp_timer_create(&args, &fyScanTimer);
+
+    args.arg = (void*)(uintptr_t)FY_EV_TICK;
+    args.name = "fy_tick";
+    if (esp_timer_create(&args, &fyTickTimer) == ESP_OK) {
+        esp_timer_start_periodic(fyTickTimer, (uint64_t)FY_TICK_MS * 1000);
+    }
+
+    args.callback = &fyPersistTimerCb;
+    args.arg = NULL;
+    args.name = "fy_persist";
+    if (esp_timer_create(&args, &fyPersistTimer) == ESP_OK) {
+        esp_timer_start_periodic(fyPersistTimer, (uint64_t)FY_PERSIST_TICK_MS * 1000);
+    }
+}
+
 // ============================================================================
 // MAIN FUNCTIONS
 // ============================================================================
 
 void setup() {
+    // No settle delay: BLE comes up first, the console catches up
     Serial.begin(115200);
-    delay(500);
 
     // Standalone mode: buzzer always on by default
     fyBuzzerOn = true;
@@ -955,22 +3610,16 @@ void setup() {
     pinMode(BUZZER_PIN, OUTPUT);
     digitalWrite(BUZZER_PIN, LOW);
 
-    fyMutex = xSemaphoreCreateMutex();
-
-    // Init SPIFFS for session persistence
-    if (SPIFFS.begin(true)) {
-        fySpiffsReady = true;
-        printf("[FLOCK-YOU] SPIFFS ready\n");
-        // Promote last session to prev_session before we start a new one
-        fyPromotePrevSession();
-    } else {
-        printf("[FLOCK-YOU] SPIFFS init failed - no persistence\n");
+#if MAX_DETECTIONS > FY_DET_INTERNAL_MAX
+    fyDet = (FYDetection*)ps_calloc(MAX_DETECTIONS, sizeof(FYDetection));
+    if (!fyDet) {
+        printf("[FLOCK-YOU] No PSRAM for %u detections - halting\n", (unsigned)MAX_DETECTIONS);
+        for (;;) delay(1000);
     }
-
-    printf("\n========================================\n");
-    printf("  FLOCK-YOU Surveillance Detector\n");
-    printf("  Buzzer: %s\n", fyBuzzerOn ? "ON" : "OFF");
-    printf("========================================\n");
+#endif
+    fyMutex = xSemaphoreCreateMutex();
+    fySerialInit();
+    fyTasksInit();
 
     // Init BLE scanner FIRST -- start scanning immediately
     NimBLEDevice::init("");
@@ -980,66 +3629,60 @@ void setup() {
     fyBLEScan->setInterval(100);
     fyBLEScan->setWindow(99);
 
-    // Kick off the first scan right away
-    fyBLEScan->start(BLE_SCAN_DURATION, false);
-    fyLastBleScan = millis();
+    // Kick off the first scan right away; each completion schedules the next
+    fyScanStart();
     printf("[FLOCK-YOU] BLE scanning ACTIVE\n");
 
-    // Crow calls play WHILE BLE is already scanning
-    fyBootBeep();
+    // Filesystem mount, session promotion and known-index load happen on
+    // the low-priority persist task while the radios come up
+    fyPersistPost(FY_PERSIST_BOOT);
+
+    // Crow calls play on the audio task WHILE everything else starts
+    fyAudioPlay(FY_SND_BOOT);
 
     // Start WiFi AP (no need to connect to anything -- AP only)
+#ifdef FY_SYNC_UPLINK
+    // Follower: also joins the lead unit (CONVOY SYNC). Its own AP gets an
+    // SSID and a 192.168.10-249.0/24 subnet from its MAC: phones can tell
+    // the units apart, only the lead answers to FY_SYNC_UPLINK so followers
+    // never join each other, and dashboard replies never route out the
+    // station link.
+    WiFi.mode(WIFI_AP_STA);
+    uint8_t apMac[6];
+    WiFi.softAPmacAddress(apMac);
+    char apSsid[24];
+    snprintf(apSsid, sizeof(apSsid), "%s-%02X%02X", FY_AP_SSID, apMac[4], apMac[5]);
+    uint8_t apNet = (uint8_t)(10 + ((apMac[4] << 8) | apMac[5]) % 240);
+    WiFi.softAPConfig(IPAddress(192, 168, apNet, 1), IPAddress(192, 168, apNet, 1),
+                      IPAddress(255, 255, 255, 0));
+#else
     WiFi.mode(WIFI_AP);
-    delay(100);
-    WiFi.softAP(FY_AP_SSID, FY_AP_PASS);
-    printf("[FLOCK-YOU] AP: %s / %s\n", FY_AP_SSID, FY_AP_PASS);
+    const char* apSsid = FY_AP_SSID;
+#endif
+    WiFi.softAP(apSsid, FY_AP_PASS);
+    fyBoot.apUpUs = fyNowUs();
+    printf("[FLOCK-YOU] AP: %s / %s\n", apSsid, FY_AP_PASS);
     printf("[FLOCK-YOU] IP: %s\n", WiFi.softAPIP().toString().c_str());
+    fyCoexInit();
+    fyWifiSnifferInit();
+    fySyncInit();
 
     // Start web dashboard
+    fyRespInit();
     fySetupServer();
+    fyCamInit();
 
-    printf("[FLOCK-YOU] Detection methods: MAC prefix, device name, manufacturer ID, Raven UUID\n");
-    printf("[FLOCK-YOU] Dashboard: http://192.168.4.1\n");
-    printf("[FLOCK-YOU] Ready - no WiFi connection needed, BLE + AP only\n\n");
+    printf("\n========================================\n");
+    printf("  FLOCK-YOU Surveillance Detector\n");
+    printf("  Buzzer: %s\n", fyBuzzerOn ? "ON" : "OFF");
+    printf("========================================\n");
+    printf("[FLOCK-YOU] Detection methods: MAC prefix, device name, manufacturer ID, Raven UUID, WiFi OUI/SSID\n");
+    printf("[FLOCK-YOU] Dashboard: http://%s\n", WiFi.softAPIP().toString().c_str());
+    printf("[FLOCK-YOU] Ready - no WiFi connection needed, BLE + AP + WiFi sniffer\n\n");
 }
 
+// Everything runs in the tasks started by fyTasksInit() - retire the
+// Arduino loop task instead of letting it poll.
 void loop() {
-    // BLE scanning cycle
-    if (millis() - fyLastBleScan >= BLE_SCAN_INTERVAL && !fyBLEScan->isScanning()) {
-        fyBLEScan->start(BLE_SCAN_DURATION, false);
-        fyLastBleScan = millis();
-    }
-
-    if (!fyBLEScan->isScanning() && millis() - fyLastBleScan > BLE_SCAN_DURATION * 1000) {
-        fyBLEScan->clearResults();
-    }
-
-    // Heartbeat tracking
-    if (fyDeviceInRange) {
-        if (millis() - fyLastHB >= 10000) {
-            fyHeartbeat();
-            fyLastHB = millis();
-        }
-        if (millis() - fyLastDetTime >= 30000) {
-            printf("[FLOCK-YOU] Device out of range - stopping heartbeat\n");
-            fyDeviceInRange = false;
-            fyTriggered = false;
-        }
-    }
-
-    // Auto-save session to SPIFFS every 15s if detections changed
-    // Also triggers an early save 5s after first detection to minimize loss on power-cycle
-    if (fySpiffsReady && millis() - fyLastSave >= FY_SAVE_INTERVAL) {
-        if (fyDetCount > 0 && fyDetCount != fyLastSaveCount) {
-            fySaveSession();
-        }
-        fyLastSave = millis();
-    } else if (fySpiffsReady && fyDetCount > 0 && fyLastSaveCount == 0 &&
-               millis() - fyLastSave >= 5000) {
-        // Quick first-save: persist within 5s of first detection
-        fySaveSession();
-        fyLastSave = millis();
-    }
-
-    delay(100);
+    vTaskDelete(NULL);
 }
@@ -0,0 +1,180 @@
+// ============================================================================
+// FLOCK-YOU: Offline camera index check (host)
+// ============================================================================
+// Loads an image built by tools/mkcamindex.py, attaches it with FYCamIndex
+// (src/fy_camindex.h) as the firmware does, and compares FYCamIndex::query
+// against a brute-force scan of every point for random bounding boxes:
+// small boxes around real points, city-sized boxes, boxes wide enough to
+// take the directory-walk path, and inverted/empty ones. Each box must
+// return exactly the brute-force point set; an early stop must return
+// exactly as many points as asked for.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/camindex_check.cpp -o camindex_check
+//   ./camindex_check camindex.bin [-n boxes] [-s seed] [-q S,W,N,E]
+//
+// python tools/mkcamindex.py --check builds and runs this on its output.
+// -q also runs one given box and prints its points like mkcamindex.py
+// --query. Prints one JSON summary line; exit code 1 on any mismatch, 2 if
+// the image does not attach.
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "fy_camindex.h"
+
+static uint64_t rngState = 1;
+static uint64_t rnd() {
+    // xorshift64*
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+static double uniform(double lo, double hi) { return lo + (hi - lo) * (double)(rnd() >> 11) / 9007199254740992.0; }
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static FYCamIndex idx;
+static const FYCamPoint* points = NULL;
+static uint32_t pointCount = 0;
+static double queryUs = 0, bruteUs = 0;
+
+// Same degrees -> E7 truncation as FYCamIndex
+static int32_t toE7(double deg) {
+    double v = deg * 1e7;
+    if (v > 2147483647.0) return 2147483647;
+    if (v < -2147483647.0) return -2147483647;
+    return (int32_t)v;
+}
+
+static void brute(double s, double w, double n, double e, std::vector<uint32_t>& out) {
+    out.clear();
+    if (s > n || w > e) return;
+    int32_t s7 = toE7(s), n7 = toE7(n), w7 = toE7(w), e7 = toE7(e);
+    for (uint32_t i = 0; i < pointCount; i++) {
+        const FYCamPoint& p = points[i];
+        if (p.latE7 >= s7 && p.latE7 <= n7 && p.lonE7 >= w7 && p.lonE7 <= e7) out.push_back(i);
+    }
+}
+
+// false on mismatch
+static bool checkBox(double s, double w, double n, double e) {
+    std::vector<uint32_t> got, want;
+    double t0 = nowUs();
+    size_t hits = idx.query(s, w, n, e, [&](const FYCamPoint& p) {
+        got.push_back((uint32_t)(&p - points));
+        return true;
+    });
+    double t1 = nowUs();
+    brute(s, w, n, e, want);
+    double t2 = nowUs();
+    queryUs += t1 - t0;
+    bruteUs += t2 - t1;
+    std::sort(got.begin(), got.end());
+    bool ok = hits == got.size() && got == want;
+
+    // Early stop: asking for k points returns exactly min(k, total)
+    size_t k = want.empty() ? 1 : 1 + (size_t)(rnd() % want.size()), seen = 0;
+    size_t stopped = idx.query(s, w, n, e, [&](const FYCamPoint&) { return ++seen < k; });
+    if (stopped != std::min(k, want.size())) ok = false;
+
+    if (!ok) {
+        printf("FAIL box %.7f,%.7f,%.7f,%.7f: query %u points (returned %u), brute force %u, "
+               "stop at %u returned %u\n", s, w, n, e, (unsigned)got.size(), (unsigned)hits,
+               (unsigned)want.size(), (unsigned)k, (unsigned)stopped);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    const char* box = NULL;
+    unsigned long boxes = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) boxes = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) rngState = strtoull(argv[++i], NULL, 10) * 2654435761u + 1;
+        else if (!strcmp(argv[i], "-q") && i + 1 < argc) box = argv[++i];
+        else path = argv[i];
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s <camindex.bin> [-n boxes] [-s seed] [-q S,W,N,E]\n", argv[0]);
+        return 2;
+    }
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+    std::vector<uint8_t> image;
+    uint8_t chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) image.insert(image.end(), chunk, chunk + got);
+    fclose(f);
+    if (!idx.attach(image.data(), image.size())) {
+        fprintf(stderr, "%s: not a valid FYCI v%d image\n", path, FY_CAM_VERSION);
+        return 2;
+    }
+    const FYCamHeader* h = (const FYCamHeader*)image.data();
+    points = (const FYCamPoint*)(image.data() + h->pointsOffset);
+    pointCount = h->pointCount;
+
+    unsigned long failed = 0, checked = 0;
+    if (box) {
+        double s, w, n, e;
+        if (sscanf(box, "%lf,%lf,%lf,%lf", &s, &w, &n, &e) != 4) {
+            fprintf(stderr, "-q wants S,W,N,E\n");
+            return 2;
+        }
+        size_t hits = idx.query(s, w, n, e, [&](const FYCamPoint& p) {
+            printf("    %.7f,%.7f %s %s\n", p.latE7 / 1e7, p.lonE7 / 1e7,
+                   p.source < FY_CAM_SRC_COUNT ? fy_cam_source_names[p.source] : "?", idx.label(p));
+            return true;
+        });
+        printf("  query -> %u points\n", (unsigned)hits);
+        checked++;
+        if (!checkBox(s, w, n, e)) failed++;
+    }
+    for (unsigned long i = 0; i < boxes; i++, checked++) {
+        double s, w, n, e;
+        switch (i % 4) {
+            case 0: {
+                // Around a real point, up to ~2 km: edges land on and next to points
+                const FYCamPoint& p = points[rnd() % (pointCount ? pointCount : 1)];
+                double lat = pointCount ? p.latE7 / 1e7 : 0, lon = pointCount ? p.lonE7 / 1e7 : 0;
+                double dLat = uniform(0, 0.02), dLon = uniform(0, 0.02);
+                s = lat - dLat; n = lat + dLat; w = lon - dLon; e = lon + dLon;
+                break;
+            }
+            case 1: {
+                // City-sized, anywhere
+                double lat = uniform(-85, 85), lon = uniform(-179, 179), d = uniform(0.01, 1);
+                s = lat - d; n = lat + d; w = lon - d; e = lon + d;
+                break;
+            }
+            case 2: {
+                // Wide: past FY_CAM_MAX_TILES at the usual levels
+                s = uniform(-90, 0); n = uniform(0, 90); w = uniform(-180, 0); e = uniform(0, 180);
+                break;
+            }
+            default:
+                // Random corners; about half are inverted and must return nothing
+                s = uniform(-91, 91); n = uniform(-91, 91); w = uniform(-181, 181); e = uniform(-181, 181);
+        }
+        if (!checkBox(s, w, n, e)) failed++;
+    }
+
+    printf("{\"points\":%u,\"tiles\":%u,\"level\":%u,\"boxes\":%lu,\"failed\":%lu,"
+           "\"query_us\":%.2f,\"brute_us\":%.2f}\n",
+           pointCount, idx.tileCount(), idx.level(), checked, failed,
+           checked ? queryUs / checked : 0.0, checked ? bruteUs / checked : 0.0);
+    return failed ? 1 : 0;
+}
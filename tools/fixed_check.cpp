@@ -0,0 +1,227 @@
+// ============================================================================
+// FLOCK-YOU: FYWriter number formatting check and bench (host)
+// ============================================================================
+// Checks that FYWriter (src/fy_serialize.h) formats numbers exactly as
+// printf does - fixed() against "%.*f", u32()/i32() against %lu/%ld - over
+// random values in the ranges the exports use plus rounding ties and
+// edge cases. Then formats detection rows both ways (the pre-FYWriter
+// snprintf row and the fyWriteDetJSON calls) and reports the time.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/fixed_check.cpp -o fixed_check
+//   ./fixed_check [-n values] [-r rows] [-s seed]   # defaults 2000000, 200000, 1
+//
+// Prints mismatches (first 20) and one JSON summary line; exit code 1 on
+// any mismatch, including a row whose two forms differ.
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "fy_serialize.h"
+
+static unsigned long mismatches = 0;
+
+static uint64_t rngState = 1;
+static uint64_t rnd() {
+    // xorshift64*
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+static double uniform(double lo, double hi) { return lo + (hi - lo) * (double)(rnd() >> 11) / 9007199254740992.0; }
+
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char* what, const char* want, const char* got) {
+    if (++mismatches <= 20) printf("FAIL %s: printf \"%s\", FYWriter \"%s\"\n", what, want, got);
+}
+
+static void checkFixed(double v, int decimals) {
+    char want[64], got[64], what[64];
+    snprintf(want, sizeof(want), "%.*f", decimals, v);
+    FYBufSink s = {(uint8_t*)got, sizeof(got) - 1, 0, false};
+    {
+        FYWriter<FYBufSink, 64> w(s);
+        w.fixed(v, decimals);
+    }
+    got[s.len] = '\0';
+    if (strcmp(want, got)) {
+        snprintf(what, sizeof(what), "fixed(%.17g, %d)", v, decimals);
+        report(what, want, got);
+    }
+}
+
+static void checkInt(long v) {
+    char want[32], got[32], what[48];
+    snprintf(want, sizeof(want), "%ld", v);
+    FYBufSink s = {(uint8_t*)got, sizeof(got) - 1, 0, false};
+    {
+        FYWriter<FYBufSink, 32> w(s);
+        w.i32(v);
+    }
+    got[s.len] = '\0';
+    if (strcmp(want, got)) {
+        snprintf(what, sizeof(what), "i32(%ld)", v);
+        report(what, want, got);
+    }
+    unsigned long u = (unsigned long)(uint32_t)v;  // millis()-sized, as on the device
+    snprintf(want, sizeof(want), "%lu", u);
+    s.len = 0;
+    {
+        FYWriter<FYBufSink, 32> w(s);
+        w.u32(u);
+    }
+    got[s.len] = '\0';
+    if (strcmp(want, got)) {
+        snprintf(what, sizeof(what), "u32(%lu)", u);
+        report(what, want, got);
+    }
+}
+
+// FYDetection's exported fields, same sizes as in main.cpp
+struct Row {
+    char mac[18];
+    char name[48];
+    int rssi;
+    char method[24];
+    unsigned long firstSeen;
+    unsigned long lastSeen;
+    int count;
+    bool isRaven;
+    char ravenFW[16];
+    double gpsLat;
+    double gpsLon;
+    float gpsAcc;
+    bool hasGPS;
+};
+
+// The row as writeDetectionsJSON printed it before FYWriter
+static size_t rowPrintf(char* out, size_t cap, const Row& d) {
+    int n = snprintf(out, cap,
+        "{\"mac\":\"%s\",\"name\":\"%s\",\"rssi\":%d,\"method\":\"%s\","
+        "\"first\":%lu,\"last\":%lu,\"count\":%d,"
+        "\"raven\":%s,\"fw\":\"%s\"",
+        d.mac, d.name, d.rssi, d.method, d.firstSeen, d.lastSeen, d.count,
+        d.isRaven ? "true" : "false", d.ravenFW);
+    if (d.hasGPS) {
+        n += snprintf(out + n, cap - n, ",\"gps\":{\"lat\":%.8f,\"lon\":%.8f,\"acc\":%.1f}",
+                      d.gpsLat, d.gpsLon, d.gpsAcc);
+    }
+    n += snprintf(out + n, cap - n, "}");
+    return (size_t)n;
+}
+
+// The same fields through the calls fyWriteDetJSON makes
+static size_t rowWriter(char* out, size_t cap, const Row& d) {
+    FYBufSink s = {(uint8_t*)out, cap, 0, false};
+    {
+        FYWriter<FYBufSink, 128> w(s);
+        w.raw("{\"mac\":\"").json(d.mac)
+         .raw("\",\"name\":\"").json(d.name)
+         .raw("\",\"rssi\":").i32(d.rssi)
+         .raw(",\"method\":\"").json(d.method)
+         .raw("\",\"first\":").u32(d.firstSeen)
+         .raw(",\"last\":").u32(d.lastSeen)
+         .raw(",\"count\":").i32(d.count)
+         .raw(",\"raven\":").boolean(d.isRaven)
+         .raw(",\"fw\":\"").json(d.ravenFW).ch('"');
+        if (d.hasGPS) {
+            w.raw(",\"gps\":{\"lat\":").fixed(d.gpsLat, 8)
+             .raw(",\"lon\":").fixed(d.gpsLon, 8)
+             .raw(",\"acc\":").fixed(d.gpsAcc, 1).ch('}');
+        }
+        w.ch('}');
+    }
+    return s.len;
+}
+
+static void randomRow(Row& d) {
+    static const char* methods[] = {"mac_prefix", "device_name", "manufacturer_id", "raven_uuid", "wifi_oui"};
+    static const char* names[] = {"", "FS Ext Battery", "Penguin-1234", "Flock-ABCD", "Pigvision"};
+    memset(&d, 0, sizeof(d));
+    snprintf(d.mac, sizeof(d.mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+             (unsigned)(rnd() & 0xff), (unsigned)(rnd() & 0xff), (unsigned)(rnd() & 0xff),
+             (unsigned)(rnd() & 0xff), (unsigned)(rnd() & 0xff), (unsigned)(rnd() & 0xff));
+    snprintf(d.name, sizeof(d.name), "%s", names[rnd() % 5]);
+    d.rssi = -30 - (int)(rnd() % 70);
+    snprintf(d.method, sizeof(d.method), "%s", methods[rnd() % 5]);
+    d.firstSeen = (unsigned long)(rnd() % 86400000UL);
+    d.lastSeen = d.firstSeen + (unsigned long)(rnd() % 3600000UL);
+    d.count = 1 + (int)(rnd() % 500);
+    d.isRaven = rnd() % 10 == 0;
+    if (d.isRaven) snprintf(d.ravenFW, sizeof(d.ravenFW), "1.3.%u", (unsigned)(rnd() % 10));
+    d.hasGPS = rnd() % 4 != 0;
+    d.gpsLat = uniform(-90, 90);
+    d.gpsLon = uniform(-180, 180);
+    d.gpsAcc = (float)uniform(1, 200);
+}
+
+int main(int argc, char** argv) {
+    unsigned long values = 2000000, rows = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-n")) values = strtoul(argv[i + 1], NULL, 10);
+        else if (!strcmp(argv[i], "-r")) rows = strtoul(argv[i + 1], NULL, 10);
+        else if (!strcmp(argv[i], "-s")) rngState = strtoull(argv[i + 1], NULL, 10) * 2654435761u + 1;
+        else {
+            fprintf(stderr, "usage: %s [-n values] [-r rows] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Edge cases: zeros, exact ties at every precision, values a multiply
+    // puts one ulp off a tie, carries into the integer part, the fast-path
+    // limit, and what only snprintf handles
+    static const double edges[] = {
+        0.0, -0.0, 0.5, -0.5, 1.5, 2.5, 0.125, 0.375, 1.005, 2.675, 0.045, 1.0000000050,
+        9.9999999995, 0.99999999999, -0.99999999999, 37.123456785, -122.123456785,
+        123456789.5, 999999999.99999999, 1e9, -1e9, 1e15, 1e-12, -1e-12, 5e-10,
+        4294967295.0, NAN, -NAN, INFINITY, -INFINITY};
+    unsigned long checked = 0;
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        for (int dec = 0; dec <= 9; dec++, checked++) checkFixed(edges[i], dec);
+    }
+    for (int k = 0; k < 1000; k++) {
+        // Binary-exact ties: k/2^m sits on a tie at m decimals
+        for (int m = 1; m <= 9; m++, checked++) checkFixed((k + 0.5) / (double)(1 << m), m);
+    }
+    for (unsigned long i = 0; i < values; i++, checked++) {
+        switch (i % 4) {
+            case 0: checkFixed(uniform(-90, 90), 8); break;                  // latitude
+            case 1: checkFixed(uniform(-180, 180), 8); break;                // longitude
+            case 2: checkFixed((float)uniform(0, 500), 1); break;            // accuracy (float)
+            default: checkFixed(uniform(-1e6, 1e6), (int)(rnd() % 10));      // anything else
+        }
+    }
+    static const long ints[] = {0, 1, -1, 9, 10, -10, 99, 100, 2147483647L, -2147483647L - 1};
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++, checked++) checkInt(ints[i]);
+    for (unsigned long i = 0; i < values / 4; i++, checked++) checkInt((long)(int32_t)rnd());
+
+    // Rows: same bytes both ways (names here need no escaping), then time
+    static Row table[1024];
+    for (size_t i = 0; i < 1024; i++) randomRow(table[i]);
+    char a[512], b[512];
+    for (size_t i = 0; i < 1024; i++) {
+        size_t na = rowPrintf(a, sizeof(a), table[i]), nb = rowWriter(b, sizeof(b), table[i]);
+        a[na] = b[nb] = '\0';
+        if (na != nb || memcmp(a, b, na)) report("row", a, b);
+    }
+    unsigned long sink = 0;
+    double t0 = nowMs();
+    for (unsigned long i = 0; i < rows; i++) sink += rowPrintf(a, sizeof(a), table[i & 1023]);
+    double t1 = nowMs();
+    for (unsigned long i = 0; i < rows; i++) sink += rowWriter(b, sizeof(b), table[i & 1023]);
+    double t2 = nowMs();
+
+    printf("{\"checked\":%lu,\"mismatches\":%lu,\"rows\":%lu,\"snprintf_ms\":%.1f,"
+           "\"fywriter_ms\":%.1f,\"bytes\":%lu}\n",
+           checked, mismatches, rows, t1 - t0, t2 - t1, sink / 2);
+    return mismatches ? 1 : 0;
+}
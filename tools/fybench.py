@@ -0,0 +1,225 @@
+"""
+Load / latency benchmark for the Flock-You web API.
+
+Drives concurrent clients against the data endpoints of a running unit
+(connect to the flockyou AP first) and reports client-side p50/p99 latency
+and bytes per response, plus the firmware's own view: fyMutex wait/hold per
+holder and BLE insert timeouts (/api/perf), response-pool peak memory and
+503 refusals (/api/resp). Results are written as JSON so runs can be diffed.
+
+Table sizes and the synthetic BLE producer need the bench build:
+
+    pio run -e xiao_esp32s3_bench -t upload
+    python tools/fybench.py --clients 1,4,8 -o bench.json
+    python tools/fybench.py --baseline bench.json     # exit 1 on p99 regression
+
+Against a normal build the table is left as-is and only the load runs.
+The bench build holds 2000 detections (MAX_DETECTIONS, table in PSRAM).
+Requested sizes above the firmware's capacity are filled to capacity;
+"filled" in the output says what was actually measured.
+
+Options:
+    --host H         unit address (default 192.168.4.1)
+    --sizes N,...    detection table sizes (default 200,1000,2000)
+    --clients N,...  concurrent client counts (default 1,4,8)
+    --duration S     seconds per run (default 10)
+    --rate R         synthetic inserts per second during runs (default 20)
+    -o FILE          write JSON here (default stdout)
+    --baseline FILE  compare p99 per endpoint against an earlier run
+    --tolerance F    allowed p99 growth before failing (default 0.25)
+"""
+import argparse
+import http.client
+import json
+import sys
+import threading
+import time
+
+ENDPOINTS = [
+    '/api/detections',
+    '/api/stats',
+    '/api/export/json',
+    '/api/export/csv',
+    '/api/export/kml',
+    '/api/export/bin',
+    '/api/history/kml',
+]
+
+
+def fetch(host, path, timeout):
+    """One request on a fresh connection -> (status, bytes, seconds)."""
+    t0 = time.perf_counter()
+    conn = http.client.HTTPConnection(host, 80, timeout=timeout)
+    try:
+        conn.request('GET', path, headers={'Connection': 'close'})
+        resp = conn.getresponse()
+        body = resp.read()
+        return resp.status, len(body), time.perf_counter() - t0
+    finally:
+        conn.close()
+
+
+def get_json(host, path, timeout):
+    conn = http.client.HTTPConnection(host, 80, timeout=timeout)
+    try:
+        conn.request('GET', path)
+        resp = conn.getresponse()
+        body = resp.read()
+        if resp.status != 200:
+            return None
+        return json.loads(body)
+    finally:
+        conn.close()
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return None
+    k = max(0, min(len(sorted_vals) - 1, int(round(p / 100.0 * len(sorted_vals) + 0.5)) - 1))
+    return sorted_vals[k]
+
+
+def run_load(host, endpoints, clients, duration, timeout):
+    samples = {ep: [] for ep in endpoints}
+    lock = threading.Lock()
+    stop = time.perf_counter() + duration
+
+    def client(idx):
+        i = idx
+        while time.perf_counter() < stop:
+            ep = endpoints[i % len(endpoints)]
+            i += 1
+            try:
+                status, nbytes, dt = fetch(host, ep, timeout)
+            except (OSError, http.client.HTTPException):
+                status, nbytes, dt = 0, 0, None
+            with lock:
+                samples[ep].append((status, nbytes, dt))
+            if status == 503:
+                time.sleep(0.05)    # Honour the spirit of Retry-After without stalling the run
+
+    threads = [threading.Thread(target=client, args=(c,), daemon=True) for c in range(clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    out = {}
+    for ep, rows in samples.items():
+        ok = [r for r in rows if r[0] == 200]
+        lat = sorted(r[2] * 1000.0 for r in ok)
+        out[ep] = {
+            'requests': len(rows),
+            'ok': len(ok),
+            'busy': sum(1 for r in rows if r[0] == 503),
+            'errors': sum(1 for r in rows if r[0] not in (200, 503)),
+            'p50_ms': round(percentile(lat, 50), 1) if lat else None,
+            'p99_ms': round(percentile(lat, 99), 1) if lat else None,
+            'max_ms': round(lat[-1], 1) if lat else None,
+            'bytes_avg': int(sum(r[1] for r in ok) / len(ok)) if ok else 0,
+        }
+    return out
+
+
+def compare(result, baseline, tolerance):
+    """Print p99 regressions; returns the number found."""
+    def index(doc):
+        return {(r['size'], r['clients'], ep): v['p99_ms']
+                for r in doc['runs'] for ep, v in r['endpoints'].items()}
+    old, new = index(baseline), index(result)
+    bad = 0
+    for key, p99 in sorted(new.items()):
+        ref = old.get(key)
+        if p99 is None or ref is None or ref <= 0:
+            continue
+        if p99 > ref * (1 + tolerance):
+            bad += 1
+            print(f'  REGRESSION size={key[0]} clients={key[1]} {key[2]}: '
+                  f'p99 {ref:.1f} -> {p99:.1f} ms', file=sys.stderr)
+    return bad
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Benchmark the Flock-You web API')
+    ap.add_argument('--host', default='192.168.4.1')
+    ap.add_argument('--sizes', default='200,1000,2000')
+    ap.add_argument('--clients', default='1,4,8')
+    ap.add_argument('--duration', type=float, default=10.0)
+    ap.add_argument('--rate', type=int, default=20)
+    ap.add_argument('--endpoints', default=','.join(ENDPOINTS))
+    ap.add_argument('--timeout', type=float, default=15.0)
+    ap.add_argument('-o', '--output')
+    ap.add_argument('--baseline')
+    ap.add_argument('--tolerance', type=float, default=0.25)
+    args = ap.parse_args()
+
+    host = args.host
+    sizes = [int(x) for x in args.sizes.split(',') if x]
+    client_counts = [int(x) for x in args.clients.split(',') if x]
+    endpoints = [e for e in args.endpoints.split(',') if e]
+
+    bench = get_json(host, '/api/bench', args.timeout) is not None
+    if not bench:
+        print('  no /api/bench (not a bench build): table size and producer are fixed',
+              file=sys.stderr)
+        sizes = sizes[:1]
+
+    result = {
+        'host': host,
+        'bench_build': bench,
+        'duration_s': args.duration,
+        'producer_rate': args.rate if bench else 0,
+        'started': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'runs': [],
+    }
+    try:
+        for size in sizes:
+            filled = None
+            if bench:
+                get_json(host, '/api/clear', args.timeout)
+                r = get_json(host, f'/api/bench?fill={size}', args.timeout)
+                filled = r['count'] if r else None
+            for clients in client_counts:
+                if bench:
+                    get_json(host, f'/api/bench?reset=1&rate={args.rate}', args.timeout)
+                print(f'  size {size} ({filled if filled is not None else "?"} rows), '
+                      f'{clients} clients, {args.duration:.0f} s ...', file=sys.stderr)
+                eps = run_load(host, endpoints, clients, args.duration, args.timeout)
+                if bench:
+                    get_json(host, '/api/bench?rate=0', args.timeout)
+                perf = get_json(host, '/api/perf', args.timeout)
+                result['runs'].append({
+                    'size': size,
+                    'filled': filled if filled is not None else (perf or {}).get('detections'),
+                    'clients': clients,
+                    'endpoints': eps,
+                    'device': {
+                        'perf': perf,
+                        'resp': get_json(host, '/api/resp', args.timeout),
+                    },
+                })
+    finally:
+        if bench:
+            try:
+                get_json(host, '/api/bench?rate=0', args.timeout)
+            except (OSError, http.client.HTTPException):
+                pass
+
+    text = json.dumps(result, indent=2)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text + '\n')
+        print(f'{args.output}: {len(result["runs"])} runs', file=sys.stderr)
+    else:
+        print(text)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            bad = compare(result, json.load(f), args.tolerance)
+        print(f'  {bad} p99 regressions vs {args.baseline}', file=sys.stderr)
+        return 1 if bad else 0
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
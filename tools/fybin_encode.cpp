@@ -0,0 +1,210 @@
+// ============================================================================
+// FLOCK-YOU: Host-side FYDB encoder (for api/fybin.py bench)
+// ============================================================================
+// Runs the firmware's FYBinEncoder (src/fy_binexport.h) over a fixture and
+// writes the .fyb to stdout, the same two passes FYBinGen makes in main.cpp.
+// api/fybin.py builds and runs this so its decoder is checked against the
+// C++ encoder, not only against its own reference encoder.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/fybin_encode.cpp -o fybin_encode
+//   ./fybin_encode < fixture > out.fyb
+//   ./fybin_encode -b [runs] < fixture     # FYDB vs JSON export timing
+//
+// -b times both exports over the same rows into memory: FYBinEncoder, and
+// FYWriter (src/fy_serialize.h) making the calls fyWriteDetJSON makes.
+// Presence fields are not in the fixture; they are written as a device
+// row that has left range would carry them. Prints one JSON line with
+// bytes and microseconds per export (best of 5 rounds of runs, default
+// 200).
+//
+// stdin: "U <uptime_ms>" on the first line, then one record per line,
+// tab-separated, strings hex-encoded UTF-8 (empty = ""):
+//
+//   mac name rssi method first last count raven fw gps lat lon acc
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "fy_binexport.h"
+#include "fy_serialize.h"
+
+// FYDetection's exported fields, same sizes as in main.cpp
+struct Det {
+    char mac[18];
+    char name[48];
+    int rssi;
+    char method[24];
+    unsigned long firstSeen;
+    unsigned long lastSeen;
+    int count;
+    bool isRaven;
+    char ravenFW[16];
+    double gpsLat;
+    double gpsLon;
+    float gpsAcc;
+    bool hasGPS;
+};
+
+struct StdoutSink {
+    size_t write(const uint8_t* p, size_t n) { return fwrite(p, 1, n, stdout); }
+};
+
+static FYBinEncoder<32000> enc;
+
+// Sink into a growable host buffer, reused across bench runs
+struct MemSink {
+    std::vector<uint8_t> buf;
+    size_t write(const uint8_t* p, size_t n) {
+        buf.insert(buf.end(), p, p + n);
+        return n;
+    }
+};
+
+static bool unhex(const char* s, char* out, size_t cap) {
+    size_t n = strlen(s);
+    if (n % 2 || n / 2 >= cap) return false;
+    for (size_t i = 0; i < n; i += 2) out[i / 2] = (char)((fybHexNibble(s[i]) << 4) | fybHexNibble(s[i + 1]));
+    out[n / 2] = '\0';
+    return true;
+}
+
+// Next tab-separated field (empty fields allowed); NULL at end of line
+static char* field(char*& p) {
+    if (!p) return NULL;
+    char* f = p;
+    char* t = strchr(p, '\t');
+    if (t) { *t = '\0'; p = t + 1; } else p = NULL;
+    return f;
+}
+
+template <typename Sink>
+static bool encodeFYDB(Sink& out, const std::vector<Det>& dets, unsigned long uptime) {
+    enc.reset();
+    for (size_t i = 0; i < dets.size(); i++) enc.intern(dets[i].method);
+    for (size_t i = 0; i < dets.size(); i++) {
+        enc.intern(dets[i].name);
+        enc.intern(dets[i].ravenFW);
+    }
+    enc.writeHeader(out, (uint32_t)uptime, (uint32_t)dets.size());
+    for (size_t i = 0; i < dets.size(); i++) {
+        if (!enc.writeRecord(out, dets[i])) {
+            fprintf(stderr, "fybin_encode: record %u method \"%s\" not in string table\n",
+                    (unsigned)i, dets[i].method);
+            return false;
+        }
+    }
+    return true;
+}
+
+// The /api/export/json body: same writer calls as fyWriteDetJSON
+template <typename Sink>
+static void encodeJSON(Sink& out, const std::vector<Det>& dets) {
+    FYWriter<Sink> w(out);
+    w.ch('[');
+    for (size_t i = 0; i < dets.size(); i++) {
+        const Det& d = dets[i];
+        if (i) w.ch(',');
+        w.raw("{\"mac\":\"").json(d.mac)
+         .raw("\",\"name\":\"").json(d.name)
+         .raw("\",\"rssi\":").i32(d.rssi)
+         .raw(",\"method\":\"").json(d.method)
+         .raw("\",\"first\":").u32(d.firstSeen)
+         .raw(",\"last\":").u32(d.lastSeen)
+         .raw(",\"count\":").i32(d.count)
+         .raw(",\"raven\":").boolean(d.isRaven)
+         .raw(",\"fw\":\"").json(d.ravenFW).ch('"');
+        w.raw(",\"pres\":\"").raw("gone")
+         .raw("\",\"visits\":").u32(1)
+         .raw(",\"dwell\":").u32(d.lastSeen - d.firstSeen);
+        if (d.hasGPS) {
+            w.raw(",\"gps\":{\"lat\":").fixed(d.gpsLat, 8)
+             .raw(",\"lon\":").fixed(d.gpsLon, 8)
+             .raw(",\"acc\":").fixed(d.gpsAcc, 1).ch('}');
+        }
+        w.ch('}');
+    }
+    w.ch(']');
+}
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int bench(const std::vector<Det>& dets, unsigned long uptime, int runs) {
+    MemSink fyb, js;
+    if (!encodeFYDB(fyb, dets, uptime)) return 1;
+    encodeJSON(js, dets);
+    size_t fybBytes = fyb.buf.size(), jsBytes = js.buf.size();
+    double bestFyb = 1e30, bestJs = 1e30;
+    for (int round = 0; round < 5; round++) {
+        double t0 = nowUs();
+        for (int i = 0; i < runs; i++) {
+            fyb.buf.clear();
+            encodeFYDB(fyb, dets, uptime);
+        }
+        double t1 = nowUs();
+        for (int i = 0; i < runs; i++) {
+            js.buf.clear();
+            encodeJSON(js, dets);
+        }
+        double t2 = nowUs();
+        if ((t1 - t0) / runs < bestFyb) bestFyb = (t1 - t0) / runs;
+        if ((t2 - t1) / runs < bestJs) bestJs = (t2 - t1) / runs;
+    }
+    printf("{\"records\":%u,\"runs\":%d,\"fydb_bytes\":%u,\"json_bytes\":%u,"
+           "\"fydb_encode_us\":%.1f,\"json_encode_us\":%.1f}\n",
+           (unsigned)dets.size(), runs, (unsigned)fybBytes, (unsigned)jsBytes, bestFyb, bestJs);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int runs = 0;
+    if (argc >= 2 && !strcmp(argv[1], "-b")) runs = argc >= 3 ? atoi(argv[2]) : 200;
+    if (argc >= 2 && (strcmp(argv[1], "-b") || runs <= 0)) {
+        fprintf(stderr, "usage: %s [-b [runs]] < fixture\n", argv[0]);
+        return 2;
+    }
+    static char line[1024];
+    unsigned long uptime = 0;
+    std::vector<Det> dets;
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), stdin)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == 'U' && line[1] == ' ') { uptime = strtoul(line + 2, NULL, 10); continue; }
+        if (!line[0]) continue;
+        Det d;
+        memset(&d, 0, sizeof(d));
+        char* p = line;
+        char* f[13];
+        int n = 0;
+        while (n < 13 && (f[n] = field(p)) != NULL) n++;
+        if (n != 13 || strlen(f[0]) >= sizeof(d.mac) ||
+            !unhex(f[1], d.name, sizeof(d.name)) || !unhex(f[3], d.method, sizeof(d.method)) ||
+            !unhex(f[8], d.ravenFW, sizeof(d.ravenFW))) {
+            fprintf(stderr, "fybin_encode: bad fixture line %d\n", lineNo);
+            return 2;
+        }
+        strcpy(d.mac, f[0]);
+        d.rssi = atoi(f[2]);
+        d.firstSeen = strtoul(f[4], NULL, 10);
+        d.lastSeen = strtoul(f[5], NULL, 10);
+        d.count = atoi(f[6]);
+        d.isRaven = atoi(f[7]) != 0;
+        d.hasGPS = atoi(f[9]) != 0;
+        d.gpsLat = strtod(f[10], NULL);
+        d.gpsLon = strtod(f[11], NULL);
+        d.gpsAcc = (float)strtod(f[12], NULL);
+        dets.push_back(d);
+    }
+
+    if (runs) return bench(dets, uptime, runs);
+    StdoutSink out;
+    return encodeFYDB(out, dets, uptime) ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+"""
+Compile the datasets/ CSVs into the Flock-You offline camera index (FYCI).
+
+The image layout is documented in src/fy_camindex.h. Flash it to the
+"camidx" partition (see partitions.csv):
+
+    python tools/mkcamindex.py -o camindex.bin
+    esptool.py --chip esp32s3 write_flash 0x510000 camindex.bin
+
+Options:
+    -o FILE        output image (default camindex.bin)
+    --level N      quad-tile level, 1..16 (default 12, ~5 km tiles)
+    --query S,W,N,E  run a bounding-box query against the built image
+    --check        build tools/camindex_check.cpp with the host C++ compiler
+                   ($CXX, default g++) and check FYCamIndex::query on the
+                   image against brute force (and the --query box, if any)
+    CSV ...        inputs (default: every known CSV in datasets/)
+"""
+import argparse
+import csv
+import glob
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+MAGIC = b'FYCI'
+VERSION = 1
+NO_LABEL = 0xFFFFFFFF
+PARTITION_SIZE = 0x100000
+MAX_LABEL = 47
+
+# Must match enum FYCamSource in src/fy_camindex.h
+SOURCES = ['city_cam', 'flock_cam', 'fs_battery', 'flock_wifi']
+
+HEADER = struct.Struct('<4sHBBIIIIII')
+TILE = struct.Struct('<III')
+POINT = struct.Struct('<iiIB3x')
+
+
+def quant(v, lo, span):
+    u = (v - lo) / span
+    if u <= 0:
+        return 0
+    if u >= 1:
+        return 0xFFFFFFFF
+    return int(u * 4294967296.0)
+
+
+def spread(v):
+    x = v & 0xFFFFFFFF
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFF
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FF
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0F
+    x = (x | (x << 2)) & 0x3333333333333333
+    x = (x | (x << 1)) & 0x5555555555555555
+    return x
+
+
+def tile_key(lat, lon, level):
+    shift = 32 - level
+    tx = quant(lon, -180.0, 360.0) >> shift
+    ty = quant(lat, -90.0, 180.0) >> shift
+    return (spread(tx) << 1) | spread(ty)
+
+
+def _clip(s):
+    s = ' '.join((s or '').split())
+    return s.encode('utf-8')[:MAX_LABEL].decode('utf-8', errors='ignore')
+
+
+def _num(v):
+    try:
+        return float(str(v).strip())
+    except ValueError:
+        return None
+
+
+def read_points(path):
+    """Yield (lat, lon, source, label) from one dataset CSV, by its columns"""
+    with open(path, newline='', encoding='utf-8-sig') as f:
+        reader = csv.DictReader(f)
+        cols = reader.fieldnames or []
+        for row in reader:
+            if 'trilat' in cols:
+                # WiGLE exports: FS Ext Battery (BLE) or Flock-XXXXXX (Wi-Fi)
+                lat, lon = _num(row['trilat']), _num(row['trilong'])
+                ssid = row.get('ssid') or ''
+                wifi = row.get('type') in ('infra', 'tods') or ssid.lower().startswith('flock')
+                src = 3 if wifi else 2
+                label = f"{ssid} {row.get('netid', '')}" if wifi else row.get('netid', '')
+            elif 'coordinates' in cols:
+                # Pigvision: "lat, lon" in one column
+                parts = (row['coordinates'] or '').split(',')
+                if len(parts) != 2:
+                    continue
+                lat, lon = _num(parts[0]), _num(parts[1])
+                src = 1
+                label = row.get('info/comments', '')
+            elif 'latitude' in cols and 'longitude' in cols:
+                lat, lon = _num(row['latitude']), _num(row['longitude'])
+                src = 0
+                label = f"{row.get('type', '')} {row.get('note b', '')}"
+            else:
+                print(f'  skipping {path}: unrecognised columns', file=sys.stderr)
+                return
+            if lat is None or lon is None or not (-90 <= lat <= 90) or not (-180 <= lon <= 180):
+                continue
+            yield lat, lon, src, _clip(label)
+
+
+def build(paths, level):
+    points = []
+    for p in paths:
+        n0 = len(points)
+        points.extend(read_points(p))
+        print(f'  {os.path.basename(p)}: {len(points) - n0} points')
+
+    # Deduplicate identical (position, source) rows, then group by tile
+    seen = set()
+    uniq = []
+    for lat, lon, src, label in points:
+        k = (round(lat * 1e7), round(lon * 1e7), src)
+        if k not in seen:
+            seen.add(k)
+            uniq.append((tile_key(lat, lon, level), k[0], k[1], src, label))
+    uniq.sort()
+
+    labels = bytearray()
+    label_off = {}
+    tiles = []
+    packed = bytearray()
+    for i, (key, lat7, lon7, src, label) in enumerate(uniq):
+        if not tiles or tiles[-1][0] != key:
+            tiles.append([key, i, 0])
+        tiles[-1][2] += 1
+        off = NO_LABEL
+        if label:
+            if label not in label_off:
+                label_off[label] = len(labels)
+                labels += label.encode('utf-8') + b'\0'
+            off = label_off[label]
+        packed += POINT.pack(lat7, lon7, off, src)
+
+    tiles_off = HEADER.size
+    points_off = tiles_off + TILE.size * len(tiles)
+    labels_off = points_off + len(packed)
+    total = labels_off + len(labels)
+    out = bytearray(HEADER.pack(MAGIC, VERSION, level, len(SOURCES), len(tiles), len(uniq),
+                                tiles_off, points_off, labels_off, total))
+    for key, first, count in tiles:
+        out += TILE.pack(key, first, count)
+    out += packed
+    out += labels
+    return bytes(out), len(points), len(uniq), len(tiles)
+
+
+def query(image, south, west, north, east):
+    """Host-side reference for FYCamIndex::query (brute-force tile filter)"""
+    magic, version, level, _, ntiles, npoints, toff, poff, loff, total = HEADER.unpack_from(image)
+    s7, n7, w7, e7 = (int(x * 1e7) for x in (south, north, west, east))
+    out = []
+    for i in range(npoints):
+        lat7, lon7, lab, src = POINT.unpack_from(image, poff + i * POINT.size)
+        if s7 <= lat7 <= n7 and w7 <= lon7 <= e7:
+            label = ''
+            if lab != NO_LABEL:
+                end = image.index(b'\0', loff + lab)
+                label = image[loff + lab:end].decode('utf-8', errors='replace')
+            out.append((lat7 / 1e7, lon7 / 1e7, SOURCES[src], label))
+    return out
+
+
+def check(image_path, box, here):
+    """Run tools/camindex_check.cpp on the image; None if no host compiler"""
+    cxx = os.environ.get('CXX', 'g++')
+    if not shutil.which(cxx):
+        return None
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, 'camindex_check')
+        subprocess.run([cxx, '-std=gnu++11', '-O2', '-Wall', '-Wextra',
+                        '-I', os.path.join(here, '..', 'src'),
+                        os.path.join(here, 'camindex_check.cpp'), '-o', exe], check=True)
+        cmd = [exe, image_path] + (['-q', box] if box else [])
+        run = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True)
+        return run.returncode, run.stdout.strip().splitlines()[-1]
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description='Build the FYCI offline camera index')
+    ap.add_argument('csv', nargs='*')
+    ap.add_argument('-o', '--output', default='camindex.bin')
+    ap.add_argument('--level', type=int, default=12)
+    ap.add_argument('--query')
+    ap.add_argument('--check', action='store_true')
+    args = ap.parse_args()
+    if not 1 <= args.level <= 16:
+        ap.error('--level must be 1..16')
+
+    paths = args.csv or sorted(glob.glob(os.path.join(here, '..', 'datasets', '*.csv')))
+    t0 = time.perf_counter()
+    image, raw, kept, ntiles = build(paths, args.level)
+    dt = time.perf_counter() - t0
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+    print(f'{args.output}: {kept} points ({raw - kept} duplicates dropped), '
+          f'{ntiles} tiles at level {args.level}')
+    print(f'  image {len(image)} bytes ({len(image) / PARTITION_SIZE:.1%} of camidx partition), '
+          f'built in {dt * 1000:.1f} ms')
+    if len(image) > PARTITION_SIZE:
+        print('  ERROR: image does not fit the camidx partition', file=sys.stderr)
+        return 1
+
+    if args.query:
+        s, w, n, e = (float(x) for x in args.query.split(','))
+        hits = query(image, s, w, n, e)
+        print(f'  query -> {len(hits)} points')
+        for h in hits[:20]:
+            print(f'    {h[0]:.7f},{h[1]:.7f} {h[2]} {h[3]}')
+
+    if args.check:
+        result = check(args.output, args.query, here)
+        if result is None:
+            print('  check skipped: no host C++ compiler')
+        else:
+            rc, summary = result
+            print(f'  FYCamIndex::query vs brute force: {summary}')
+            if rc:
+                return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
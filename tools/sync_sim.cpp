@@ -0,0 +1,432 @@
+// ============================================================================
+// FLOCK-YOU: Convoy sync simulator (host)
+// ============================================================================
+// Runs several FYSyncNode instances (src/fy_sync.h) in one process over a
+// simulated broadcast medium with per-receiver packet loss, and reports how
+// long the tables take to converge after the last sighting and how many
+// bytes that cost on the wire.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/sync_sim.cpp -o sync_sim
+//   ./sync_sim                 # every scenario
+//   ./sync_sim hub -l 0.3      # one scenario, 30% loss
+//
+// Scenarios:
+//   mesh    3 units on one segment, 900 sightings of 60 devices over 10 min
+//   hub     4 units: followers hear only the lead (station links to its AP)
+//   full    mesh where one unit's table holds 20 of the 60 devices: the rest
+//           still converge, and idle traffic stays at summaries only
+//   late    a unit that joins after 5 min gets the whole history
+//   laws    fySyncMerge commutative/associative/idempotent, codec round
+//           trip, over random records
+//
+// Options: -l <loss 0..1> (default 0), -s <seed> (default 1)
+// Exit code 1 if a scenario fails to converge or a law check fails.
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "fy_sync.h"
+
+#define SIM_STEP_MS      10
+#define SIM_LATENCY_MS   5
+#define SIM_DEVICES      60
+#define SIM_SIGHTINGS    900
+#define SIM_MINUTES      10
+#define SIM_IDLE_MS      60000
+#define SIM_TIMEOUT_MS   120000
+#define SIM_MTU          1200
+
+static uint32_t rngState = 1;
+static uint32_t rnd() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+static double rndUnit() { return (rnd() & 0xFFFFFF) / (double)0x1000000; }
+
+struct Sim;
+
+struct Packet {
+    uint32_t at;
+    int node;
+    uint8_t link;
+    std::vector<uint8_t> data;
+};
+
+struct SimLink : public FYSyncLink {
+    Sim* sim;
+    int node;
+    std::vector<int> hears;     // Nodes that receive what this link sends
+    const char* name() const { return "sim"; }
+    size_t mtu() const { return SIM_MTU; }
+    bool send(const uint8_t* buf, size_t len);
+};
+
+struct Unit {
+    FYSyncNode node;
+    std::vector<FYSyncRec> mem;
+    SimLink link;
+    int32_t skew;               // Boot time difference: localMs = now + skew
+    bool up;
+};
+
+struct Sim {
+    std::vector<Unit*> units;
+    std::vector<Packet> air;
+    uint32_t now;
+    double loss;
+    unsigned long wireBytes;
+
+    Sim() : now(0), loss(0), wireBytes(0) {}
+    ~Sim() { for (size_t i = 0; i < units.size(); i++) delete units[i]; }
+
+    Unit* add(size_t cap, int32_t skew) {
+        Unit* u = new Unit;
+        u->mem.resize(cap);
+        u->node.init(rnd() | 1, &u->mem[0], cap);
+        u->link.sim = this;
+        u->link.node = (int)units.size();
+        u->skew = skew;
+        u->up = true;
+        u->node.addLink(&u->link);
+        units.push_back(u);
+        return u;
+    }
+
+    uint32_t local(const Unit* u) const { return now + (uint32_t)u->skew; }
+
+    void broadcast(int from, const uint8_t* buf, size_t len) {
+        wireBytes += len;
+        const std::vector<int>& to = units[from]->link.hears;
+        for (size_t i = 0; i < to.size(); i++) {
+            if (rndUnit() < loss) continue;
+            Packet p;
+            p.at = now + SIM_LATENCY_MS;
+            p.node = to[i];
+            p.link = 0;
+            p.data.assign(buf, buf + len);
+            air.push_back(p);
+        }
+    }
+
+    void step() {
+        now += SIM_STEP_MS;
+        std::vector<Packet> due;
+        for (size_t i = 0; i < air.size();) {
+            if (air[i].at <= now) {
+                due.push_back(air[i]);
+                air[i] = air.back();
+                air.pop_back();
+            } else {
+                i++;
+            }
+        }
+        for (size_t i = 0; i < due.size(); i++) {
+            Unit* u = units[due[i].node];
+            if (!u->up) continue;
+            u->node.receive(due[i].link, &due[i].data[0], due[i].data.size(), local(u),
+                            [](const FYSyncRec&) {});
+            u->node.flush(local(u));
+        }
+        for (size_t i = 0; i < units.size(); i++) {
+            Unit* u = units[i];
+            if (!u->up) continue;
+            u->node.tick(local(u));
+            u->node.flush(local(u));
+        }
+    }
+
+    void sight(Unit* u, int device) {
+        FYSyncSighting s;
+        memset(&s, 0, sizeof(s));
+        s.mac[0] = 0x58; s.mac[1] = 0x8e; s.mac[2] = 0x81;
+        s.mac[3] = 0; s.mac[4] = (uint8_t)(device >> 8); s.mac[5] = (uint8_t)device;
+        s.rssi = (int8_t)(-40 - (int)(rnd() % 50));
+        s.method = (uint8_t)(rnd() % 6);
+        s.raven = s.method == 3;
+        s.name = rnd() % 4 ? "" : "FS Ext Battery";
+        s.fw = s.raven ? "1.3.x" : "";
+        s.gps = rnd() % 2;
+        s.gpsLocalMs = local(u);
+        s.latE7 = 377749000 + (int32_t)(rnd() % 10000);
+        s.lonE7 = -1224194000 + (int32_t)(rnd() % 10000);
+        s.accDm = (uint16_t)(rnd() % 500);
+        u->node.observe(s, local(u));
+    }
+};
+
+bool SimLink::send(const uint8_t* buf, size_t len) {
+    sim->broadcast(node, buf, len);
+    return true;
+}
+
+// ============================================================================
+// CONVERGENCE
+// ============================================================================
+
+static bool sameRec(const FYSyncRec& a, const FYSyncRec& b) {
+    if (a.firstSeen != b.firstSeen || a.lastSeen != b.lastSeen || a.metaTs != b.metaTs ||
+        a.metaNode != b.metaNode || a.rssi != b.rssi || a.method != b.method ||
+        a.flags != b.flags || strcmp(a.name, b.name) || strcmp(a.fw, b.fw) ||
+        a.origins != b.origins) return false;
+    if ((a.flags & FY_SYNC_R_GPS) &&
+        (a.gpsTs != b.gpsTs || a.gpsNode != b.gpsNode || a.latE7 != b.latE7 ||
+         a.lonE7 != b.lonE7 || a.accDm != b.accDm)) return false;
+    for (uint8_t i = 0; i < a.origins; i++) {
+        const FYSyncOrigin* o = b.origin(a.org[i].node);
+        if (!o || o->count != a.org[i].count || o->dot != a.org[i].dot) return false;
+    }
+    return true;
+}
+
+// Every unit in `which` holds the same table
+static bool converged(const Sim& sim, const std::vector<int>& which) {
+    const FYSyncNode& ref = sim.units[which[0]]->node;
+    for (size_t k = 1; k < which.size(); k++) {
+        const FYSyncNode& n = sim.units[which[k]]->node;
+        if (n.size() != ref.size()) return false;
+        for (size_t i = 0; i < ref.size(); i++) {
+            const FYSyncRec* r = n.find(ref.at(i).mac);
+            if (!r || !sameRec(*r, ref.at(i))) return false;
+        }
+    }
+    return true;
+}
+
+struct Result {
+    bool ok;
+    uint32_t convergeMs;
+    unsigned long bytes;        // Until convergence
+    double idleBps;
+};
+
+// Sightings spread over SIM_MINUTES by the units in `seers`, then run until
+// `which` converge; then SIM_IDLE_MS of idle traffic
+static Result run(Sim& sim, const std::vector<int>& seers, const std::vector<int>& which,
+                  int lateUnit = -1, uint32_t lateAtMs = 0) {
+    Result res;
+    memset(&res, 0, sizeof(res));
+    uint32_t span = SIM_MINUTES * 60000;
+    std::vector<uint32_t> at(SIM_SIGHTINGS);
+    for (size_t i = 0; i < at.size(); i++) at[i] = rnd() % span;
+    std::sort(at.begin(), at.end());
+    size_t next = 0;
+    uint32_t lastSighting = at.back();
+    if (lateUnit >= 0) sim.units[lateUnit]->up = false;
+
+    while (sim.now < lastSighting + SIM_TIMEOUT_MS) {
+        if (lateUnit >= 0 && !sim.units[lateUnit]->up && sim.now >= lateAtMs) {
+            sim.units[lateUnit]->up = true;
+        }
+        while (next < at.size() && at[next] <= sim.now) {
+            Unit* u = sim.units[seers[rnd() % seers.size()]];
+            if (u->up) sim.sight(u, (int)(rnd() % SIM_DEVICES));
+            next++;
+        }
+        sim.step();
+        if (next >= at.size() && converged(sim, which)) {
+            res.ok = true;
+            res.convergeMs = sim.now - lastSighting;
+            break;
+        }
+    }
+    res.bytes = sim.wireBytes;
+    unsigned long before = sim.wireBytes;
+    uint32_t idleFrom = sim.now;
+    while (sim.now < idleFrom + SIM_IDLE_MS) sim.step();
+    res.idleBps = (sim.wireBytes - before) * 1000.0 / SIM_IDLE_MS;
+    return res;
+}
+
+static void connectAll(Sim& sim) {
+    for (size_t i = 0; i < sim.units.size(); i++) {
+        for (size_t j = 0; j < sim.units.size(); j++) {
+            if (i != j) sim.units[i]->link.hears.push_back((int)j);
+        }
+    }
+}
+
+static bool report(const char* name, const Sim& sim, const Result& r) {
+    if (!r.ok) {
+        printf("%-5s loss %2.0f%%  DID NOT CONVERGE within %u s\n", name, sim.loss * 100,
+               SIM_TIMEOUT_MS / 1000);
+        return false;
+    }
+    printf("%-5s loss %2.0f%%  converged %5.2f s after the last sighting, "
+           "%6.0f B/sighting, idle %5.0f B/s\n", name, sim.loss * 100, r.convergeMs / 1000.0,
+           (double)r.bytes / SIM_SIGHTINGS, r.idleBps);
+    return true;
+}
+
+static bool scenarioMesh(double loss) {
+    Sim sim;
+    sim.loss = loss;
+    for (int i = 0; i < 3; i++) sim.add(SIM_DEVICES, (int32_t)(rnd() % 5000));
+    connectAll(sim);
+    std::vector<int> all;
+    for (int i = 0; i < 3; i++) all.push_back(i);
+    return report("mesh", sim, run(sim, all, all));
+}
+
+static bool scenarioHub(double loss) {
+    Sim sim;
+    sim.loss = loss;
+    for (int i = 0; i < 4; i++) sim.add(SIM_DEVICES, (int32_t)(rnd() % 5000));
+    for (int i = 1; i < 4; i++) {
+        sim.units[0]->link.hears.push_back(i);
+        sim.units[i]->link.hears.push_back(0);
+    }
+    std::vector<int> all;
+    for (int i = 0; i < 4; i++) all.push_back(i);
+    return report("hub", sim, run(sim, all, all));
+}
+
+static bool scenarioFull(double loss) {
+    Sim sim;
+    sim.loss = loss;
+    sim.add(SIM_DEVICES, 0);
+    sim.add(SIM_DEVICES, 1000);
+    Unit* small = sim.add(SIM_DEVICES / 3, 2000);
+    connectAll(sim);
+    std::vector<int> seers, big;
+    for (int i = 0; i < 3; i++) seers.push_back(i);
+    big.push_back(0);
+    big.push_back(1);
+    bool ok = report("full", sim, run(sim, seers, big));
+    const FYSyncStats& st = small->node.stats();
+    printf("      small unit: %u/%u records, %u refused, %u lossy writers, %u batches merged\n",
+           (unsigned)small->node.size(), (unsigned)small->node.capacity(), (unsigned)st.full,
+           (unsigned)small->node.lossy().n, (unsigned)st.batches);
+    return ok;
+}
+
+static bool scenarioLate(double loss) {
+    Sim sim;
+    sim.loss = loss;
+    for (int i = 0; i < 3; i++) sim.add(SIM_DEVICES, (int32_t)(rnd() % 5000));
+    connectAll(sim);
+    std::vector<int> all, seers;
+    for (int i = 0; i < 3; i++) all.push_back(i);
+    seers.push_back(0);
+    seers.push_back(1);
+    return report("late", sim, run(sim, seers, all, 2, SIM_MINUTES * 60000 / 2));
+}
+
+// ============================================================================
+// LAWS
+// ============================================================================
+
+static void randomRec(FYSyncRec& r, const uint32_t* nodes) {
+    uint8_t mac[6] = {0x58, 0x8e, 0x81, 0, 0, 1};
+    r.reset(mac);
+    r.firstSeen = rnd() % 100000;
+    r.lastSeen = r.firstSeen + rnd() % 100000;
+    r.metaTs = r.firstSeen + rnd() % 1000;
+    r.metaNode = nodes[rnd() % 4];
+    r.rssi = (int8_t)(-(int)(rnd() % 100));
+    r.method = (uint8_t)(rnd() % 6);
+    r.flags = (uint8_t)(rnd() % 4);
+    snprintf(r.name, sizeof(r.name), "n%u", (unsigned)(rnd() % 3));
+    snprintf(r.fw, sizeof(r.fw), "f%u", (unsigned)(rnd() % 3));
+    if (r.flags & FY_SYNC_R_GPS) {
+        r.gpsTs = rnd() % 1000;
+        r.gpsNode = nodes[rnd() % 4];
+        r.latE7 = (int32_t)rnd();
+        r.lonE7 = (int32_t)rnd();
+        r.accDm = (uint16_t)rnd();
+    }
+    r.origins = (uint8_t)(1 + rnd() % 4);
+    for (uint8_t i = 0; i < r.origins; i++) {
+        r.org[i].node = nodes[i];
+        r.org[i].count = rnd() % 50;
+        r.org[i].dot = rnd() % 50;
+    }
+}
+
+// Merge results are compared as sets, so meta ties (same ts and node) with
+// different payloads are avoided: a node writes one payload per timestamp
+static void fixTies(FYSyncRec& a, const FYSyncRec& b) {
+    if (a.metaTs == b.metaTs && a.metaNode == b.metaNode) {
+        a.rssi = b.rssi; a.method = b.method;
+        a.flags = (uint8_t)((a.flags & ~FY_SYNC_R_RAVEN) | (b.flags & FY_SYNC_R_RAVEN));
+        memcpy(a.name, b.name, sizeof(a.name)); memcpy(a.fw, b.fw, sizeof(a.fw));
+    }
+    if ((a.flags & b.flags & FY_SYNC_R_GPS) && a.gpsTs == b.gpsTs && a.gpsNode == b.gpsNode) {
+        a.latE7 = b.latE7; a.lonE7 = b.lonE7; a.accDm = b.accDm;
+    }
+}
+
+static bool scenarioLaws() {
+    const uint32_t nodes[4] = {11, 22, 33, 44};
+    static uint8_t buf[FY_SYNC_MTU_MAX];
+    unsigned fails = 0;
+    const int rounds = 20000;
+    for (int t = 0; t < rounds; t++) {
+        FYSyncRec a, b, c;
+        randomRec(a, nodes); randomRec(b, nodes); randomRec(c, nodes);
+        fixTies(b, a); fixTies(c, a); fixTies(c, b);
+        // Per-node counters only grow and a node's dot orders its writes:
+        // give each node one history so the replicas are consistent
+        for (uint8_t i = 0; i < 4; i++) {
+            FYSyncOrigin* o[3] = {a.origin(nodes[i]), b.origin(nodes[i]), c.origin(nodes[i])};
+            for (int k = 0; k < 3; k++) if (o[k]) o[k]->count = o[k]->dot;
+        }
+
+        FYSyncRec ab = a, ba = b, abc1, abc2 = b, aa = a;
+        fySyncMerge(ab, b);
+        fySyncMerge(ba, a);
+        if (!sameRec(ab, ba)) fails++;
+        abc1 = ab;
+        fySyncMerge(abc1, c);
+        fySyncMerge(abc2, c);
+        FYSyncRec a_bc = a;
+        fySyncMerge(a_bc, abc2);
+        if (!sameRec(abc1, a_bc)) fails++;
+        if (fySyncMerge(aa, a) != FY_SYNC_SAME || !sameRec(aa, a)) fails++;
+
+        FYSyncWriter w(buf, sizeof(buf));
+        uint32_t clock = rnd();
+        fySyncPutRec(w, a, clock);
+        FYSyncReader rd(buf, w.len);
+        FYSyncRec back;
+        if (w.over || !fySyncGetRec(rd, back, clock) || !sameRec(back, a)) fails++;
+        // Truncated input must be rejected, never read past the end
+        FYSyncReader cut(buf, w.len / 2);
+        if (fySyncGetRec(cut, back, clock)) fails++;
+    }
+    printf("laws  %d random triples: %u failures\n", rounds, fails);
+    return fails == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* only = NULL;
+    double loss = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-l") && i + 1 < argc) loss = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) rngState = (uint32_t)strtoul(argv[++i], NULL, 10) * 2654435761u + 1;
+        else only = argv[i];
+    }
+    struct { const char* name; bool (*fn)(double); } lossy[] = {
+        {"mesh", scenarioMesh}, {"hub", scenarioHub}, {"full", scenarioFull}, {"late", scenarioLate},
+    };
+    bool ok = true, ran = false;
+    for (size_t i = 0; i < sizeof(lossy) / sizeof(lossy[0]); i++) {
+        if (only && strcmp(only, lossy[i].name)) continue;
+        ok = lossy[i].fn(loss) && ok;
+        ran = true;
+    }
+    if (!only || !strcmp(only, "laws")) {
+        ok = scenarioLaws() && ok;
+        ran = true;
+    }
+    if (!ran) {
+        fprintf(stderr, "unknown scenario %s\n", only);
+        return 2;
+    }
+    return ok ? 0 : 1;
+}
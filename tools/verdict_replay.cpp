@@ -0,0 +1,133 @@
+// ============================================================================
+// FLOCK-YOU: Verdict cache replay (host)
+// ============================================================================
+// Replays an advert trace through FYVerdictCache (src/fy_verdict.h) exactly
+// as onResult drives it: lookup first, full pipeline on a miss, insert on a
+// negative verdict. Reports hit rate, invalidations and host cost per
+// lookup, so the figures behind /api/cache can be reproduced off-device.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/verdict_replay.cpp -o verdict_replay
+//   python tools/mkadvtrace.py | ./verdict_replay          # synthetic dense trace
+//   ./verdict_replay capture.trace                          # recorded on a unit
+//
+// Trace: one advert per line, as printed by a -DFY_ADV_TRACE build:
+//
+//   ADV <ms> <address, 12 hex> <n|t> <payload hex>
+//
+// n/t is the pipeline's verdict (non-target / target). Other lines (the
+// rest of the serial log) are skipped.
+//
+// Options: -b <buckets> (power of two, default 256), -t <ttl s> (default 60)
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fy_verdict.h"
+
+#define MAX_BUCKETS 4096
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int unhex(const char* s, uint8_t* out, size_t cap) {
+    size_t n = 0;
+    while (s[0] && s[1] && n < cap) {
+        int hi = hexNibble(s[0]), lo = hexNibble(s[1]);
+        if (hi < 0 || lo < 0) break;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+        s += 2;
+    }
+    return (int)n;
+}
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct Counts {
+    unsigned long adverts, hits, misses, invalidations, targets, falseHits, skipped;
+    double lookupNs, insertNs;
+};
+
+template <size_t B>
+static int replay(FILE* in, uint16_t ttl) {
+    static FYVerdictCache<B> cache(ttl);
+    Counts c;
+    memset(&c, 0, sizeof(c));
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        unsigned long ms;
+        char addrHex[16], verdict, payloadHex[200];
+        if (sscanf(line, "ADV %lu %15s %c %199s", &ms, addrHex, &verdict, payloadHex) != 4) {
+            if (!strncmp(line, "ADV ", 4)) c.skipped++;
+            continue;
+        }
+        uint8_t addr[6], payload[100];
+        if (unhex(addrHex, addr, 6) != 6) { c.skipped++; continue; }
+        int plen = unhex(payloadHex, payload, sizeof(payload));
+        uint16_t nowSec = (uint16_t)(ms / 1000);
+        c.adverts++;
+
+        double t0 = nowNs();
+        uint32_t h = fyVerdictHash(payload, (size_t)plen);
+        bool hit = cache.lookup(addr, h, nowSec);
+        c.lookupNs += nowNs() - t0;
+        if (hit) {
+            c.hits++;
+            if (verdict == 't') c.falseHits++;   // A target must never be short-circuited
+            continue;
+        }
+        c.misses++;
+        if (verdict == 't') {
+            c.targets++;
+            continue;
+        }
+        t0 = nowNs();
+        if (cache.insert(addr, h, nowSec)) c.invalidations++;
+        c.insertNs += nowNs() - t0;
+    }
+    printf("{\"buckets\":%u,\"capacity\":%u,\"ttl_s\":%u,\"adverts\":%lu,\"hits\":%lu,"
+           "\"hit_rate\":%.4f,\"misses\":%lu,\"invalidations\":%lu,\"targets\":%lu,"
+           "\"false_hits\":%lu,\"skipped_lines\":%lu,\"host_lookup_ns\":%.1f,\"host_insert_ns\":%.1f}\n",
+           (unsigned)B, (unsigned)(B * FY_VERDICT_WAYS), ttl, c.adverts, c.hits,
+           c.adverts ? (double)c.hits / c.adverts : 0.0, c.misses, c.invalidations, c.targets,
+           c.falseHits, c.skipped, c.adverts ? c.lookupNs / c.adverts : 0.0,
+           c.misses > c.targets ? c.insertNs / (c.misses - c.targets) : 0.0);
+    return c.falseHits ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    unsigned buckets = 256, ttl = 60;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc) buckets = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) ttl = (unsigned)atoi(argv[++i]);
+        else path = argv[i];
+    }
+    FILE* in = path ? fopen(path, "r") : stdin;
+    if (!in) {
+        perror(path);
+        return 2;
+    }
+    switch (buckets) {
+    case 64:   return replay<64>(in, (uint16_t)ttl);
+    case 128:  return replay<128>(in, (uint16_t)ttl);
+    case 256:  return replay<256>(in, (uint16_t)ttl);
+    case 512:  return replay<512>(in, (uint16_t)ttl);
+    case 1024: return replay<1024>(in, (uint16_t)ttl);
+    case 2048: return replay<2048>(in, (uint16_t)ttl);
+    case MAX_BUCKETS: return replay<MAX_BUCKETS>(in, (uint16_t)ttl);
+    default:
+        fprintf(stderr, "buckets must be a power of two, 64..%d\n", MAX_BUCKETS);
+        return 2;
+    }
+}
@@ -0,0 +1,188 @@
+// ============================================================================
+// FLOCK-YOU: Wi-Fi frame matcher replay (host)
+// ============================================================================
+// Runs frames through fyWifiMatch() (src/fy_wifi_frames.h), the same call
+// the promiscuous RX callback makes on the device.
+//
+//   g++ -std=gnu++11 -O2 -I src tools/wifi_replay.cpp -o wifi_replay
+//   ./wifi_replay tools/wifi_frames.txt          # sample frames, checked
+//   ./wifi_replay tools/wifi_frames.txt cap.pcap # tally a capture
+//
+// The text file sets the OUI table and SSID prefix and lists frames with
+// their expected verdict (format in tools/wifi_frames.txt); a mismatch is
+// printed and the exit code is 1. A pcap (raw 802.11 or radiotap link type,
+// e.g. from Wireshark in monitor mode) is replayed with that table and only
+// tallied, since it carries no expectations.
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "fy_wifi_frames.h"
+
+#define LINKTYPE_IEEE802_11          105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+
+static std::vector<uint32_t> ouis;
+static char prefix[33] = "";
+
+static const char* reasonName(uint8_t r) {
+    return r == FY_WIFI_MATCH_OUI ? "oui" : r == FY_WIFI_MATCH_SSID ? "ssid" : "none";
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static size_t unhex(const char* s, uint8_t* out, size_t cap) {
+    size_t n = 0;
+    while (s[0] && s[1] && n < cap) {
+        int hi = hexNibble(s[0]), lo = hexNibble(s[1]);
+        if (hi < 0 || lo < 0) break;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+        s += 2;
+    }
+    return n;
+}
+
+static void addOUI(uint32_t oui) {
+    std::vector<uint32_t>::iterator it = ouis.begin();
+    while (it != ouis.end() && *it < oui) ++it;
+    if (it == ouis.end() || *it != oui) ouis.insert(it, oui);
+}
+
+static int replayText(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+    char line[2048];
+    int lineNo = 0, frames = 0, failed = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        char kind[16], mac[32], hex[1800];
+        int n = sscanf(line, "%15s %31s %1799s", kind, mac, hex);
+        if (n <= 0) continue;
+        unsigned a, b, c;
+        if (!strcmp(kind, "OUI") && n >= 2 && sscanf(mac, "%02x:%02x:%02x", &a, &b, &c) == 3) {
+            addOUI((a << 16) | (b << 8) | c);
+            continue;
+        }
+        if (!strcmp(kind, "PREFIX") && n >= 2) {
+            snprintf(prefix, sizeof(prefix), "%s", mac);
+            continue;
+        }
+        if (n != 3 || (strcmp(kind, "none") && strcmp(kind, "oui") && strcmp(kind, "ssid"))) {
+            fprintf(stderr, "%s:%d: bad line\n", path, lineNo);
+            fclose(f);
+            return 2;
+        }
+
+        uint8_t frame[900];
+        size_t len = unhex(hex, frame, sizeof(frame));
+        FYWifiHit hit;
+        memset(&hit, 0, sizeof(hit));
+        uint8_t r = fyWifiMatch(frame, len, ouis.data(), ouis.size(), prefix, &hit);
+        char got[13] = "-";
+        if (r != FY_WIFI_MATCH_NONE) {
+            snprintf(got, sizeof(got), "%02x%02x%02x%02x%02x%02x",
+                     hit.mac[0], hit.mac[1], hit.mac[2], hit.mac[3], hit.mac[4], hit.mac[5]);
+        }
+        frames++;
+        if (strcmp(kind, reasonName(r)) || strcmp(mac, got)) {
+            printf("FAIL %s:%d: expected %s %s, got %s %s\n", path, lineNo, kind, mac,
+                   reasonName(r), got);
+            failed++;
+        } else {
+            printf("ok   %s:%d: %s %s%s%s\n", path, lineNo, reasonName(r), got,
+                   hit.ssidLen ? " ssid=" : "", hit.ssid);
+        }
+    }
+    fclose(f);
+    printf("%d frames, %d failed (%u OUIs, prefix \"%s\")\n", frames, failed,
+           (unsigned)ouis.size(), prefix);
+    return failed ? 1 : 0;
+}
+
+static uint32_t rd32(const uint8_t* p, bool swap) {
+    return swap ? ((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3])
+                : ((uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0]);
+}
+
+static int replayPcap(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+    uint8_t gh[24];
+    if (fread(gh, 1, sizeof(gh), f) != sizeof(gh)) {
+        fprintf(stderr, "%s: not a pcap file\n", path);
+        fclose(f);
+        return 2;
+    }
+    uint32_t magic = rd32(gh, false);
+    bool swap = magic == 0xd4c3b2a1;
+    if (!swap && magic != 0xa1b2c3d4) {
+        fprintf(stderr, "%s: not a classic pcap file (pcapng is not supported)\n", path);
+        fclose(f);
+        return 2;
+    }
+    uint32_t link = rd32(gh + 20, swap);
+    if (link != LINKTYPE_IEEE802_11 && link != LINKTYPE_IEEE802_11_RADIOTAP) {
+        fprintf(stderr, "%s: link type %u is not 802.11\n", path, (unsigned)link);
+        fclose(f);
+        return 2;
+    }
+
+    unsigned long frames = 0, counts[3] = {0, 0, 0};
+    static uint8_t buf[65536];
+    uint8_t ph[16];
+    while (fread(ph, 1, sizeof(ph), f) == sizeof(ph)) {
+        uint32_t caplen = rd32(ph + 8, swap);
+        if (caplen > sizeof(buf) || fread(buf, 1, caplen, f) != caplen) break;
+        const uint8_t* frame = buf;
+        size_t len = caplen;
+        if (link == LINKTYPE_IEEE802_11_RADIOTAP) {
+            // Radiotap length is little-endian regardless of the file's byte order
+            size_t rt = len >= 4 ? (size_t)(buf[2] | buf[3] << 8) : len;
+            if (rt > len) continue;
+            frame += rt;
+            len -= rt;
+        }
+        FYWifiHit hit;
+        memset(&hit, 0, sizeof(hit));
+        uint8_t r = fyWifiMatch(frame, len, ouis.data(), ouis.size(), prefix, &hit);
+        frames++;
+        counts[r]++;
+        if (r != FY_WIFI_MATCH_NONE) {
+            printf("#%lu %s %02x:%02x:%02x:%02x:%02x:%02x %s\n", frames, reasonName(r),
+                   hit.mac[0], hit.mac[1], hit.mac[2], hit.mac[3], hit.mac[4], hit.mac[5],
+                   hit.ssid);
+        }
+    }
+    fclose(f);
+    printf("%s: %lu frames, %lu oui, %lu ssid, %lu none\n", path, frames,
+           counts[FY_WIFI_MATCH_OUI], counts[FY_WIFI_MATCH_SSID], counts[FY_WIFI_MATCH_NONE]);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <frames.txt> [capture.pcap ...]\n", argv[0]);
+        return 2;
+    }
+    int rc = replayText(argv[1]);
+    for (int i = 2; i < argc && rc != 2; i++) {
+        int prc = replayPcap(argv[i]);
+        if (prc) rc = prc;
+    }
+    return rc;
+}